@@ -69,6 +69,8 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     connect(&statusWidget, &StatusWidget::audibilityChanged, this, &MainWindow::UpdateMute);
 
     new QShortcut(QKeySequence(Qt::ControlModifier | Qt::Key_G), this, [this]() { JumpSong(); });
+    new QShortcut(QKeySequence(Qt::ControlModifier | Qt::Key_Left), this, [this]() { SeekRelative(-10.0); });
+    new QShortcut(QKeySequence(Qt::ControlModifier | Qt::Key_Right), this, [this]() { SeekRelative(10.0); });
 
     setWindowTitle("agbplay");
     setWindowIcon(QIcon(":/icons/main-logo.ico"));
@@ -325,6 +327,8 @@ void MainWindow::SetupWidgets()
 void MainWindow::SetupStatusBar()
 {
     statusBar()->showMessage("No game loaded");
+    statusBar()->addPermanentWidget(&playbackStatsLabel);
+    playbackStatsLabel.setToolTip("Audio underruns and ringbuffer fill level / target level in samples");
     statusBar()->addPermanentWidget(&progressBar);
     progressBar.setMaximumHeight(16);
     progressBar.setMinimumHeight(16);
@@ -377,6 +381,7 @@ void MainWindow::Stop()
     }
 
     playbackEngine->Stop();
+    playbackEngine->LogPlaybackStats();
     playing = false;
 
     if (playlistFocus)
@@ -497,6 +502,14 @@ void MainWindow::SpeedDouble()
     playbackEngine->SpeedDouble();
 }
 
+void MainWindow::SeekRelative(double seconds)
+{
+    if (!playbackEngine || !playing)
+        return;
+
+    playbackEngine->SeekRelative(seconds);
+}
+
 void MainWindow::PlaylistAdd()
 {
     QList<QListWidgetItem *> items = songlistWidget.listWidget.selectedItems();
@@ -995,6 +1008,12 @@ void MainWindow::StatusUpdate()
     );
     statusWidget.setVisualizerState(*visualizerState);
 
+    const PlaybackStats stats = playbackEngine->GetPlaybackStats();
+    playbackStatsLabel.setText(QString("Underruns: %1  Buffer: %2/%3")
+                                   .arg(stats.ringbuffer.underruns + stats.ringbuffer.partialTakes)
+                                   .arg(stats.ringbuffer.fillLevel)
+                                   .arg(stats.ringbuffer.targetLevel));
+
     if (playing && playbackEngine->SongEnded()) {
         /* AdvanceSong automatically stops if this was the last song in the list. */
         AdvanceSong(1);
@@ -8,6 +8,7 @@
 #include <atomic>
 #include <filesystem>
 #include <memory>
+#include <QLabel>
 #include <QListView>
 #include <QMainWindow>
 #include <QProgressBar>
@@ -51,6 +52,7 @@ private:
     void LoadSong(const std::string &title, uint16_t id);
     void SpeedHalve();
     void SpeedDouble();
+    void SeekRelative(double seconds);
 
     void PlaylistAdd();
     void PlaylistRemove();
@@ -134,6 +136,7 @@ private:
     QTextEdit logWidget{&containerRight};
 
     /* status bar */
+    QLabel playbackStatsLabel;
     QProgressBar progressBar;
 
     /* MP2K Objects */
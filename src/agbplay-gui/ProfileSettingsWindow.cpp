@@ -482,6 +482,58 @@ void ProfileSettingsWindow::InitEnhancements()
     });
 
     connect(ui->checkBoxPsgSus, &QCheckBox::checkStateChanged, [this](int) { MarkPending(); });
+
+    /* native mix rate */
+    ui->checkBoxNativeMix->setCheckState(profile->agbplaySoundMode.nativeMixRate ? Qt::Checked : Qt::Unchecked);
+
+    static const QString nativeMixToolTip = "Mix PCM channels at the game's mixing rate like real GBA hardware does, including reverb.\n"
+        "Each track is then resampled only once to the output rate, which is faster for tracks that play many PCM channels at once.\n"
+        "The PCM resampler settings above are not used in this mode.";
+
+    ui->checkBoxNativeMix->setToolTip(nativeMixToolTip);
+
+    connect(ui->pushButtonNativeMix, &QPushButton::clicked, [this](bool){
+        ui->checkBoxNativeMix->setCheckState(Qt::Unchecked);
+        MarkPending();
+    });
+
+    connect(ui->checkBoxNativeMix, &QCheckBox::checkStateChanged, [this](int) { MarkPending(); });
+
+    /* shared reverb */
+    ui->checkBoxSharedRev->setCheckState(profile->agbplaySoundMode.sharedReverb ? Qt::Checked : Qt::Unchecked);
+
+    static const QString sharedRevToolTip = "Use a single reverb for all tracks of a player like the sound engine does, instead of one reverb per track.\n"
+        "This is faster, but muting a track does not mute the reverb of notes it already played.\n"
+        "Exports of separate tracks always use one reverb per track.";
+
+    ui->checkBoxSharedRev->setToolTip(sharedRevToolTip);
+
+    connect(ui->pushButtonSharedRev, &QPushButton::clicked, [this](bool){
+        ui->checkBoxSharedRev->setCheckState(Qt::Unchecked);
+        MarkPending();
+    });
+
+    connect(ui->checkBoxSharedRev, &QCheckBox::checkStateChanged, [this](int) { MarkPending(); });
+
+    /* resampler polyphase filter bank */
+    ui->comboBoxResPolyphase->clear();
+    ui->comboBoxResPolyphase->addItem("Off", static_cast<int>(ResamplerPolyphase::OFF));
+    ui->comboBoxResPolyphase->addItem("Nearest phase (fast)", static_cast<int>(ResamplerPolyphase::NEAREST));
+    ui->comboBoxResPolyphase->addItem("Interpolated phase", static_cast<int>(ResamplerPolyphase::LINEAR));
+    ui->comboBoxResPolyphase->setCurrentIndex(static_cast<int>(profile->agbplaySoundMode.resamplerPolyphase));
+
+    static const QString resPolyphaseToolTip = "Precalculate the filter kernels of the Sinc, Blep and Blamp resamplers for a fixed number of phases.\n"
+        "This makes them a lot faster, but the output differs slightly.\n"
+        "Interpolating between the two nearest phases is more accurate than using the nearest one.";
+
+    ui->comboBoxResPolyphase->setToolTip(resPolyphaseToolTip);
+
+    connect(ui->pushButtonResPolyphase, &QPushButton::clicked, [this](bool){
+        ui->comboBoxResPolyphase->setCurrentIndex(static_cast<int>(ResamplerPolyphase::OFF));
+        MarkPending();
+    });
+
+    connect(ui->comboBoxResPolyphase, &QComboBox::currentIndexChanged, [this](int) { MarkPending(); });
 }
 
 void ProfileSettingsWindow::InitGameTables()
@@ -798,12 +850,15 @@ void ProfileSettingsWindow::Apply()
     /* enhancements */
     profile->agbplaySoundMode.resamplerTypeNormal = static_cast<ResamplerType>(ui->comboBoxResTypeNormal->currentData().toInt());
     profile->agbplaySoundMode.resamplerTypeFixed = static_cast<ResamplerType>(ui->comboBoxResTypeFixed->currentData().toInt());
+    profile->agbplaySoundMode.resamplerPolyphase = static_cast<ResamplerPolyphase>(ui->comboBoxResPolyphase->currentData().toInt());
     profile->agbplaySoundMode.reverbType = static_cast<ReverbType>(ui->comboBoxRevAlgo->currentData().toInt());
     profile->agbplaySoundMode.cgbPolyphony = static_cast<CGBPolyphony>(ui->comboBoxPsgPoly->currentData().toInt());
     profile->agbplaySoundMode.dmaBufferLen = static_cast<uint32_t>(ui->spinBoxDmaBufLen->value());
     profile->agbplaySoundMode.accurateCh3Quantization = ui->checkBoxCh3Quant->checkState() == Qt::Checked;
     profile->agbplaySoundMode.accurateCh3Volume = ui->checkBoxCh3Vol->checkState() == Qt::Checked;
     profile->agbplaySoundMode.emulateCgbSustainBug = ui->checkBoxPsgSus->checkState() == Qt::Checked;
+    profile->agbplaySoundMode.nativeMixRate = ui->checkBoxNativeMix->checkState() == Qt::Checked;
+    profile->agbplaySoundMode.sharedReverb = ui->checkBoxSharedRev->checkState() == Qt::Checked;
 
     /* game tables (song table and player table) */
     if (ui->checkBoxSongTable->checkState() == Qt::Checked) {
@@ -0,0 +1,369 @@
+#include "Constants.hpp"
+#include "Debug.hpp"
+#include "MP2KContext.hpp"
+#include "MP2KScanner.hpp"
+#include "ProfileManager.hpp"
+#include "Rom.hpp"
+#include "Settings.hpp"
+#include "SoundExporter.hpp"
+#include "Xcept.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fmt/core.h>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+/* agbplay-render is a headless frontend to SoundExporter.
+ * It does not need an audio device or a terminal and is intended to be used
+ * for batch exports and for comparing rendering throughput between builds. */
+
+struct RenderArgs
+{
+    std::filesystem::path romPath;
+    std::filesystem::path outputDirectory;
+    std::optional<size_t> profileIdx;
+    std::optional<size_t> tableIdx;
+    std::vector<std::pair<uint16_t, uint16_t>> songRanges;
+    std::optional<uint32_t> sampleRate;
+    std::optional<uint32_t> bitDepth;
+    std::optional<uint32_t> threads;
+    std::optional<ResamplerPolyphase> polyphase;
+    bool benchmarkOnly = false;
+    bool separate = false;
+    bool segmented = false;
+    bool listProfiles = false;
+    bool analyze = false;
+};
+
+static void usage();
+static void help();
+static RenderArgs parseArgs(int argc, char *argv[]);
+static unsigned long parseNumber(const std::string &option, const std::string &value);
+static std::vector<std::pair<uint16_t, uint16_t>> parseSongRanges(const std::string &value);
+static void printProfiles(const std::vector<std::shared_ptr<Profile>> &profileCandidates);
+static void analyzeSongs(const Settings &settings, const Profile &profile);
+
+int main(int argc, char *argv[])
+{
+    if (!Debug::open(nullptr)) {
+        std::cerr << "Debug Init failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (argc < 2) {
+        usage();
+        return EXIT_FAILURE;
+    }
+    if (!strcmp("--help", argv[1]) || !strcmp("-h", argv[1])) {
+        help();
+        return EXIT_SUCCESS;
+    }
+
+    try {
+        const RenderArgs args = parseArgs(argc, argv);
+
+        Settings settings;
+        settings.Load();
+
+        if (args.sampleRate)
+            settings.exportSampleRate = *args.sampleRate;
+        if (args.bitDepth)
+            settings.exportBitDepth = *args.bitDepth;
+        if (args.threads)
+            settings.exportThreads = *args.threads;
+        if (args.segmented)
+            settings.exportSegmented = true;
+
+        fmt::print("Loading ROM...\n");
+        Rom::CreateInstance(args.romPath);
+
+        fmt::print("Loading Profiles...\n");
+        ProfileManager pm;
+        pm.LoadProfiles();
+
+        fmt::print("Scanning for MP2K Engine\n");
+        MP2KScanner scanner(Rom::Instance());
+        auto scanResults = scanner.Scan();
+        fmt::print(" -> Found {} instance(s)\n", scanResults.size());
+
+        auto profileCandidates = pm.GetProfiles(Rom::Instance(), scanResults);
+        if (args.listProfiles) {
+            printProfiles(profileCandidates);
+            Debug::close();
+            return EXIT_SUCCESS;
+        }
+
+        /* Select profile either by index into the candidate list or by song table index.
+         * Without either option the first candidate is used, same as the GUI does with a single match. */
+        std::shared_ptr<Profile> selectedProfile;
+        if (args.profileIdx) {
+            if (*args.profileIdx >= profileCandidates.size())
+                throw Xcept(
+                    "Profile index {} out of range, {} profile(s) available",
+                    *args.profileIdx,
+                    profileCandidates.size()
+                );
+            selectedProfile = profileCandidates.at(*args.profileIdx);
+        } else if (args.tableIdx) {
+            for (const std::shared_ptr<Profile> &p : profileCandidates) {
+                if (p->songTableInfoConfig.tableIdx == *args.tableIdx) {
+                    selectedProfile = p;
+                    break;
+                }
+            }
+            if (!selectedProfile)
+                throw Xcept("No profile found for song table index {}", *args.tableIdx);
+        } else {
+            if (profileCandidates.size() == 0)
+                throw Xcept("No profile available for ROM");
+            if (profileCandidates.size() > 1)
+                fmt::print(
+                    "Found {} matching profiles, using the first one (see --list-profiles)\n",
+                    profileCandidates.size()
+                );
+            selectedProfile = profileCandidates.at(0);
+        }
+
+        /* Make a copy of the selected profile so we do not modify the loaded profiles. */
+        Profile profileToExport = *selectedProfile;
+        if (args.polyphase)
+            profileToExport.agbplaySoundMode.resamplerPolyphase = *args.polyphase;
+        const uint16_t songCount = profileToExport.songTableInfoPlayback.count;
+
+        if (args.songRanges.size() > 0) {
+            /* Songs that are in the playlist keep their names, all others are named like in the songlist. */
+            std::vector<Profile::PlaylistEntry> playlist;
+            for (const auto &[first, last] : args.songRanges) {
+                for (uint32_t id = first; id <= last; id++) {
+                    if (id >= songCount)
+                        throw Xcept("Song {} out of range, song table contains {} song(s)", id, songCount);
+
+                    std::string name = fmt::format("{:04}", id);
+                    for (const Profile::PlaylistEntry &entry : selectedProfile->playlist) {
+                        if (entry.id == id) {
+                            name = entry.name;
+                            break;
+                        }
+                    }
+                    playlist.emplace_back(Profile::PlaylistEntry{name, static_cast<uint16_t>(id)});
+                }
+            }
+            profileToExport.playlist = std::move(playlist);
+        } else if (profileToExport.playlist.size() == 0) {
+            for (uint16_t id = 0; id < songCount; id++)
+                profileToExport.playlist.emplace_back(Profile::PlaylistEntry{fmt::format("{:04}", id), id});
+        }
+
+        if (args.analyze) {
+            analyzeSongs(settings, profileToExport);
+            Debug::close();
+            return EXIT_SUCCESS;
+        }
+
+        std::filesystem::path directory = args.outputDirectory;
+        if (directory.empty() && !args.benchmarkOnly)
+            directory = settings.exportQuickExportDirectory;
+
+        fmt::print(
+            "Rendering {} song(s) at {} Hz, {} bit{}\n",
+            profileToExport.playlist.size(),
+            settings.exportSampleRate,
+            settings.exportBitDepth,
+            args.benchmarkOnly ? " (benchmark only)" : ""
+        );
+
+        SoundExporter se(directory, settings, profileToExport, args.benchmarkOnly, args.separate);
+        se.Export();
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    Debug::close();
+    return EXIT_SUCCESS;
+}
+
+static void usage()
+{
+    std::cout << "Usage: ./agbplay-render [options] <ROM.gba>" << std::endl;
+}
+
+static void help()
+{
+    usage();
+    std::cout << "\nOptions:\n"
+                 "  -o, --output <dir>       Directory to export to (default: quick export directory)\n"
+                 "  -p, --profile <n>        Use the n-th matching profile (see --list-profiles)\n"
+                 "  -t, --table <n>          Use the profile for song table index n\n"
+                 "  -s, --songs <ranges>     Songs to render, e.g. \"0-10,15,20-25\"\n"
+                 "                           (default: profile playlist or all songs if empty)\n"
+                 "  -r, --rate <hz>          Sample rate\n"
+                 "  -b, --bits <16|24|32>    Bit depth, 32 bit exports as float\n"
+                 "  -j, --threads <n>        Number of export threads (0 = all hardware threads)\n"
+                 "      --separate           Export each track to a separate file\n"
+                 "      --polyphase <mode>   Resampler filter bank: off, nearest or linear (default: profile)\n"
+                 "      --segmented          Split songs into segments if there are fewer songs than threads\n"
+                 "                           (reverb tails at segment boundaries may differ slightly)\n"
+                 "      --benchmark          Render without writing any files\n"
+                 "      --list-profiles      List matching profiles and exit\n"
+                 "      --analyze            Print length and loop count of each song without rendering\n"
+                 "  -h, --help               Show this help\n"
+                 "\nSettings not specified are taken from the agbplay configuration.\n"
+              << std::flush;
+}
+
+static RenderArgs parseArgs(int argc, char *argv[])
+{
+    RenderArgs args;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+
+        auto value = [&]() {
+            if (i + 1 >= argc)
+                throw Xcept("Option {} requires a value", arg);
+            return std::string(argv[++i]);
+        };
+
+        if (arg == "-o" || arg == "--output") {
+            args.outputDirectory = reinterpret_cast<const char8_t *>(value().c_str());
+        } else if (arg == "-p" || arg == "--profile") {
+            args.profileIdx = parseNumber(arg, value());
+        } else if (arg == "-t" || arg == "--table") {
+            args.tableIdx = parseNumber(arg, value());
+        } else if (arg == "-s" || arg == "--songs") {
+            const auto ranges = parseSongRanges(value());
+            args.songRanges.insert(args.songRanges.end(), ranges.begin(), ranges.end());
+        } else if (arg == "-r" || arg == "--rate") {
+            const unsigned long rate = parseNumber(arg, value());
+            if (rate == 0 || rate > std::numeric_limits<uint32_t>::max())
+                throw Xcept("Invalid sample rate: {}", rate);
+            args.sampleRate = static_cast<uint32_t>(rate);
+        } else if (arg == "-b" || arg == "--bits") {
+            const unsigned long bits = parseNumber(arg, value());
+            if (bits != 16 && bits != 24 && bits != 32)
+                throw Xcept("Invalid bit depth: {}, must be 16, 24, or 32", bits);
+            args.bitDepth = static_cast<uint32_t>(bits);
+        } else if (arg == "-j" || arg == "--threads") {
+            args.threads = static_cast<uint32_t>(std::min<unsigned long>(parseNumber(arg, value()), 1024));
+        } else if (arg == "--separate") {
+            args.separate = true;
+        } else if (arg == "--polyphase") {
+            const std::string mode = value();
+            if (mode != "off" && mode != "nearest" && mode != "linear")
+                throw Xcept("Invalid polyphase mode: {}, must be off, nearest, or linear", mode);
+            args.polyphase = str2polyphase(mode);
+        } else if (arg == "--segmented") {
+            args.segmented = true;
+        } else if (arg == "--benchmark") {
+            args.benchmarkOnly = true;
+        } else if (arg == "--list-profiles") {
+            args.listProfiles = true;
+        } else if (arg == "--analyze") {
+            args.analyze = true;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            throw Xcept("Unknown option: {}", arg);
+        } else if (args.romPath.empty()) {
+            args.romPath = reinterpret_cast<const char8_t *>(arg.c_str());
+        } else {
+            throw Xcept("Unexpected argument: {}", arg);
+        }
+    }
+
+    if (args.romPath.empty())
+        throw Xcept("No ROM specified");
+    if (args.profileIdx && args.tableIdx)
+        throw Xcept("Options --profile and --table cannot be used together");
+
+    return args;
+}
+
+static unsigned long parseNumber(const std::string &option, const std::string &value)
+{
+    try {
+        size_t parsed = 0;
+        const unsigned long number = std::stoul(value, &parsed, 0);
+        if (parsed == value.size())
+            return number;
+    } catch (...) {
+    }
+    throw Xcept("Invalid number for option {}: {}", option, value);
+}
+
+static std::vector<std::pair<uint16_t, uint16_t>> parseSongRanges(const std::string &value)
+{
+    std::vector<std::pair<uint16_t, uint16_t>> ranges;
+
+    size_t start = 0;
+    while (start <= value.size()) {
+        size_t end = value.find(',', start);
+        if (end == std::string::npos)
+            end = value.size();
+
+        const std::string range = value.substr(start, end - start);
+        const size_t dash = range.find('-');
+        unsigned long first, last;
+        if (dash == std::string::npos) {
+            first = last = parseNumber("--songs", range);
+        } else {
+            first = parseNumber("--songs", range.substr(0, dash));
+            last = parseNumber("--songs", range.substr(dash + 1));
+        }
+
+        if (first > last || last > std::numeric_limits<uint16_t>::max())
+            throw Xcept("Invalid song range: {}", range);
+
+        ranges.emplace_back(static_cast<uint16_t>(first), static_cast<uint16_t>(last));
+        start = end + 1;
+    }
+
+    return ranges;
+}
+
+static void printProfiles(const std::vector<std::shared_ptr<Profile>> &profileCandidates)
+{
+    for (size_t i = 0; i < profileCandidates.size(); i++) {
+        const Profile &p = *profileCandidates.at(i);
+        std::string d = p.description;
+        if (d.size() == 0)
+            d = "<no description>";
+        fmt::print(" [{}]:\n  file: {}\n  description: {}\n", i, p.path.string(), d);
+        if (p.songTableInfoConfig.pos != SongTableInfo::POS_AUTO)
+            fmt::print("  tablePos=0x{:X}\n", p.songTableInfoConfig.pos);
+        else
+            fmt::print("  tableIdx={}\n", p.songTableInfoConfig.tableIdx);
+        fmt::print("  song count: {}\n  playlist entries: {}\n", p.songTableInfoPlayback.count, p.playlist.size());
+    }
+}
+
+static void analyzeSongs(const Settings &settings, const Profile &profile)
+{
+    MP2KContext ctx(
+        settings.exportSampleRate,
+        Rom::Instance(),
+        profile.mp2kSoundModePlayback,
+        profile.agbplaySoundMode,
+        profile.songTableInfoPlayback,
+        profile.playerTablePlayback
+    );
+
+    /* Songs which loop endlessly are cut off after one hour. */
+    const size_t maxSubframes = 60 * 60 * AGB_FPS * INTERFRAMES;
+    const double subframesPerSecond = AGB_FPS * INTERFRAMES;
+
+    fmt::print("{:>5} {:>10} {:>10} {:>6}  {}\n", "song", "end", "length", "loops", "name");
+    for (const Profile::PlaylistEntry &entry : profile.playlist) {
+        const SongAnalysis analysis = ctx.AnalyzeSong(entry.id, maxSubframes);
+        fmt::print(
+            "{:>5} {:>9.2f}s {:>9.2f}s {:>6}  {}{}\n",
+            entry.id,
+            static_cast<double>(analysis.endSubframe) / subframesPerSecond,
+            static_cast<double>(analysis.totalSubframes) / subframesPerSecond,
+            analysis.numLoops,
+            entry.name,
+            analysis.ended ? "" : " (did not end)"
+        );
+    }
+}
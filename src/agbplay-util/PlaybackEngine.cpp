@@ -4,6 +4,7 @@
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
+#include <string>
 #include <thread>
 
 #if __has_include(<pa_win_wasapi.h>)
@@ -50,6 +51,25 @@ const std::vector<PaHostApiTypeId> PlaybackEngine::hostApiPriority = {
     paSoundManager,
 };
 
+/* Reads the info of a song from the ROM like m4aSongNumStart and MP2KPlayer::Init do. */
+static SongInfo readSongInfo(const Rom &rom, const SongTableInfo &songTableInfo, uint16_t songIdx)
+{
+    SongInfo songInfo{};
+    if (songIdx >= songTableInfo.count)
+        return songInfo;
+
+    const size_t tablePos = songTableInfo.pos + songIdx * 8;
+    songInfo.songHeaderPos = (rom.ReadU32(tablePos) != 0) ? rom.ReadAgbPtrToPos(tablePos) : 0;
+    songInfo.playerIdx = rom.ReadU8(tablePos + 4);
+    if (songInfo.songHeaderPos != 0) {
+        songInfo.priority = rom.ReadU8(songInfo.songHeaderPos + 2);
+        songInfo.reverb = rom.ReadU8(songInfo.songHeaderPos + 3);
+        if (rom.ValidPointer(rom.ReadU32(songInfo.songHeaderPos + 4)))
+            songInfo.voiceTablePos = rom.ReadAgbPtrToPos(songInfo.songHeaderPos + 4);
+    }
+    return songInfo;
+}
+
 /*
  * public PlaybackEngine
  */
@@ -66,6 +86,16 @@ PlaybackEngine::PlaybackEngine(uint32_t sampleRate, const Profile &profile) : pr
     );
     ctx->m4aSongNumStart(0);
     ctx->m4aSongNumStop(0);
+    checkpoints = std::make_unique<SongCheckpoints>(
+        sampleRate, Rom::Instance(), profile.songTableInfoPlayback, profile.playerTablePlayback
+    );
+
+    /* Size all visualizer states for the players and tracks of this context, so that publishing them
+     * on the mixer thread does not allocate. */
+    MP2KVisualizerState initialVisualizerState;
+    ctx->GetVisualizerState(initialVisualizerState);
+    visualizerStates.Reset(initialVisualizerState);
+
     portaudioOpen();
     playerThread = std::make_unique<std::thread>(&PlaybackEngine::threadWorker, this);
 #ifdef __linux__
@@ -87,8 +117,13 @@ PlaybackEngine::~PlaybackEngine()
 void PlaybackEngine::LoadSong(uint16_t songIdx)
 {
     trackMuted.reset();
+    this->songIdx = songIdx;
+    songStarted = false;
+    songPaused = false;
+    recordCheckpoints();
 
-    auto func = [this, songIdx]() {
+    const auto commandTime = std::chrono::steady_clock::now();
+    auto func = [this, songIdx, commandTime]() {
         const uint8_t playerIdx = ctx->primaryPlayer;
         if (playerIdx >= ctx->players.size())
             return;
@@ -97,6 +132,9 @@ void PlaybackEngine::LoadSong(uint16_t songIdx)
         ctx->m4aSongNumStart(songIdx);
         ctx->m4aMPlayStop(ctx->primaryPlayer);
         paused = false;
+        pendingSeek.reset();
+        songPosition = 0.0;
+        ringbuffer.MarkCommand(commandTime);
     };
 
     InvokeAsPlayer(func);
@@ -104,12 +142,17 @@ void PlaybackEngine::LoadSong(uint16_t songIdx)
 
 void PlaybackEngine::Play()
 {
-    auto func = [this]() {
+    const bool resume = songPaused;
+    songStarted = true;
+    songPaused = false;
+
+    const auto commandTime = std::chrono::steady_clock::now();
+    auto func = [this, commandTime, resume, trackMuted = trackMuted]() {
         const uint8_t playerIdx = ctx->primaryPlayer;
         if (playerIdx >= ctx->players.size())
             return;
 
-        if (paused) {
+        if (resume) {
             paused = false;
         } else {
             MP2KPlayer &player = ctx->players.at(playerIdx);
@@ -117,7 +160,10 @@ void PlaybackEngine::Play()
             for (size_t i = 0; i < std::min(player.tracks.size(), trackMuted.size()); i++)
                 player.tracks.at(i).muted = trackMuted[i];
             songEnded = false;
+            pendingSeek.reset();
+            songPosition = 0.0;
         }
+        ringbuffer.MarkCommand(commandTime);
     };
 
     InvokeAsPlayer(func);
@@ -125,33 +171,24 @@ void PlaybackEngine::Play()
 
 bool PlaybackEngine::Pause()
 {
-    auto func = [this]() {
-        const uint8_t playerIdx = ctx->primaryPlayer;
-        if (playerIdx >= ctx->players.size())
-            return;
+    /* A song which has ended or was never started is started again. */
+    if (!songStarted || SongEnded()) {
+        Play();
+        return true;
+    }
 
-        const bool playing = ctx->m4aMPlayIsPlaying(playerIdx);
-        if (playing) {
-            paused = !paused;
-        } else {
-            MP2KPlayer &player = ctx->players.at(playerIdx);
-            ctx->m4aMPlayStart(playerIdx, ctx->players.at(playerIdx).songHeaderPos);
-            for (size_t i = 0; i < std::min(player.tracks.size(), trackMuted.size()); i++)
-                player.tracks.at(i).muted = trackMuted[i];
-            songEnded = false;
-            paused = false;
-        }
-        // paused = !paused;
-    };
+    songPaused = !songPaused;
+    auto func = [this, songPaused = songPaused]() { paused = songPaused; };
 
     InvokeAsPlayer(func);
-
-    /* Return true if the player was paused an is now playing again. False otherwise. */
-    return !paused;
+    return !songPaused;
 }
 
 void PlaybackEngine::Stop()
 {
+    songStarted = false;
+    songPaused = false;
+
     auto func = [this]() {
         const uint8_t playerIdx = ctx->primaryPlayer;
         if (playerIdx >= ctx->players.size())
@@ -162,6 +199,8 @@ void PlaybackEngine::Stop()
         ctx->m4aMPlayStop(playerIdx);
         songEnded = false;
         paused = false;
+        pendingSeek.reset();
+        songPosition = 0.0;
     };
 
     InvokeAsPlayer(func);
@@ -173,7 +212,7 @@ void PlaybackEngine::SpeedDouble()
     if (speedFactor > 1024)
         speedFactor = 1024;
 
-    auto func = [this]() {
+    auto func = [this, speedFactor = speedFactor]() {
         // TODO replace this with m4aMPlayTempoControl
         ctx->reader.SetSpeedFactor(float(speedFactor) / 64.0f);
     };
@@ -187,7 +226,7 @@ void PlaybackEngine::SpeedHalve()
     if (speedFactor < 1)
         speedFactor = 1;
 
-    auto func = [this]() {
+    auto func = [this, speedFactor = speedFactor]() {
         // TODO replace this with m4aMPlayTempoControl
         ctx->reader.SetSpeedFactor(float(speedFactor) / 64.0f);
     };
@@ -195,9 +234,20 @@ void PlaybackEngine::SpeedHalve()
     InvokeAsPlayer(func);
 }
 
+void PlaybackEngine::Seek(double seconds)
+{
+    invokeSeek(seconds, false);
+}
+
+void PlaybackEngine::SeekRelative(double seconds)
+{
+    invokeSeek(seconds, true);
+}
+
 bool PlaybackEngine::SongEnded() const
 {
-    return songEnded;
+    /* Commands which were not run yet may start a new song (e.g. Play after the last one has ended). */
+    return songEnded && playerCommandsPending == 0;
 }
 
 void PlaybackEngine::ToggleMute(size_t index)
@@ -244,21 +294,7 @@ void PlaybackEngine::Mute(size_t index, bool mute)
 
 SongInfo PlaybackEngine::GetSongInfo()
 {
-    SongInfo songInfo;
-
-    auto func = [this, &songInfo]() {
-        const MP2KPlayer &player = ctx->players.at(ctx->primaryPlayer);
-
-        songInfo.songHeaderPos = player.songHeaderPos;
-        songInfo.voiceTablePos = player.bankPos;
-        songInfo.reverb = player.reverb;
-        songInfo.priority = player.priority;
-        songInfo.playerIdx = player.playerIdx;
-    };
-
-    InvokeAsPlayer(func);
-
-    return songInfo;
+    return readSongInfo(Rom::Instance(), profile.songTableInfoPlayback, songIdx);
 }
 
 void PlaybackEngine::UpdateSoundMode()
@@ -267,27 +303,67 @@ void PlaybackEngine::UpdateSoundMode()
      * the profile in the profile editor. No reloading is required and changes should
      * apply immediately. */
 
-    auto func = [this]() {
-        ctx->agbplaySoundMode = profile.agbplaySoundMode;
-        ctx->m4aSoundModeReverb(profile.mp2kSoundModePlayback.rev);
-        ctx->m4aSoundModePCMVol(profile.mp2kSoundModePlayback.vol);
-        ctx->m4aSoundModePCMFreq(profile.mp2kSoundModePlayback.freq);
-        ctx->m4aSoundModeDacConfig(profile.mp2kSoundModePlayback.dacConfig);
+    auto func = [this, agbplaySoundMode = profile.agbplaySoundMode, mp2kSoundMode = profile.mp2kSoundModePlayback]() {
+        ctx->agbplaySoundMode = agbplaySoundMode;
+        ctx->m4aSoundModeReverb(mp2kSoundMode.rev);
+        ctx->m4aSoundModePCMVol(mp2kSoundMode.vol);
+        ctx->m4aSoundModePCMFreq(mp2kSoundMode.freq);
+        ctx->m4aSoundModeDacConfig(mp2kSoundMode.dacConfig);
+        /* prepared with the previous sound mode */
+        pendingSeek.reset();
         /* Do not update the playertable since it may cause playback issues.
          * The user is supposed to reload the game if that was changed with the
          * profile editor. */
     };
 
     InvokeAsPlayer(func);
+
+    /* e.g. the CGB polyphony and loop count change the course of the song */
+    if (checkpointsGeneration != 0)
+        recordCheckpoints();
 }
 
 void PlaybackEngine::GetVisualizerState(MP2KVisualizerState &visualizerState)
 {
-    /* We do not use InvokeAsPlayer, as that would block the call until the background thread
-     * makes the data available. Like this, the mutex only blocks for the actual copy. */
-    std::scoped_lock l(visualizerStateMutex);
+    /* We do not use InvokeAsPlayer, as the result would only be available once the background thread
+     * got to it. If no new state was published, the previous one is returned again.
+     * Once visualizerState has the right size, the copy does not allocate. */
+    visualizerStates.Update();
+    visualizerState = visualizerStates.GetReadBuffer();
+    visualizerStateRequested.store(true, std::memory_order_relaxed);
+}
+
+PlaybackStats PlaybackEngine::GetPlaybackStats()
+{
+    PlaybackStats stats;
+    stats.ringbuffer = ringbuffer.GetStats();
+    stats.outputLatency = audioStream.outputLatency();
+    return stats;
+}
+
+void PlaybackEngine::LogPlaybackStats()
+{
+    const PlaybackStats stats = GetPlaybackStats();
+    Debug::print(
+        "Playback: {} underruns, {} partial takes, {} overruns, fill level {}/{} samples, output latency {:.1f} ms",
+        stats.ringbuffer.underruns,
+        stats.ringbuffer.partialTakes,
+        stats.ringbuffer.overruns,
+        stats.ringbuffer.fillLevel,
+        stats.ringbuffer.targetLevel,
+        stats.outputLatency * 1000.0
+    );
 
-    visualizerState = visualizerStateObserver;
+    std::string histogram;
+    for (size_t i = 0; i < stats.ringbuffer.commandLatency.size(); i++) {
+        if (stats.ringbuffer.commandLatency[i] == 0)
+            continue;
+        if (i + 1 == stats.ringbuffer.commandLatency.size())
+            histogram += fmt::format(" >={}ms:{}", 1 << (i - 1), stats.ringbuffer.commandLatency[i]);
+        else
+            histogram += fmt::format(" <{}ms:{}", 1 << i, stats.ringbuffer.commandLatency[i]);
+    }
+    Debug::print("Playback: command to audio latency{}", histogram.empty() ? " not measured yet" : histogram);
 }
 
 /*
@@ -302,6 +378,8 @@ void PlaybackEngine::threadWorker()
         while (!playerThreadQuitRequest) {
             /* Run events from main thread. */
             InvokeRun();
+            if (pendingSeek)
+                runPendingSeek();
 
             if (paused) {
                 /* Silence output buffer. */
@@ -309,6 +387,7 @@ void PlaybackEngine::threadWorker()
             } else {
                 /* Run sound engine. */
                 ctx->m4aSoundMain();
+                songPosition += double(ctx->reader.GetSpeedFactor());
                 updateVisualizerState();
 
                 /* Write audio data to portaudio ringbuffer. */
@@ -329,60 +408,139 @@ void PlaybackEngine::threadWorker()
         playerThreadQuitError = e.what();
     }
 
-    std::unique_lock l(playerInvokeMutex);
-    playerThreadQuitComplete = true;
+    {
+        std::unique_lock lock(playerThreadQuitMutex);
+        playerThreadQuitComplete = true;
+    }
+    /* Drop commands which will never run, so anybody waiting for them gets a broken promise.
+     * No new ones can be pushed anymore. */
+    playerCommands.Drain([](const std::function<void(void)> &) {});
 }
 
 void PlaybackEngine::updateVisualizerState()
 {
-    /* We assume that GetVisualizerState may be more expensive than a simple copy.
-     * Accordingly we generate the state, then we lock the mutex and publish the state.
-     * That way the mutex is only locked for the smallest duration necessary. */
-
-    ctx->GetVisualizerState(visualizerStatePlayer);
+    /* The state is generated directly into the write buffer and then published, without any copy.
+     * This never waits for the UI thread. Without an observer, nothing is generated at all. */
+    if (!visualizerStateRequested.exchange(false, std::memory_order_relaxed))
+        return;
 
-    std::scoped_lock l(visualizerStateMutex);
+    ctx->GetVisualizerState(visualizerStates.GetWriteBuffer());
+    visualizerStates.Publish();
+}
 
-    visualizerStateObserver = visualizerStatePlayer;
+void PlaybackEngine::recordCheckpoints()
+{
+    /* The previous recording is dropped by the checkpoint thread, seeks which still refer to it are ignored. */
+    checkpointsGeneration = checkpoints->Load(profile.mp2kSoundModePlayback, profile.agbplaySoundMode, songIdx);
 }
 
-void PlaybackEngine::InvokeAsPlayer(const std::function<void(void)> &func)
+void PlaybackEngine::invokeSeek(double seconds, bool relative)
 {
-    /* This function must be called from within the main thread only! */
-    assert(std::this_thread::get_id() != playerThread->get_id());
+    const auto commandTime = std::chrono::steady_clock::now();
+    auto func = [this, generation = checkpointsGeneration, seconds, relative, commandTime]() {
+        const uint8_t playerIdx = ctx->primaryPlayer;
+        if (generation == 0 || playerIdx >= ctx->players.size() || !ctx->m4aMPlayIsPlaying(playerIdx))
+            return;
 
-    std::unique_lock l(playerInvokeMutex);
+        /* Checkpoints are counted in subframes from the start of the song at normal speed (see songPosition).
+         * Relative seeks add up while the previous one is still pending. */
+        double target = seconds * double(AGB_FPS * INTERFRAMES);
+        if (relative && pendingSeek)
+            target += double(pendingSeek->subframe);
+        else if (relative)
+            target += songPosition;
+        const size_t subframe = static_cast<size_t>(std::max(target, 0.0));
+
+        pendingSeek = PendingSeek{subframe, commandTime};
+        checkpoints->RequestSeek(generation, subframe);
+        runPendingSeek();
+    };
 
-    playerInvokePending = true;
-    playerInvokeReady.wait(l);
-    func();
-    playerInvokePending = false;
-    playerInvokeComplete.notify_one();
+    InvokeAsPlayer(func);
 }
 
-void PlaybackEngine::InvokeRun()
+void PlaybackEngine::runPendingSeek()
 {
-    /* This function must be called from within the player thread only! */
-    // This does not work as playerThread is not fully initialized eventhough this thread is already running
-    // assert(std::this_thread::get_id() == playerThread->get_id());
+    /* The song may have been stopped by the player thread while waiting. */
+    const uint8_t playerIdx = ctx->primaryPlayer;
+    if (playerIdx >= ctx->players.size() || !ctx->m4aMPlayIsPlaying(playerIdx)) {
+        pendingSeek.reset();
+        return;
+    }
 
-    if (!playerInvokePending)
+    /* Preparing the context takes much longer than a block, so it is never waited for. */
+    const MP2KContext *previousCtx = ctx.get();
+    if (!checkpoints->TakeSeek(ctx))
         return;
 
-    std::unique_lock l(playerInvokeMutex);
+    /* ctx is left alone if the seek failed or was for a previous recording. If the song ends before the target, the
+     * player thread stops it as usual. */
+    if (ctx.get() != previousCtx) {
+        songEnded = false;
+        songPosition = double(pendingSeek->subframe);
+    }
+    ringbuffer.MarkCommand(pendingSeek->commandTime);
+    pendingSeek.reset();
+}
+
+template<typename F> auto PlaybackEngine::InvokeAsPlayer(F &&func) -> std::future<std::invoke_result_t<F>>
+{
+    /* This function must be called from within the main thread only!
+     * It does not wait for the player thread. Callers which need the result or have to know when func
+     * has run, can wait for the returned future. Since the lambdas run later, they must not capture
+     * state of the main thread by reference. */
+    assert(std::this_thread::get_id() != playerThread->get_id());
+
+    using Result = std::invoke_result_t<F>;
+    /* std::function must be copyable, the promise is not */
+    auto promise = std::make_shared<std::promise<Result>>();
+    std::future<Result> result = promise->get_future();
+    auto command = [promise, func = std::forward<F>(func)]() mutable {
+        try {
+            if constexpr (std::is_void_v<Result>) {
+                func();
+                promise->set_value();
+            } else {
+                promise->set_value(func());
+            }
+        } catch (...) {
+            /* for the caller, if it waits for the result, and for InvokeRun to log it */
+            promise->set_exception(std::current_exception());
+            throw;
+        }
+    };
 
+    /* Must not interleave with the player thread exiting, otherwise the command might be pushed after the final
+     * drain and never run. */
+    std::unique_lock lock(playerThreadQuitMutex);
     if (playerThreadQuitComplete) [[unlikely]] {
-        /* if the player thread has exited already, we can't invoke
-         * a function as we'll wait forever for the thread to become ready. */
+        /* if the player thread has exited already, nobody would ever run func */
         if (playerThreadQuitError.size() > 0)
             throw Xcept("Playback thread has crashed: {}", playerThreadQuitError);
         throw Xcept("Unable to send request to playback thread, which is not running.");
     }
 
-    playerInvokeReady.notify_one();
+    playerCommandsPending++;
+    playerCommands.Push(std::move(command));
+    return result;
+}
 
-    /* wait for remote invocation to complete... */
-    playerInvokeComplete.wait(l);
+void PlaybackEngine::InvokeRun()
+{
+    /* This function must be called from within the player thread only! */
+    // This does not work as playerThread is not fully initialized eventhough this thread is already running
+    // assert(std::this_thread::get_id() == playerThread->get_id());
+
+    playerCommands.Drain([this](const std::function<void(void)> &command) {
+        /* Most callers don't wait for the result, so a failed command would go unnoticed otherwise.
+         * It must not take down the player thread either. */
+        try {
+            command();
+        } catch (const std::exception &e) {
+            Debug::print("Player command failed: {}", e.what());
+        }
+        playerCommandsPending--;
+    });
 }
 
 int PlaybackEngine::audioCallback(
@@ -2,18 +2,29 @@
 
 #include "LowLatencyRingbuffer.hpp"
 #include "MP2KContext.hpp"
+#include "MPSCQueue.hpp"
 #include "Profile.hpp"
+#include "SongCheckpoints.hpp"
+#include "TripleBuffer.hpp"
 
 #include <bitset>
-#include <condition_variable>
+#include <chrono>
 #include <cstdint>
 #include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <portaudiocpp/PortAudioCpp.hxx>
 #include <thread>
 #include <vector>
 
+struct PlaybackStats
+{
+    LowLatencyRingbuffer::Stats ringbuffer;
+    double outputLatency = 0.0;    // seconds, as reported by PortAudio, not included in the command latency
+};
+
 class PlaybackEngine
 {
 public:
@@ -24,21 +35,34 @@ public:
 
     void LoadSong(uint16_t songIdx);
     void Play();
+    /* Pauses or resumes the song, or starts it again if it is not playing anymore. Returns whether the song is
+     * playing afterwards. Does not wait for the player thread. */
     bool Pause();
     void Stop();
     void SpeedDouble();
     void SpeedHalve();
+    /* Continue the playing song at the given time from its start or from the current position. Times are counted
+     * at normal speed, also while the speed is changed. Does nothing if no song is playing. */
+    void Seek(double seconds);
+    void SeekRelative(double seconds);
     bool SongEnded() const;
     void ToggleMute(size_t index);
     void Mute(size_t index, bool mute);
+    /* info of the loaded song, read from the ROM without waiting for the player thread */
     SongInfo GetSongInfo();
     void UpdateSoundMode();
+    /* must always be called from the same thread, does not block */
     void GetVisualizerState(MP2KVisualizerState &visualizerState);
+    PlaybackStats GetPlaybackStats();
+    void LogPlaybackStats();
 
 private:
     void threadWorker();
     void updateVisualizerState();
-    void InvokeAsPlayer(const std::function<void(void)> &func);
+    void recordCheckpoints();
+    void invokeSeek(double seconds, bool relative);
+    void runPendingSeek();
+    template<typename F> auto InvokeAsPlayer(F &&func) -> std::future<std::invoke_result_t<F>>;
     void InvokeRun();
     static int audioCallback(
         const void *inputBuffer,
@@ -57,20 +81,44 @@ private:
     portaudio::FunCallbackStream audioStream;
     uint32_t speedFactor = 64;
     std::bitset<16> trackMuted;    // TODO replace 16 with constant
+    /* Whether the loaded song was started and paused, as the main thread has told the player thread.
+     * Commands which depend on it are decided by the main thread, so it doesn't have to wait for the player thread.
+     * The player thread has its own copy (paused). */
+    bool songStarted = false;
+    bool songPaused = false;
     bool paused = false;
     std::unique_ptr<MP2KContext> ctx;
+    /* Records the loaded song in the background and prepares seeks. checkpointsGeneration is the one of the loaded
+     * song, 0 if none was loaded yet. */
+    std::unique_ptr<SongCheckpoints> checkpoints;
+    uint32_t checkpointsGeneration = 0;
+
+    /* A seek which the checkpoint thread is still preparing. The mixer thread keeps playing and swaps in the prepared
+     * context once it is ready. Player thread only. */
+    struct PendingSeek
+    {
+        size_t subframe;
+        std::chrono::steady_clock::time_point commandTime;
+    };
+    std::optional<PendingSeek> pendingSeek;
+    /* Position of the playing song in subframes at normal speed, like the checkpoints are counted. Player thread
+     * only. */
+    double songPosition = 0.0;
 
-    MP2KVisualizerState visualizerStatePlayer;
-    MP2KVisualizerState visualizerStateObserver;
-    std::mutex visualizerStateMutex;
+    /* written by the mixer thread, read by GetVisualizerState */
+    TripleBuffer<MP2KVisualizerState> visualizerStates;
+    /* set by GetVisualizerState, the mixer thread only generates a new state (and meters) if somebody asked */
+    std::atomic<bool> visualizerStateRequested = false;
 
-    std::mutex playerInvokeMutex;
-    std::condition_variable playerInvokeReady;
-    std::condition_variable playerInvokeComplete;
-    std::atomic<bool> playerInvokePending = false;
+    /* commands from the main thread, run by the mixer thread between blocks */
+    MPSCQueue<std::function<void(void)>> playerCommands;
+    std::atomic<size_t> playerCommandsPending = 0;
     std::unique_ptr<std::thread> playerThread;
     std::atomic<bool> playerThreadQuitRequest = false;
     std::string playerThreadQuitError;
+    /* Guards playerThreadQuitComplete, so no command can be pushed after the player thread has dropped the remaining
+     * ones. The player thread only takes it once, when it exits. */
+    std::mutex playerThreadQuitMutex;
     bool playerThreadQuitComplete = false;
 
     std::atomic<bool> songEnded = false;
@@ -0,0 +1,120 @@
+#include "BlepSynth.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+#include <boost/math/special_functions/sinc.hpp>
+
+/*
+ * public BlepSynth
+ */
+
+BlepSynth::BlepSynth(std::vector<float> &&deltaBuffer) : deltaBuffer(std::move(deltaBuffer))
+{
+    assert(this->deltaBuffer.empty());
+}
+
+void BlepSynth::AddSteps(std::span<const Step> steps)
+{
+    size_t i = 0;
+    while (i < steps.size()) {
+        const uint32_t slot = kernelPos(steps[i].t) / KERNEL_PHASES;
+        const size_t start = slot + 1;
+        if (deltaBuffer.size() < start + KERNEL_SIZE)
+            deltaBuffer.resize(start + KERNEL_SIZE, 0.0f);
+
+        // sum up all steps within the same output sample first, adding them one by one would stall on store forwarding
+        std::array<float, KERNEL_SIZE> acc{};
+        do {
+            assert(i == 0 || steps[i].t >= steps[i - 1].t);
+            const uint32_t pos = kernelPos(steps[i].t);
+            if (pos / KERNEL_PHASES != slot)
+                break;
+            const std::array<float, KERNEL_SIZE> &kernel = kernelLut[pos % KERNEL_PHASES];
+            for (size_t k = 0; k < KERNEL_SIZE; k++)
+                acc[k] += kernel[k] * steps[i].delta;
+        } while (++i < steps.size());
+
+        for (size_t k = 0; k < KERNEL_SIZE; k++)
+            deltaBuffer[start + k] += acc[k];
+    }
+}
+
+void BlepSynth::Render(std::span<float> buffer)
+{
+    if (deltaBuffer.size() < buffer.size())
+        deltaBuffer.resize(buffer.size(), 0.0f);
+
+    for (size_t i = 0; i < buffer.size(); i++) {
+        level += deltaBuffer[i];
+        buffer[i] = level;
+    }
+
+    // keep the tails of steps which reach into the next buffer
+    const auto consumedEnd = deltaBuffer.begin() + static_cast<std::ptrdiff_t>(buffer.size());
+    const auto rest = std::copy(consumedEnd, deltaBuffer.end(), deltaBuffer.begin());
+    std::fill(rest, deltaBuffer.end(), 0.0f);
+}
+
+void BlepSynth::Skip(size_t numSamples)
+{
+    if (deltaBuffer.size() < numSamples)
+        deltaBuffer.resize(numSamples, 0.0f);
+
+    for (size_t i = 0; i < numSamples; i++)
+        level += deltaBuffer[i];
+
+    const auto consumedEnd = deltaBuffer.begin() + static_cast<std::ptrdiff_t>(numSamples);
+    const auto rest = std::copy(consumedEnd, deltaBuffer.end(), deltaBuffer.begin());
+    std::fill(rest, deltaBuffer.end(), 0.0f);
+}
+
+std::vector<float> BlepSynth::TakeBuffer()
+{
+    return std::move(deltaBuffer);
+}
+
+/*
+ * private BlepSynth
+ */
+
+uint32_t BlepSynth::kernelPos(float t)
+{
+    assert(t >= 0.0f);
+    return static_cast<uint32_t>(static_cast<int32_t>(t * float(KERNEL_PHASES) + 0.5f));
+}
+
+const std::vector<std::array<float, BlepSynth::KERNEL_SIZE>> BlepSynth::kernelLut = []() {
+    // hann windowed sinc, i.e. the impulse response of the lowpass filter
+    auto impulse = [](double x) {
+        if (std::abs(x) >= double(KERNEL_HALF))
+            return 0.0;
+        const double window = 0.5 + 0.5 * std::cos(x * M_PI / double(KERNEL_HALF));
+        return double(KERNEL_CUTOFF_FREQ) * boost::math::sinc_pi(x * M_PI * double(KERNEL_CUTOFF_FREQ)) * window;
+    };
+
+    /* A step at fraction f is integrated over each output sample period to get by how much
+     * the output changes from the previous sample. Simpson's rule is precise enough for the smooth kernel. */
+    const size_t INTEGRAL_RESOLUTION = 16;
+    std::vector<std::array<float, KERNEL_SIZE>> l(KERNEL_PHASES);
+    for (size_t p = 0; p < KERNEL_PHASES; p++) {
+        const double fraction = double(p) / double(KERNEL_PHASES);
+        std::array<double, KERNEL_SIZE> taps;
+        double sum = 0.0;
+        for (size_t i = 0; i < KERNEL_SIZE; i++) {
+            const double from = double(i) - double(KERNEL_HALF) - fraction;
+            const double h = 1.0 / double(INTEGRAL_RESOLUTION);
+            double acc = impulse(from) + impulse(from + 1.0);
+            for (size_t j = 1; j < INTEGRAL_RESOLUTION; j++)
+                acc += (j % 2 ? 4.0 : 2.0) * impulse(from + double(j) * h);
+            taps[i] = acc * h / 3.0;
+            sum += taps[i];
+        }
+        // normalize so that every step ends up at exactly its height
+        for (size_t i = 0; i < KERNEL_SIZE; i++)
+            l[p][i] = static_cast<float>(taps[i] / sum);
+    }
+    return l;
+}();
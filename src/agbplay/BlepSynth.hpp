@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/* BlepSynth renders a piecewise constant signal directly at the output rate. Instead of generating the signal
+ * at a high rate and resampling it afterwards, every level change is added as band-limited step (BLEP).
+ * The cost therefore only depends on the number of level changes, not on the rate they are generated at.
+ *
+ * Steps are accumulated as differences and integrated in Render. The output is delayed by KERNEL_HALF samples,
+ * so the filter kernel of a step can start before the step itself. */
+class BlepSynth
+{
+public:
+    BlepSynth() = default;
+    /* reuses the buffer of another synth (see TakeBuffer), which has to be empty */
+    explicit BlepSynth(std::vector<float> &&deltaBuffer);
+
+    struct Step
+    {
+        /* measured in output samples from the start of the next Render call, must not be negative */
+        float t;
+        float delta;
+    };
+
+    /* Steps have to be sorted by time. Adding many steps at once is a lot faster than adding them one by one,
+     * because the kernels of all steps within the same output sample can be summed up before they are added
+     * to the output. */
+    void AddSteps(std::span<const Step> steps);
+    void Render(std::span<float> buffer);
+    /* advances like Render for numSamples, without writing any output */
+    void Skip(size_t numSamples);
+    /* moves the internal buffer out, e.g. to reuse it for another synth. The synth must not be used afterwards. */
+    std::vector<float> TakeBuffer();
+
+    static inline const size_t KERNEL_HALF = 8;
+
+private:
+    static inline const size_t KERNEL_SIZE = KERNEL_HALF * 2;
+    /* Number of sub-sample positions the kernel is precalculated for. */
+    static inline const size_t KERNEL_PHASES = 256;
+    /* Cutoff relative to the output Nyquist frequency, same as for the interpolating resamplers. */
+    static inline const float KERNEL_CUTOFF_FREQ = 0.85f;
+
+    static uint32_t kernelPos(float t);
+
+    static const std::vector<std::array<float, KERNEL_SIZE>> kernelLut;
+
+    std::vector<float> deltaBuffer;
+    float level = 0.0f;
+};
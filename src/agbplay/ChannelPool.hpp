@@ -0,0 +1,172 @@
+#pragma once
+
+#include "Resampler.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+/* ChannelRecycler keeps the heap allocated parts of removed channels (resamplers including their fetch buffers,
+ * and synth buffers), so new channels reuse them instead of allocating their own.
+ * All channel pools of a context share one (see MP2KChn::Recycle). */
+class ChannelRecycler
+{
+public:
+    /* Same as Resampler::MakeResampler(t, polyphase), but returns the resampler of a removed channel if one is left.
+     * Spare resamplers of another polyphase mode (after the sound mode was changed) are dropped. */
+    std::unique_ptr<Resampler> TakeResampler(ResamplerType t, ResamplerPolyphase polyphase)
+    {
+        std::vector<std::unique_ptr<Resampler>> &spare = resamplers.at(static_cast<size_t>(t));
+        polyphase = Resampler::GetActivePolyphase(polyphase);
+        if (!spare.empty() && spare.back()->GetPolyphase() != polyphase)
+            spare.clear();
+        if (spare.empty())
+            return Resampler::MakeResampler(t, polyphase);
+        std::unique_ptr<Resampler> rs = std::move(spare.back());
+        spare.pop_back();
+        rs->Reset();
+        return rs;
+    }
+
+    void PutResampler(std::unique_ptr<Resampler> rs)
+    {
+        if (rs)
+            resamplers.at(static_cast<size_t>(rs->GetType())).emplace_back(std::move(rs));
+    }
+
+    /* returns an empty buffer, which keeps the capacity of a removed channel's buffer if one is left */
+    std::vector<float> TakeBuffer()
+    {
+        if (buffers.empty())
+            return {};
+        std::vector<float> buffer = std::move(buffers.back());
+        buffers.pop_back();
+        buffer.clear();
+        return buffer;
+    }
+
+    void PutBuffer(std::vector<float> buffer)
+    {
+        if (buffer.capacity() > 0)
+            buffers.emplace_back(std::move(buffer));
+    }
+
+private:
+    std::array<std::vector<std::unique_ptr<Resampler>>, static_cast<size_t>(ResamplerType::BLAMP) + 1> resamplers;
+    std::vector<std::vector<float>> buffers;
+};
+
+/* ChannelPool is a replacement for std::list<Channel> without an allocation per note.
+ * Channels are constructed in slabs of SLAB_SIZE slots. A slot never moves, so channel addresses
+ * stay valid for the MP2KChn prev/next track links until the channel is removed.
+ * Active channels are iterated via a dense pointer array in insertion order (i.e. the same
+ * order std::list had), removed slots are recycled and so are the resamplers and buffers of removed channels
+ * (see ChannelRecycler). Once the pool has grown to the maximum number of simultaneous channels of a song,
+ * adding and removing channels does not allocate. */
+
+template<typename T> class ChannelPool
+{
+public:
+    template<typename P> class Iterator
+    {
+    public:
+        explicit Iterator(P *const *p) : p(p) {}
+        P &operator*() const { return **p; }
+        P *operator->() const { return *p; }
+        Iterator &operator++()
+        {
+            p++;
+            return *this;
+        }
+        bool operator==(const Iterator &rhs) const { return p == rhs.p; }
+
+    private:
+        P *const *p;
+    };
+
+    explicit ChannelPool(ChannelRecycler &recycler) : recycler(recycler) {}
+    ChannelPool(const ChannelPool &) = delete;
+    ChannelPool &operator=(const ChannelPool &) = delete;
+    ~ChannelPool() { clear(); }
+
+    template<typename... Args> T &emplace_back(Args &&...args)
+    {
+        if (freeSlots.empty())
+            addSlab();
+
+        /* Only take the slot once the constructor succeeded. Capacity of 'active' is always
+         * sufficient for all slots, so push_back does not allocate or throw. */
+        T *chn = new (freeSlots.back()) T(std::forward<Args>(args)...);
+        freeSlots.pop_back();
+        active.push_back(chn);
+        return *chn;
+    }
+
+    template<typename Pred> void remove_if(Pred pred)
+    {
+        size_t j = 0;
+        for (size_t i = 0; i < active.size(); i++) {
+            T *chn = active[i];
+            if (pred(std::as_const(*chn))) {
+                chn->Recycle(recycler);
+                chn->~T();
+                freeSlots.push_back(reinterpret_cast<std::byte *>(chn));
+            } else {
+                active[j++] = chn;
+            }
+        }
+        active.resize(j);
+    }
+
+    void clear()
+    {
+        for (T *chn : active) {
+            chn->Recycle(recycler);
+            chn->~T();
+            freeSlots.push_back(reinterpret_cast<std::byte *>(chn));
+        }
+        active.clear();
+    }
+
+    size_t size() const { return active.size(); }
+    bool empty() const { return active.empty(); }
+    size_t capacity() const { return slabs.size() * SLAB_SIZE; }
+
+    T &front() { return *active.front(); }
+    const T &front() const { return *active.front(); }
+    T &back() { return *active.back(); }
+    const T &back() const { return *active.back(); }
+
+    Iterator<T> begin() { return Iterator<T>(active.data()); }
+    Iterator<T> end() { return Iterator<T>(active.data() + active.size()); }
+    Iterator<const T> begin() const { return Iterator<const T>(active.data()); }
+    Iterator<const T> end() const { return Iterator<const T>(active.data() + active.size()); }
+
+    static inline const size_t SLAB_SIZE = 32;
+
+private:
+    struct Slab
+    {
+        alignas(T) std::byte slots[SLAB_SIZE][sizeof(T)];
+    };
+
+    void addSlab()
+    {
+        slabs.emplace_back(std::make_unique<Slab>());
+        active.reserve(capacity());
+        freeSlots.reserve(capacity());
+        /* push in reverse, so slots are handed out in ascending address order */
+        Slab &slab = *slabs.back();
+        for (size_t i = SLAB_SIZE; i-- > 0;)
+            freeSlots.push_back(slab.slots[i]);
+    }
+
+    ChannelRecycler &recycler;
+    std::vector<std::unique_ptr<Slab>> slabs;
+    std::vector<T *> active;
+    std::vector<std::byte *> freeSlots;
+};
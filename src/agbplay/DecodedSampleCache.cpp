@@ -0,0 +1,123 @@
+#include "DecodedSampleCache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <mutex>
+
+/*
+ * public DecodedSampleCache
+ */
+
+std::span<const float> DecodedSampleCache::GetPCM(const SampleInfo &sInfo)
+{
+    return get(sInfo, decodePCM);
+}
+
+std::span<const float> DecodedSampleCache::GetGFDPCM(const SampleInfo &sInfo)
+{
+    return get(sInfo, decodeGFDPCM);
+}
+
+std::span<const float> DecodedSampleCache::GetCamelotADPCM(const SampleInfo &sInfo)
+{
+    return get(sInfo, decodeCamelotADPCM);
+}
+
+/*
+ * private DecodedSampleCache
+ */
+
+template<typename Decode> std::span<const float> DecodedSampleCache::get(const SampleInfo &sInfo, Decode &&decode)
+{
+    {
+        std::shared_lock lock(mutex);
+        const auto it = samples.find(sInfo.samplePos);
+        if (it != samples.end())
+            return it->second;
+    }
+
+    /* Decode without holding the lock. If another thread decoded the same sample in the meantime,
+     * its result is kept and ours is discarded. Both are identical anyway. */
+    std::vector<float> decoded(PAD_FRONT + sInfo.endPos + PAD_BACK, 0.0f);
+    decode(sInfo, std::span<float>(decoded).subspan(PAD_FRONT, sInfo.endPos));
+
+    if (HasValidLoop(sInfo)) {
+        const size_t loopStart = PAD_FRONT + sInfo.loopPos;
+        const size_t loopLen = sInfo.endPos - sInfo.loopPos;
+        for (size_t i = 0; i < PAD_BACK; i++)
+            decoded[PAD_FRONT + sInfo.endPos + i] = decoded[loopStart + i % loopLen];
+    }
+
+    std::unique_lock lock(mutex);
+    return samples.try_emplace(sInfo.samplePos, std::move(decoded)).first->second;
+}
+
+void DecodedSampleCache::decodePCM(const SampleInfo &sInfo, std::span<float> out)
+{
+    for (size_t i = 0; i < out.size(); i++)
+        out[i] = float(sInfo.samplePtr[i]) / 128.0f;
+}
+
+void DecodedSampleCache::decodeGFDPCM(const SampleInfo &sInfo, std::span<float> out)
+{
+    const size_t DPCM_BLOCK_SIZE = 64;
+    static const std::array<int8_t, 16> deltaTable = {0, 1, 4, 9, 16, 25, 36, 49, -64, -49, -36, -25, -16, -9, -4, -1};
+
+    const size_t numBlocks = (out.size() + DPCM_BLOCK_SIZE - 1) / DPCM_BLOCK_SIZE;
+    std::array<float, DPCM_BLOCK_SIZE> decodeBuffer;
+
+    /* each block of 64 samples consists of 0x21 bytes: one absolute sample followed by 63 deltas */
+    for (size_t block = 0; block < numBlocks; block++) {
+        const int8_t *blockPtr = &sInfo.samplePtr[block * 0x21];
+
+        int8_t acc = blockPtr[0];
+        decodeBuffer[0] = static_cast<float>(acc) / 128.0f;
+        acc += deltaTable[blockPtr[1] & 0xF];
+        decodeBuffer[1] = static_cast<float>(acc) / 128.0f;
+        for (size_t j = 2, h = 2; j < DPCM_BLOCK_SIZE; j += 2, h++) {
+            acc += deltaTable[(blockPtr[h] & 0xF0) >> 4];
+            decodeBuffer[j + 0] = static_cast<float>(acc) / 128.0f;
+            acc += deltaTable[blockPtr[h] & 0xF];
+            decodeBuffer[j + 1] = static_cast<float>(acc) / 128.0f;
+        }
+
+        // the last block may be incomplete
+        const size_t blockStart = block * DPCM_BLOCK_SIZE;
+        const size_t blockLen = std::min(DPCM_BLOCK_SIZE, out.size() - blockStart);
+        std::copy_n(decodeBuffer.begin(), blockLen, out.begin() + static_cast<std::ptrdiff_t>(blockStart));
+    }
+}
+
+void DecodedSampleCache::decodeCamelotADPCM(const SampleInfo &sInfo, std::span<float> out)
+{
+    int16_t level = 0;
+    uint8_t shift = 0x38;
+
+    for (size_t pos = 0; pos < out.size(); pos++) {
+        // once again, I just took over the assembly implementation
+        // there is probably plenty of room to make this nicer, but it at least works for now
+        bool loNibble = pos & 1;
+        int8_t data = sInfo.samplePtr[pos >> 1u];
+
+        // 4 bit nibble is shifted up to bit 31..28
+        int32_t nibble;
+        if (loNibble)
+            nibble = (int32_t(data) << 28) & 0xF0000000;
+        else
+            nibble = (int32_t(data) << 24) & 0xF0000000;
+
+        // in the ARM ASM you can easily just shift by more than 31, but this does not work on x86/C++
+        if (shift <= 63) {
+            int32_t actualShift = (int32_t)(shift >> 1u);
+            level = int16_t(level + (nibble >> actualShift));
+        }
+
+        if (nibble & 0x80000000)
+            nibble = -nibble;
+        shift = uint8_t(shift + 4);
+        shift = uint8_t((uint32_t)shift - ((uint32_t)nibble >> 28u));
+
+        out[pos] = float(level) / 128.0f;
+    }
+}
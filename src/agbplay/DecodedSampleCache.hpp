@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <cstddef>
+#include <shared_mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+/* DecodedSampleCache holds samples converted to float: compressed samples (GameFreak DPCM and Camelot ADPCM)
+ * and, if the sample bank is enabled, uncompressed PCM samples. Conversion only depends on ROM data,
+ * so each sample is converted once on first use and then shared read-only by all channels and threads
+ * which render from the same ROM. Samples are indexed by their ROM position and are never removed,
+ * so returned spans stay valid for the lifetime of the cache (i.e. the Rom).
+ *
+ * Each cached sample is padded, so resamplers can read from it directly:
+ * PAD_FRONT samples of silence for the filter history, then the endPos samples of the sample itself,
+ * then PAD_BACK samples which continue the loop (or silence if the sample does not loop). */
+class DecodedSampleCache
+{
+public:
+    DecodedSampleCache() = default;
+    DecodedSampleCache(const DecodedSampleCache &) = delete;
+    DecodedSampleCache &operator=(const DecodedSampleCache &) = delete;
+
+    /* The ROM range must have been validated by the caller. */
+    std::span<const float> GetPCM(const SampleInfo &sInfo);
+    std::span<const float> GetGFDPCM(const SampleInfo &sInfo);
+    std::span<const float> GetCamelotADPCM(const SampleInfo &sInfo);
+
+    static bool HasValidLoop(const SampleInfo &sInfo) { return sInfo.loopEnabled && sInfo.loopPos < sInfo.endPos; }
+
+    static inline const size_t PAD_FRONT = 16;
+    static inline const size_t PAD_BACK = 2048;
+
+private:
+    template<typename Decode> std::span<const float> get(const SampleInfo &sInfo, Decode &&decode);
+
+    static void decodePCM(const SampleInfo &sInfo, std::span<float> out);
+    static void decodeGFDPCM(const SampleInfo &sInfo, std::span<float> out);
+    static void decodeCamelotADPCM(const SampleInfo &sInfo, std::span<float> out);
+
+    std::shared_mutex mutex;
+    std::unordered_map<size_t, std::vector<float>> samples;
+};
@@ -3,31 +3,81 @@
 #include "Constants.hpp"
 #include "Util.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <numbers>
 
+struct BufferLevel
+{
+    float meanSqLeft = 0.0f, meanSqRight = 0.0f;
+    float peakLeft = 0.0f, peakRight = 0.0f;
+};
+
+static BufferLevel measureBuffer(std::span<const sample> buffer)
+{
+    /* Independent accumulators for each lane, so the compiler can use SIMD instead of a serial
+     * dependency chain. Reordering the float additions would not be allowed otherwise. */
+    static const size_t LANES = 8;
+    std::array<float, LANES> sumSqLeft{}, sumSqRight{}, peakLeft{}, peakRight{};
+
+    size_t i = 0;
+    for (; i + LANES <= buffer.size(); i += LANES) {
+        for (size_t j = 0; j < LANES; j++) {
+            const float l = buffer[i + j].left;
+            const float r = buffer[i + j].right;
+            sumSqLeft[j] += l * l;
+            sumSqRight[j] += r * r;
+            peakLeft[j] = std::max(peakLeft[j], std::abs(l));
+            peakRight[j] = std::max(peakRight[j], std::abs(r));
+        }
+    }
+    for (; i < buffer.size(); i++) {
+        const float l = buffer[i].left;
+        const float r = buffer[i].right;
+        sumSqLeft[0] += l * l;
+        sumSqRight[0] += r * r;
+        peakLeft[0] = std::max(peakLeft[0], std::abs(l));
+        peakRight[0] = std::max(peakRight[0], std::abs(r));
+    }
+
+    BufferLevel level;
+    for (size_t j = 0; j < LANES; j++) {
+        level.meanSqLeft += sumSqLeft[j];
+        level.meanSqRight += sumSqRight[j];
+        level.peakLeft = std::max(level.peakLeft, peakLeft[j]);
+        level.peakRight = std::max(level.peakRight, peakRight[j]);
+    }
+    if (buffer.size() > 0) {
+        level.meanSqLeft /= static_cast<float>(buffer.size());
+        level.meanSqRight /= static_cast<float>(buffer.size());
+    }
+    return level;
+}
+
 LoudnessCalculator::LoudnessCalculator(float lowpassFreq, uint32_t sampleRate) :
-    lpAlpha(calcAlpha(lowpassFreq, sampleRate))
+    lpDecayLog2(std::log2(1.0f - calcAlpha(lowpassFreq, sampleRate)))
 {
 }
 
-void LoudnessCalculator::CalcLoudness(std::span<const sample> buffer)
+void LoudnessCalculator::CalcLoudness(std::span<const sample> buffer, size_t elapsedSamples)
 {
     using std::numbers::sqrt2_v;
 
-    for (size_t i = 0; i < buffer.size(); i++) {
-        peakLeft = std::max(peakLeft * (1.0f - lpAlpha), 0.0f);
-        peakRight = std::max(peakRight * (1.0f - lpAlpha), 0.0f);
-        float l = buffer[i].left;
-        float r = buffer[i].right;
-        peakLeft = std::max(std::abs(peakLeft), l);
-        peakRight = std::max(std::abs(peakRight), r);
-        l *= l;
-        r *= r;
-        avgVolLeftSq = avgVolLeftSq + lpAlpha * (l - avgVolLeftSq);
-        avgVolRightSq = avgVolRightSq + lpAlpha * (r - avgVolRightSq);
-    }
+    elapsedSamples = std::max(elapsedSamples, buffer.size());
+    if (elapsedSamples == 0)
+        return;
+
+    /* Per sample, the RMS lowpass would move by alpha towards the squared sample, and the peak would decay by
+     * (1 - alpha). Applied to the whole buffer at once, both decay by (1 - alpha)^n towards the buffer's level. */
+    const BufferLevel level = measureBuffer(buffer);
+    const float decay = std::exp2(static_cast<float>(elapsedSamples) * lpDecayLog2);
+
+    avgVolLeftSq = level.meanSqLeft + decay * (avgVolLeftSq - level.meanSqLeft);
+    avgVolRightSq = level.meanSqRight + decay * (avgVolRightSq - level.meanSqRight);
+    peakLeft = std::max(peakLeft * decay, level.peakLeft);
+    peakRight = std::max(peakRight * decay, level.peakRight);
 
     // normalize RMS value to 1.0 for a 1.0 amplitude sine wave
     rmsLeft = sqrtf(avgVolLeftSq) * sqrt2_v<float>;
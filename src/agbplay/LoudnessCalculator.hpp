@@ -6,6 +6,10 @@
 #include <cstdint>
 #include <span>
 
+/* Meters for RMS and peak level. They are not updated per sample, but once per buffer from its mean square
+ * and peak value. The buffer doesn't have to contain all audio since the last update, it is then
+ * taken as representative of the skipped audio as well. That way the meters only cost something
+ * when somebody actually looks at them. */
 class LoudnessCalculator
 {
 public:
@@ -14,14 +18,16 @@ public:
     LoudnessCalculator(LoudnessCalculator &&) = default;
     LoudnessCalculator &operator=(const LoudnessCalculator &) = delete;
 
-    void CalcLoudness(std::span<const sample> buffer);
+    /* buffer contains the end of the audio of the last elapsedSamples samples, it may be empty if it was silent */
+    void CalcLoudness(std::span<const sample> buffer, size_t elapsedSamples);
     void GetLoudness(float &rmsLeft, float &rmsRight, float &peakLeft, float &peakRight) const;
     void Reset();
 
 private:
     static float calcAlpha(float lowpassFreq, uint32_t sampleRate);
 
-    float lpAlpha;
+    /* log2(1 - alpha) of a one pole lowpass filter, so the decay over n samples is exp2(n * lpDecayLog2) */
+    float lpDecayLog2;
     float avgVolLeftSq = 0.0f;
     float avgVolRightSq = 0.0f;
 
@@ -3,154 +3,116 @@
 #include <algorithm>
 #include <cassert>
 
-LowLatencyRingbuffer::LowLatencyRingbuffer()
+LowLatencyRingbuffer::LowLatencyRingbuffer() : buffer(CAPACITY, sample{0.0f, 0.0f})
 {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
     Reset();
 }
 
 void LowLatencyRingbuffer::Reset()
 {
-    std::unique_lock l(mtx);
-    dataCount = 0;
-    dataPos = 0;
-    freeCount = buffer.size();
-    freePos = 0;
+    readCount.store(writeCount.load());
 }
 
 void LowLatencyRingbuffer::SetNumBuffers(size_t numBuffers)
 {
-    std::unique_lock l(mtx);
-
     /* Cannot buffer nothing. There must be always one read chunk in the ringbuffer. */
     if (numBuffers == 0)
         numBuffers = 1;
     this->numBuffers = numBuffers;
 }
 
-void LowLatencyRingbuffer::Put(std::span<sample> inBuffer)
+void LowLatencyRingbuffer::Put(std::span<const sample> inBuffer)
 {
-    lastPut = inBuffer.size();
-    std::unique_lock l(mtx);
-
-    /* Increase buffer size if last put an last take can't fit in the buffer.
-     * This avoids a stuck ringbuffer when the input/output chunks become to large. */
-    size_t bufferedNumBuffers = numBuffers;
-    size_t bufferedLastTake = lastTake;
-    size_t requiredBufferSize = bufferedNumBuffers * bufferedLastTake + lastPut;
-
-    if (buffer.size() < requiredBufferSize)
-        IncreaseBufferSize(requiredBufferSize);
+    assert(inBuffer.size() <= CAPACITY);
+    const size_t write = writeCount.load(std::memory_order_relaxed);
 
     /* Wait as long there is still data in the ringbuffer and the receiver is able to read
-     * at least an entire chunk (or multiples). */
-    while (dataCount > bufferedNumBuffers * bufferedLastTake) {
-        cv.wait(l);
-        bufferedNumBuffers = numBuffers;
-        bufferedLastTake = lastTake;
-        requiredBufferSize = bufferedNumBuffers * bufferedLastTake + lastPut;
-        if (buffer.size() < requiredBufferSize)
-            IncreaseBufferSize(requiredBufferSize);
+     * at least an entire chunk (or multiples). Since the buffer doesn't grow anymore, the fill level is
+     * limited so that the new data always fits. */
+    while (true) {
+        const uint32_t seq = takeSeq.load(std::memory_order_acquire);
+        const size_t dataCount = write - readCount.load(std::memory_order_acquire);
+        const size_t targetCount = numBuffers * lastTake;
+        if (dataCount <= std::min(targetCount, CAPACITY - inBuffer.size())) {
+            if (targetCount > CAPACITY - inBuffer.size())
+                overruns.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        takeSeq.wait(seq, std::memory_order_acquire);
     }
 
-    while (inBuffer.size() > 0) {
-        const size_t elementsPut = PutSome(inBuffer);
-        inBuffer = inBuffer.subspan(elementsPut);
-    }
+    const size_t pos = write & (CAPACITY - 1);
+    const size_t beforeWraparoundSize = std::min(inBuffer.size(), CAPACITY - pos);
+    std::copy_n(inBuffer.begin(), beforeWraparoundSize, buffer.begin() + static_cast<std::ptrdiff_t>(pos));
+    std::copy(inBuffer.begin() + static_cast<std::ptrdiff_t>(beforeWraparoundSize), inBuffer.end(), buffer.begin());
+
+    writeCount.store(write + inBuffer.size(), std::memory_order_release);
 }
 
 void LowLatencyRingbuffer::Take(std::span<sample> outBuffer)
 {
     lastTake = outBuffer.size();
 
-    /* I know this isn't entirely realtime safe, but it's better than nothing... */
-    std::unique_lock l(mtx, std::try_to_lock);
-    if (!l.owns_lock() || outBuffer.size() > dataCount) {
+    const size_t read = readCount.load(std::memory_order_relaxed);
+    const size_t dataCount = writeCount.load(std::memory_order_acquire) - read;
+    if (outBuffer.size() > dataCount) {
+        if (dataCount == 0)
+            underruns.fetch_add(1, std::memory_order_relaxed);
+        else
+            partialTakes.fetch_add(1, std::memory_order_relaxed);
         std::fill(outBuffer.begin(), outBuffer.end(), sample{0.0f, 0.0f});
+        /* the producer may be waiting for a larger lastTake */
+        takeSeq.fetch_add(1, std::memory_order_release);
+        takeSeq.notify_one();
         return;
     }
 
-    while (outBuffer.size() > 0) {
-        const size_t elementsTaken = TakeSome(outBuffer);
-        outBuffer = outBuffer.subspan(elementsTaken);
-    }
-
-    cv.notify_one();
-}
-
-size_t LowLatencyRingbuffer::PutSome(std::span<sample> inBuffer)
-{
-    assert(inBuffer.size() <= freeCount);
-    const bool wrap = inBuffer.size() >= (buffer.size() - freePos);
-
-    size_t putCount;
-    size_t newFreePos;
-    if (wrap) {
-        putCount = buffer.size() - freePos;
-        newFreePos = 0;
-    } else {
-        putCount = inBuffer.size();
-        newFreePos = freePos + inBuffer.size();
+    const size_t pos = read & (CAPACITY - 1);
+    const size_t beforeWraparoundSize = std::min(outBuffer.size(), CAPACITY - pos);
+    std::copy_n(buffer.begin() + static_cast<std::ptrdiff_t>(pos), beforeWraparoundSize, outBuffer.begin());
+    std::copy_n(
+        buffer.begin(),
+        outBuffer.size() - beforeWraparoundSize,
+        outBuffer.begin() + static_cast<std::ptrdiff_t>(beforeWraparoundSize)
+    );
+
+    readCount.store(read + outBuffer.size(), std::memory_order_release);
+    takeSeq.fetch_add(1, std::memory_order_release);
+    takeSeq.notify_one();
+
+    size_t mark = markPos.load(std::memory_order_acquire);
+    if (mark != NO_MARK && mark < read + outBuffer.size()) {
+        const std::chrono::steady_clock::duration latency =
+            std::chrono::steady_clock::now().time_since_epoch()
+            - std::chrono::steady_clock::duration(markTime.load(std::memory_order_relaxed));
+        // if the producer marked a new command in the meantime, this one is dropped
+        if (markPos.compare_exchange_strong(mark, NO_MARK, std::memory_order_relaxed)) {
+            const auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(latency).count();
+            size_t bucket = 0;
+            while (bucket < LATENCY_BUCKETS - 1 && millis >= (int64_t(1) << bucket))
+                bucket++;
+            commandLatency[bucket].fetch_add(1, std::memory_order_relaxed);
+        }
     }
-
-    std::copy_n(inBuffer.begin(), putCount, buffer.begin() + freePos);
-
-    freePos = newFreePos;
-    assert(freeCount >= putCount);
-    freeCount -= putCount;
-    dataCount += putCount;
-    return putCount;
 }
 
-size_t LowLatencyRingbuffer::TakeSome(std::span<sample> outBuffer)
+void LowLatencyRingbuffer::MarkCommand(std::chrono::steady_clock::time_point commandTime)
 {
-    assert(outBuffer.size() <= dataCount);
-    const bool wrap = outBuffer.size() >= (buffer.size() - dataPos);
-
-    size_t takeCount;
-    size_t newDataPos;
-    if (wrap) {
-        takeCount = buffer.size() - dataPos;
-        newDataPos = 0;
-    } else {
-        takeCount = outBuffer.size();
-        newDataPos = dataPos + outBuffer.size();
-    }
-
-    std::copy_n(buffer.begin() + dataPos, takeCount, outBuffer.begin());
-
-    dataPos = newDataPos;
-    freeCount += takeCount;
-    assert(dataCount >= takeCount);
-    dataCount -= takeCount;
-    return takeCount;
+    markTime.store(commandTime.time_since_epoch().count(), std::memory_order_relaxed);
+    markPos.store(writeCount.load(std::memory_order_relaxed), std::memory_order_release);
 }
 
-void LowLatencyRingbuffer::IncreaseBufferSize(size_t requiredBufferSize)
+LowLatencyRingbuffer::Stats LowLatencyRingbuffer::GetStats() const
 {
-    /* mtx LOCK MUST BE HELD WHEN CALLING THIS FUNCTION. */
-    if (buffer.size() >= requiredBufferSize)
-        return;
-
-    /* First we have to move the data of the current buffer to the beginning to avoid
-     * silence inserted at the wraparound address. This has some oveheader, but it
-     * shouldn't occur often, and if it does occur, it never occurs again
-     * (unless the chunk sizes increase once again). */
-    std::vector<sample> backupBuffer(dataCount);
-    const size_t beforeWraparoundSize = std::min<size_t>(dataCount, buffer.size() - dataPos);
-    std::span<sample> beforeWraparound(buffer.begin() + dataPos, beforeWraparoundSize);
-    const size_t afterWraparoundSize = dataCount - beforeWraparoundSize;
-    std::span<sample> afterWraparound(buffer.begin(), afterWraparoundSize);
-    std::copy_n(buffer.begin() + dataPos, beforeWraparoundSize, backupBuffer.begin());
-    std::copy_n(buffer.begin(), afterWraparoundSize, backupBuffer.begin() + beforeWraparoundSize);
-    assert(beforeWraparoundSize + afterWraparoundSize == dataCount);
-    assert(dataCount <= requiredBufferSize);
-
-    /* resize buffer and restore data */
-    buffer.resize(requiredBufferSize);
-    std::copy_n(backupBuffer.begin(), dataCount, buffer.begin());
-    std::fill(buffer.begin() + dataCount, buffer.end(), sample{0.0f, 0.0f});
-    // dataCount remains unchanged
-    dataPos = 0;
-    freeCount = buffer.size() - dataCount;
-    freePos = dataCount;
+    Stats stats;
+    stats.underruns = underruns.load(std::memory_order_relaxed);
+    stats.partialTakes = partialTakes.load(std::memory_order_relaxed);
+    stats.overruns = overruns.load(std::memory_order_relaxed);
+    const size_t read = readCount.load(std::memory_order_acquire);
+    stats.fillLevel = writeCount.load(std::memory_order_acquire) - read;
+    stats.targetLevel = numBuffers * lastTake;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++)
+        stats.commandLatency[i] = commandLatency[i].load(std::memory_order_relaxed);
+    return stats;
 }
@@ -2,16 +2,22 @@
 
 #include "Types.hpp"
 
+#include <array>
 #include <atomic>
-#include <condition_variable>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <span>
 #include <vector>
 
-/* This Ringbuffer dynamically adjusts its size to only buffer as much data
+/* This Ringbuffer dynamically adjusts its fill level to only buffer as much data
  * as both reader and writer need for minimum amount of buffering.
  * SetNumBuffers (default=1) can be used to create an additional safety margin
- * if low latency is not stable. */
+ * if low latency is not stable.
+ *
+ * There must be only one thread calling Put (the producer) and one thread calling Take (the consumer).
+ * Take never blocks or allocates, so it is safe to call from an audio callback. Put blocks until
+ * the consumer has taken enough data. Memory is allocated once for the largest supported fill level. */
 
 class LowLatencyRingbuffer
 {
@@ -20,25 +26,56 @@ public:
     LowLatencyRingbuffer(const LowLatencyRingbuffer &) = delete;
     LowLatencyRingbuffer &operator=(const LowLatencyRingbuffer &) = delete;
 
+    /* must not be called while Put or Take are running */
     void Reset();
     void SetNumBuffers(size_t numBuffers);
 
-    void Put(std::span<sample> inBuffer);
+    void Put(std::span<const sample> inBuffer);
     void Take(std::span<sample> outBuffer);
 
-private:
-    size_t PutSome(std::span<sample> inBuffer);
-    size_t TakeSome(std::span<sample> outBuffer);
-    void IncreaseBufferSize(size_t requiredBufferSize);
+    /* Called by the producer after a command (e.g. play). Once the next sample put into the ringbuffer has been
+     * taken, the time since commandTime is added to the latency histogram. Only the latest command is tracked. */
+    void MarkCommand(std::chrono::steady_clock::time_point commandTime);
+
+    /* power of two, 1.3 s at 48 kHz */
+    static inline const size_t CAPACITY = 65536;
+    /* bucket 0 counts latencies below 1 ms, bucket i from 2^(i-1) ms to 2^i ms, the last one everything above */
+    static inline const size_t LATENCY_BUCKETS = 12;
+
+    struct Stats
+    {
+        uint64_t underruns = 0;       // Take found no data at all and output silence
+        uint64_t partialTakes = 0;    // Take found some data, but not enough, and output silence
+        uint64_t overruns = 0;        // Put had to limit the fill level to CAPACITY
+        size_t fillLevel = 0;
+        size_t targetLevel = 0;
+        std::array<uint64_t, LATENCY_BUCKETS> commandLatency{};
+    };
+
+    /* may be called from any thread, the values are not taken at exactly the same time */
+    Stats GetStats() const;
 
-    std::mutex mtx;
-    std::condition_variable cv;
+private:
     std::vector<sample> buffer;
-    size_t freePos = 0;
-    size_t freeCount = 0;
-    size_t dataPos = 0;
-    size_t dataCount = 0;
-    std::atomic<size_t> lastTake = 0;    // this variable may be read without holding a lock
-    size_t lastPut = 0;
-    size_t numBuffers = 1;
+
+    /* Total number of samples ever written and read. Only the producer writes writeCount and only
+     * the consumer writes readCount, so the fill level is always writeCount - readCount.
+     * Both counters are kept on separate cache lines, so producer and consumer don't slow each other down. */
+    alignas(64) std::atomic<size_t> writeCount = 0;
+    alignas(64) std::atomic<size_t> readCount = 0;
+
+    /* Incremented by every Take, even if it had to output silence because lastTake grew.
+     * The producer waits for it to change (futex based on Linux). */
+    std::atomic<uint32_t> takeSeq = 0;
+    std::atomic<size_t> lastTake = 0;
+    std::atomic<size_t> numBuffers = 1;
+
+    /* statistics, each counter is only incremented by one thread */
+    static inline const size_t NO_MARK = SIZE_MAX;
+    std::atomic<uint64_t> underruns = 0;
+    std::atomic<uint64_t> partialTakes = 0;
+    std::atomic<uint64_t> overruns = 0;
+    std::atomic<size_t> markPos = NO_MARK;
+    std::atomic<std::chrono::steady_clock::rep> markTime = 0;
+    std::array<std::atomic<uint64_t>, LATENCY_BUCKETS> commandLatency{};
 };
@@ -1,13 +1,38 @@
 #include "MP2KChn.hpp"
 
+#include "ChannelPool.hpp"
 #include "MP2KTrack.hpp"
 
 #include <cassert>
+#include <utility>
 
-MP2KChn::MP2KChn(MP2KTrack *track, const Note &note, const ADSR &env) : note(note), env(env)
+MP2KChn::MP2KChn(MP2KTrack *track, const Note &note, const ADSR &env) : trackOrg(track), note(note), env(env)
 {
-    this->track = track;
-    this->trackOrg = track;
+    LinkToTrack();
+}
+
+MP2KChn::MP2KChn(const MP2KChn &other, MP2KTrack *trackOrg) :
+    trackOrg(trackOrg),
+    rs(other.rs ? other.rs->Clone() : nullptr),
+    note(other.note),
+    env(other.env),
+    envState(other.envState),
+    pos(other.pos),
+    interPos(other.interPos),
+    freq(other.freq),
+    stop(other.stop)
+{
+}
+
+MP2KChn::~MP2KChn()
+{
+    RemoveFromTrack();
+}
+
+void MP2KChn::LinkToTrack() noexcept
+{
+    assert(track == nullptr);
+    track = trackOrg;
 
     prev = nullptr;
     next = track->channels;
@@ -18,11 +43,6 @@ MP2KChn::MP2KChn(MP2KTrack *track, const Note &note, const ADSR &env) : note(not
     track->channels = this;
 }
 
-MP2KChn::~MP2KChn()
-{
-    RemoveFromTrack();
-}
-
 void MP2KChn::RemoveFromTrack() noexcept
 {
     if (track == nullptr)
@@ -54,3 +74,8 @@ void MP2KChn::Kill() noexcept
     envState = EnvState::DEAD;
     RemoveFromTrack();
 }
+
+void MP2KChn::Recycle(ChannelRecycler &recycler)
+{
+    recycler.PutResampler(std::move(rs));
+}
@@ -5,15 +5,21 @@
 
 #include <memory>
 
+class ChannelRecycler;
 struct MP2KTrack;
 
 struct MP2KChn
 {
     MP2KChn(MP2KTrack *track, const Note &note, const ADSR &env);
+    /* Copies the state of other, e.g. for a snapshot (see MP2KSnapshot). The copy belongs to trackOrg,
+     * but it is not linked into the track's list of channels until LinkToTrack is called. */
+    MP2KChn(const MP2KChn &other, MP2KTrack *trackOrg);
     MP2KChn(const MP2KChn &) = delete;
     MP2KChn &operator=(const MP2KChn &) = delete;
     virtual ~MP2KChn();
 
+    /* inserts the channel at the front of trackOrg's channel list */
+    void LinkToTrack() noexcept;
     void RemoveFromTrack() noexcept;
 
     bool IsReleasing() const noexcept;
@@ -22,6 +28,8 @@ struct MP2KChn
     // TODO: Does TickNote really have to deviate between channel types?
     virtual bool TickNote() noexcept = 0;
     virtual VoiceFlags GetVoiceType() const noexcept = 0;
+    /* hands the heap allocated parts over to recycler, right before the channel is removed from its pool */
+    virtual void Recycle(ChannelRecycler &recycler);
 
     /* linked list of channels inside a track. */
     MP2KChn *prev = nullptr;
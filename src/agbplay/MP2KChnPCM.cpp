@@ -2,6 +2,7 @@
 
 #include "Constants.hpp"
 #include "Debug.hpp"
+#include "DecodedSampleCache.hpp"
 #include "MP2KContext.hpp"
 #include "Util.hpp"
 #include "Xcept.hpp"
@@ -37,8 +38,11 @@ MP2KChnPCM::MP2KChnPCM(MP2KContext &ctx, MP2KTrack *track, SampleInfo sInfo, ADS
         return;
     }
 
-    const ResamplerType t = fixed ? ctx.agbplaySoundMode.resamplerTypeFixed : ctx.agbplaySoundMode.resamplerTypeNormal;
-    this->rs = Resampler::MakeResampler(t);
+    ResamplerType t = fixed ? ctx.agbplaySoundMode.resamplerTypeFixed : ctx.agbplaySoundMode.resamplerTypeNormal;
+    // the mix bus is resampled to the output rate with high quality already
+    if (ctx.agbplaySoundMode.nativeMixRate)
+        t = ResamplerType::LINEAR;
+    this->rs = ctx.channelRecycler.TakeResampler(t, ctx.agbplaySoundMode.resamplerPolyphase);
 
     if (sInfo.gamefreakCompressed) {
         type = Type::GAMEFREAK_DPCM;
@@ -48,6 +52,7 @@ MP2KChnPCM::MP2KChnPCM(MP2KContext &ctx, MP2KTrack *track, SampleInfo sInfo, ADS
             envState = EnvState::DEAD;
             return;
         }
+        cachedSamples = ctx.rom.GetDecodedSampleCache().GetGFDPCM(this->sInfo);
     } else if (sInfo.endPos >= 0x80000000) {
         // Mario Power Tennis compressed instruments have a 'negative' length
         // strictly speaking, these are originally only available at 'fixed' frequency,
@@ -60,6 +65,9 @@ MP2KChnPCM::MP2KChnPCM(MP2KContext &ctx, MP2KTrack *track, SampleInfo sInfo, ADS
             envState = EnvState::DEAD;
             return;
         }
+        // MPT compressed sample cannot loop
+        this->sInfo.loopEnabled = false;
+        cachedSamples = ctx.rom.GetDecodedSampleCache().GetCamelotADPCM(this->sInfo);
     } else {
         type = Type::PCM;
         if (!ctx.rom.ValidRange(sInfo.samplePos, 16 + sInfo.endPos)) {
@@ -67,9 +75,41 @@ MP2KChnPCM::MP2KChnPCM(MP2KContext &ctx, MP2KTrack *track, SampleInfo sInfo, ADS
             envState = EnvState::DEAD;
             return;
         }
+        if (ctx.mixer.IsSampleBankEnabled())
+            cachedSamples = ctx.rom.GetDecodedSampleCache().GetPCM(this->sInfo);
+    }
+
+    /* Samples with a broken loop (loop start beyond the end) keep using the fetch callbacks,
+     * which is where this odd case has always been handled. */
+    if (ctx.mixer.IsSampleBankEnabled() && !cachedSamples.empty()
+        && (!this->sInfo.loopEnabled || DecodedSampleCache::HasValidLoop(this->sInfo))) {
+        assert(rs->LeadIn() <= DecodedSampleCache::PAD_FRONT);
+        directRead = true;
+        directPos = DecodedSampleCache::PAD_FRONT - rs->LeadIn();
     }
 }
 
+MP2KChnPCM::MP2KChnPCM(const MP2KChnPCM &other, MP2KContext &ctx, MP2KTrack *trackOrg) :
+    MP2KChn(other, trackOrg),
+    type(other.type),
+    ctx(ctx),
+    sInfo(other.sInfo),
+    fixed(other.fixed),
+    isSynth(other.isSynth),
+    cachedSamples(other.cachedSamples),
+    directRead(other.directRead),
+    directPos(other.directPos),
+    directScratch(other.directScratch),
+    envInterStep(other.envInterStep),
+    envLevelCur(other.envLevelCur),
+    envLevelPrev(other.envLevelPrev),
+    leftVolCur(other.leftVolCur),
+    leftVolPrev(other.leftVolPrev),
+    rightVolCur(other.rightVolCur),
+    rightVolPrev(other.rightVolPrev)
+{
+}
+
 void MP2KChnPCM::Process(std::span<sample> buffer, const MixingArgs &args)
 {
     if (envState == EnvState::DEAD)
@@ -94,10 +134,7 @@ void MP2KChnPCM::Process(std::span<sample> buffer, const MixingArgs &args)
     cargs.lVol = vol.fromVolLeft;
     cargs.rVol = vol.fromVolRight;
 
-    if (fixed && !isSynth)
-        cargs.interStep = float(args.fixedModeRate) * args.sampleRateInv;
-    else
-        cargs.interStep = freq * args.sampleRateInv;
+    cargs.interStep = getInterStep(args);
 
     if (isSynth) {
         cargs.interStep /= 64.f;    // different scale for GS
@@ -117,6 +154,23 @@ void MP2KChnPCM::Process(std::span<sample> buffer, const MixingArgs &args)
     updateVolFade();
 }
 
+void MP2KChnPCM::Skip(size_t numSamples, const MixingArgs &args)
+{
+    if (envState == EnvState::DEAD)
+        return;
+    stepEnvelope();
+    if (envState == EnvState::DEAD)
+        return;
+    if (numSamples == 0)
+        return;
+
+    if (isSynth)
+        skipSynth(numSamples, getInterStep(args) / 64.f);
+    else
+        skipNormal(numSamples, getInterStep(args));
+    updateVolFade();
+}
+
 void MP2KChnPCM::SetVol(uint16_t vol, int16_t pan)
 {
     if (!stop) {
@@ -288,6 +342,14 @@ void MP2KChnPCM::updateVolFade()
     rightVolPrev = rightVolCur;
 }
 
+float MP2KChnPCM::getInterStep(const MixingArgs &args) const
+{
+    if (fixed && !isSynth)
+        return float(args.fixedModeRate) * args.sampleRateInv;
+    else
+        return freq * args.sampleRateInv;
+}
+
 /*
  * private MP2KChnPCM
  */
@@ -298,18 +360,23 @@ void MP2KChnPCM::processNormal(std::span<sample> buffer, ProcArgs &cargs)
         return;
     assert(ctx.mixer.scratchBuffer.size() == buffer.size());
 
-    FetchCallback cb;
-    if (type == Type::PCM)
-        cb = std::bind(&MP2KChnPCM::sampleFetchCallback, this, std::placeholders::_1, std::placeholders::_2);
-    else if (type == Type::GAMEFREAK_DPCM)
-        cb =
-            std::bind(&MP2KChnPCM::sampleFetchCallbackGFDPCMDecomp, this, std::placeholders::_1, std::placeholders::_2);
-    else if (type == Type::CAMELOT_ADPCM)
-        cb = std::bind(&MP2KChnPCM::sampleFetchCallbackMPTDecomp, this, std::placeholders::_1, std::placeholders::_2);
-    else
+    /* pass the fetch function as lambda, so the resampler can inline it */
+    auto process = [&](auto &&source) { return rs->Process(ctx.mixer.scratchBuffer, cargs.interStep, source); };
+
+    bool running = false;
+    if (directRead) {
+        running = processDirect(cargs.interStep);
+    } else if (type == Type::PCM) {
+        running = process([this](auto &fetchBuffer, size_t samplesRequired) {
+            return sampleFetchCallback(fetchBuffer, samplesRequired);
+        });
+    } else if (type == Type::GAMEFREAK_DPCM || type == Type::CAMELOT_ADPCM) {
+        running = process([this](auto &fetchBuffer, size_t samplesRequired) {
+            return sampleFetchCallbackDecoded(fetchBuffer, samplesRequired);
+        });
+    } else {
         assert(false);
-
-    const bool running = rs->Process(ctx.mixer.scratchBuffer, cargs.interStep, cb);
+    }
 
     for (size_t i = 0; i < buffer.size(); i++) {
         const float samp = ctx.mixer.scratchBuffer[i];
@@ -322,6 +389,53 @@ void MP2KChnPCM::processNormal(std::span<sample> buffer, ProcArgs &cargs)
         Kill();
 }
 
+/* Resample straight from the padded sample in the DecodedSampleCache. The position is kept
+ * within the first loop iteration after the loop start, so the padding after the sample end
+ * covers the resampler's lookahead unless the pitch is extremely high. */
+bool MP2KChnPCM::processDirect(float interStep)
+{
+    const std::span<float> outBuffer = ctx.mixer.scratchBuffer;
+    const size_t required = rs->SamplesRequired(outBuffer.size(), interStep);
+
+    const float *src;
+    if (directPos + required <= cachedSamples.size()) [[likely]] {
+        src = &cachedSamples[directPos];
+    } else {
+        directScratch.resize(required);
+        for (size_t i = 0; i < required; i++)
+            directScratch[i] = cachedSampleAt(directPos + i);
+        src = directScratch.data();
+    }
+
+    return advanceDirect(required, rs->ProcessDirect(outBuffer, interStep, src));
+}
+
+/* Moves directPos by the consumed samples, returns whether the sample continues after required more samples. */
+bool MP2KChnPCM::advanceDirect(size_t required, size_t consumed)
+{
+    const size_t sampleEnd = DecodedSampleCache::PAD_FRONT + sInfo.endPos;
+
+    /* the fetch callbacks report the end of stream as soon as the last sample has been fetched */
+    const bool running = sInfo.loopEnabled || directPos + required < sampleEnd;
+
+    directPos += consumed;
+    if (sInfo.loopEnabled && directPos >= sampleEnd) {
+        const size_t loopStart = DecodedSampleCache::PAD_FRONT + sInfo.loopPos;
+        directPos = loopStart + (directPos - loopStart) % (sInfo.endPos - sInfo.loopPos);
+    }
+    return running;
+}
+
+float MP2KChnPCM::cachedSampleAt(size_t i) const
+{
+    if (i < cachedSamples.size())
+        return cachedSamples[i];
+    if (!sInfo.loopEnabled)
+        return 0.0f;
+    const size_t loopStart = DecodedSampleCache::PAD_FRONT + sInfo.loopPos;
+    return cachedSamples[loopStart + (i - loopStart) % (sInfo.endPos - sInfo.loopPos)];
+}
+
 void MP2KChnPCM::processModPulse(std::span<sample> buffer, ProcArgs &cargs, float samplesPerBufferInv)
 {
 #define DUTY_BASE 2
@@ -383,22 +497,8 @@ void MP2KChnPCM::processModPulse(std::span<sample> buffer, ProcArgs &cargs, floa
 
 void MP2KChnPCM::processSaw(std::span<sample> buffer, ProcArgs &cargs)
 {
-    const uint32_t fix = 0x70;
-
     for (size_t i = 0; i < buffer.size(); i++) {
-        /*
-         * Sorry that the baseSamp calculation looks ugly.
-         * For accuracy it's a 1 to 1 translation of the original assembly code
-         * Could probably be reimplemented easier. Not sure if it's a perfect saw wave
-         */
-        interPos += cargs.interStep;
-        if (interPos >= 1.0f)
-            interPos -= 1.0f;
-        uint32_t var1 = uint32_t(interPos * 256) - fix;
-        uint32_t var2 = uint32_t(interPos * 65536.0f) << 17;
-        uint32_t var3 = var1 - (var2 >> 27);
-        pos = var3 + uint32_t(int32_t(pos) >> 1);
-
+        stepSaw(cargs.interStep);
         const float baseSamp = float((int32_t)pos) / 256.0f;
 
         buffer[i].left += baseSamp * cargs.lVol;
@@ -430,6 +530,63 @@ void MP2KChnPCM::processTri(std::span<sample> buffer, ProcArgs &cargs)
     }
 }
 
+void MP2KChnPCM::skipNormal(size_t numSamples, float interStep)
+{
+    bool running = false;
+    if (directRead) {
+        const size_t required = rs->SamplesRequired(numSamples, interStep);
+        running = advanceDirect(required, rs->SkipDirect(numSamples, interStep));
+    } else if (type == Type::PCM) {
+        running = rs->Skip(numSamples, interStep, [this](auto &fetchBuffer, size_t samplesRequired) {
+            return sampleFetchCallback(fetchBuffer, samplesRequired);
+        });
+    } else if (type == Type::GAMEFREAK_DPCM || type == Type::CAMELOT_ADPCM) {
+        running = rs->Skip(numSamples, interStep, [this](auto &fetchBuffer, size_t samplesRequired) {
+            return sampleFetchCallbackDecoded(fetchBuffer, samplesRequired);
+        });
+    } else {
+        assert(false);
+    }
+
+    if (!running)
+        Kill();
+}
+
+/* only the oscillator state of the synth process functions */
+void MP2KChnPCM::skipSynth(size_t numSamples, float interStep)
+{
+    if (type == Type::SYNTH_PWM && envInterStep == 0)
+        pos += uint32_t(sInfo.samplePtr[3] << 24);    // DUTY_STEP, see processModPulse
+
+    for (size_t i = 0; i < numSamples; i++) {
+        if (type == Type::SYNTH_SAWTOOTH) {
+            stepSaw(interStep);
+        } else {
+            interPos += interStep;
+            if (interPos >= 1.0f)
+                interPos -= 1.0f;
+        }
+    }
+}
+
+void MP2KChnPCM::stepSaw(float interStep)
+{
+    const uint32_t fix = 0x70;
+
+    /*
+     * Sorry that the baseSamp calculation looks ugly.
+     * For accuracy it's a 1 to 1 translation of the original assembly code
+     * Could probably be reimplemented easier. Not sure if it's a perfect saw wave
+     */
+    interPos += interStep;
+    if (interPos >= 1.0f)
+        interPos -= 1.0f;
+    uint32_t var1 = uint32_t(interPos * 256) - fix;
+    uint32_t var2 = uint32_t(interPos * 65536.0f) << 17;
+    uint32_t var3 = var1 - (var2 >> 27);
+    pos = var3 + uint32_t(int32_t(pos) >> 1);
+}
+
 bool MP2KChnPCM::sampleFetchCallback(std::vector<float> &fetchBuffer, size_t samplesRequired)
 {
     if (fetchBuffer.size() >= samplesRequired)
@@ -459,47 +616,26 @@ bool MP2KChnPCM::sampleFetchCallback(std::vector<float> &fetchBuffer, size_t sam
     return true;
 }
 
-bool MP2KChnPCM::sampleFetchCallbackGFDPCMDecomp(std::vector<float> &fetchBuffer, size_t samplesRequired)
+bool MP2KChnPCM::sampleFetchCallbackDecoded(std::vector<float> &fetchBuffer, size_t samplesRequired)
 {
-    const size_t DPCM_BLOCK_SIZE = 64;
     if (fetchBuffer.size() >= samplesRequired)
         return true;
     size_t samplesToFetch = samplesRequired - fetchBuffer.size();
     size_t i = fetchBuffer.size();
     fetchBuffer.resize(samplesRequired);
 
-    std::array<int8_t, DPCM_BLOCK_SIZE> decodeBuffer;
-    size_t decodedBlockIdx = ~static_cast<size_t>(0);
-
     do {
         size_t samplesTilLoop = sInfo.endPos - pos;
         size_t thisFetch = std::min(samplesTilLoop, samplesToFetch);
 
         samplesToFetch -= thisFetch;
-        do {
-            const size_t currentBlock = pos / DPCM_BLOCK_SIZE;
-            if (decodedBlockIdx != currentBlock) [[unlikely]] {
-                static const std::array<int8_t, 16> deltaTable = {
-                    0, 1, 4, 9, 16, 25, 36, 49, -64, -49, -36, -25, -16, -9, -4, -1
-                };
-
-                const size_t currentBlockPos = currentBlock * 0x21;
-
-                int8_t acc = sInfo.samplePtr[currentBlockPos];
-                decodeBuffer[0] = acc;
-                acc += deltaTable[sInfo.samplePtr[currentBlockPos + 1] & 0xF];
-                decodeBuffer[1] = acc;
-                for (size_t j = 2, h = 2; j < DPCM_BLOCK_SIZE; j += 2, h++) {
-                    acc += deltaTable[(sInfo.samplePtr[currentBlockPos + h] & 0xF0) >> 4];
-                    decodeBuffer[j + 0] = acc;
-                    acc += deltaTable[sInfo.samplePtr[currentBlockPos + h] & 0xF];
-                    decodeBuffer[j + 1] = acc;
-                }
-                decodedBlockIdx = currentBlock;
-            }
-
-            fetchBuffer[i++] = static_cast<float>(decodeBuffer[pos++ % DPCM_BLOCK_SIZE]) / 128.0f;
-        } while (--thisFetch > 0);
+        std::copy_n(
+            cachedSamples.begin() + static_cast<std::ptrdiff_t>(DecodedSampleCache::PAD_FRONT + pos),
+            thisFetch,
+            fetchBuffer.begin() + static_cast<std::ptrdiff_t>(i)
+        );
+        i += thisFetch;
+        pos += static_cast<uint32_t>(thisFetch);
 
         if (pos >= sInfo.endPos) {
             if (sInfo.loopEnabled) {
@@ -512,53 +648,3 @@ bool MP2KChnPCM::sampleFetchCallbackGFDPCMDecomp(std::vector<float> &fetchBuffer
     } while (samplesToFetch > 0);
     return true;
 }
-
-bool MP2KChnPCM::sampleFetchCallbackMPTDecomp(std::vector<float> &fetchBuffer, size_t samplesRequired)
-{
-    if (fetchBuffer.size() >= samplesRequired)
-        return true;
-    size_t samplesToFetch = samplesRequired - fetchBuffer.size();
-    size_t i = fetchBuffer.size();
-    fetchBuffer.resize(samplesRequired);
-
-    do {
-        size_t samplesTilLoop = sInfo.endPos - pos;
-        size_t thisFetch = std::min(samplesTilLoop, samplesToFetch);
-
-        samplesToFetch -= thisFetch;
-        do {
-            // once again, I just took over the assembly implementation
-            // there is probably plenty of room to make this nicer, but it at least works for now
-            bool loNibble = pos & 1;
-            uint32_t samplePos = pos++ >> 1u;
-            int8_t data = sInfo.samplePtr[samplePos];
-
-            // 4 bit nibble is shifted up to bit 31..28
-            int32_t nibble;
-            if (loNibble)
-                nibble = (int32_t(data) << 28) & 0xF0000000;
-            else
-                nibble = (int32_t(data) << 24) & 0xF0000000;
-
-            // in the ARM ASM you can easily just shift by more than 31, but this does not work on x86/C++
-            if (shiftMPTcompressed <= 63) {
-                int32_t actualShift = (int32_t)(shiftMPTcompressed >> 1u);
-                levelMPTcompressed = int16_t(levelMPTcompressed + (nibble >> actualShift));
-            }
-
-            if (nibble & 0x80000000)
-                nibble = -nibble;
-            shiftMPTcompressed = uint8_t(shiftMPTcompressed + 4);
-            shiftMPTcompressed = uint8_t((uint32_t)shiftMPTcompressed - ((uint32_t)nibble >> 28u));
-
-            fetchBuffer[i++] = float(levelMPTcompressed) / 128.0f;
-        } while (--thisFetch > 0);
-
-        if (pos >= sInfo.endPos) {
-            // MPT compressed sample cannot loop
-            std::fill(fetchBuffer.begin() + i, fetchBuffer.end(), 0.0f);
-            return false;
-        }
-    } while (samplesToFetch > 0);
-    return true;
-}
@@ -7,6 +7,7 @@
 #include <cstdint>
 #include <memory>
 #include <span>
+#include <vector>
 
 struct MP2KContext;
 
@@ -24,10 +25,13 @@ private:
 
 public:
     MP2KChnPCM(MP2KContext &ctx, MP2KTrack *track, SampleInfo sInfo, ADSR env, const Note &note, bool fixed);
+    MP2KChnPCM(const MP2KChnPCM &other, MP2KContext &ctx, MP2KTrack *trackOrg);
     MP2KChnPCM(const MP2KChnPCM &) = delete;
     MP2KChnPCM &operator=(const MP2KChnPCM &) = delete;
 
     void Process(std::span<sample> buffer, const MixingArgs &args);
+    /* Advances like Process for numSamples output samples, without producing any output. */
+    void Skip(size_t numSamples, const MixingArgs &args);
     void SetVol(uint16_t vol, int16_t pan);
     void Release() noexcept override;
     bool IsReleasing() const noexcept;
@@ -39,13 +43,19 @@ private:
     void stepEnvelope();
     void updateVolFade();
     VolumeFade getVol() const;
+    float getInterStep(const MixingArgs &args) const;
     void processNormal(std::span<sample> buffer, ProcArgs &cargs);
     void processModPulse(std::span<sample> buffer, ProcArgs &cargs, float samplesPerBufferInv);
     void processSaw(std::span<sample> buffer, ProcArgs &cargs);
     void processTri(std::span<sample> buffer, ProcArgs &cargs);
+    void skipNormal(size_t numSamples, float interStep);
+    void skipSynth(size_t numSamples, float interStep);
+    void stepSaw(float interStep);
     bool sampleFetchCallback(std::vector<float> &fetchBuffer, size_t samplesRequired);
-    bool sampleFetchCallbackGFDPCMDecomp(std::vector<float> &fetchBuffer, size_t samplesRequires);
-    bool sampleFetchCallbackMPTDecomp(std::vector<float> &fetchBuffer, size_t samplesRequires);
+    bool sampleFetchCallbackDecoded(std::vector<float> &fetchBuffer, size_t samplesRequired);
+    bool processDirect(float interStep);
+    bool advanceDirect(size_t required, size_t consumed);
+    float cachedSampleAt(size_t i) const;
 
     enum class Type {
         INVALID,
@@ -61,8 +71,10 @@ private:
     SampleInfo sInfo;
     bool fixed;
     bool isSynth = false;
-    int16_t levelMPTcompressed = 0;
-    uint8_t shiftMPTcompressed = 0x38;
+    std::span<const float> cachedSamples;    // padded, owned by the ROM's DecodedSampleCache
+    bool directRead = false;                 // resample from cachedSamples without fetch callback
+    size_t directPos = 0;
+    std::vector<float> directScratch;
 
     /* all of these values have pairs of new and old value to allow smooth fades */
     uint8_t envInterStep = 0;
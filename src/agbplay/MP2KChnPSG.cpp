@@ -29,6 +29,26 @@ MP2KChnPSG::MP2KChnPSG(MP2KContext &ctx, MP2KTrack *track, ADSR env, Note note,
     //     (int)env.sus, (int)env.rel);
 }
 
+MP2KChnPSG::MP2KChnPSG(const MP2KChnPSG &other, MP2KContext &ctx, MP2KTrack *trackOrg) :
+    MP2KChn(other, trackOrg),
+    ctx(ctx),
+    useStairstep(other.useStairstep),
+    fastRelease(other.fastRelease),
+    vol(other.vol),
+    pan(other.pan),
+    mp2k_sus_vol_bug_update(other.mp2k_sus_vol_bug_update),
+    envInterStep(other.envInterStep),
+    envLevelCur(other.envLevelCur),
+    envPeak(other.envPeak),
+    envSustain(other.envSustain),
+    envFrameCount(other.envFrameCount),
+    envFadeLevel(other.envFadeLevel),
+    volFade(other.volFade),
+    panCur(other.panCur),
+    panPrev(other.panPrev)
+{
+}
+
 void MP2KChnPSG::SetVol(uint16_t vol, int16_t pan)
 {
     if (stop)
@@ -379,7 +399,20 @@ MP2KChnPSGSquare::MP2KChnPSGSquare(
     };
 
     this->pat = patterns[instrDuty % 4];
-    this->rs = Resampler::MakeResampler(ResamplerType::BLEP);
+    this->rs = ctx.channelRecycler.TakeResampler(ResamplerType::BLEP, ctx.agbplaySoundMode.resamplerPolyphase);
+}
+
+MP2KChnPSGSquare::MP2KChnPSGSquare(const MP2KChnPSGSquare &other, MP2KContext &ctx, MP2KTrack *trackOrg) :
+    MP2KChnPSG(other, ctx, trackOrg),
+    instrDuty(other.instrDuty),
+    pat(other.pat),
+    sweepStartCount(other.sweepStartCount),
+    sweep(other.sweep),
+    sweepEnabled(other.sweepEnabled),
+    sweepConvergence(other.sweepConvergence),
+    sweepCoeff(other.sweepCoeff),
+    sweepTimer(other.sweepTimer)
+{
 }
 
 void MP2KChnPSGSquare::SetPitch(int16_t pitch)
@@ -418,20 +451,11 @@ void MP2KChnPSGSquare::Process(std::span<sample> buffer, MixingArgs &args)
     float rVolStep = (vol.toVolRight - vol.fromVolRight) * args.samplesPerBufferInv;
     float lVol = vol.fromVolLeft;
     float rVol = vol.fromVolRight;
-    float interStep;
-
-    if (sweepEnabled) {
-        // Debug::print("sweepTimer=%f sweepConvergence=%f sweepCoeff=%f resultFreq=%f",
-        //         sweepTimer, sweepConvergence, sweepCoeff, timer2freq(sweepTimer));
-        interStep = 8.0f * timer2freq(sweepTimer) * args.sampleRateInv;
-    } else {
-        interStep = freq * args.sampleRateInv;
-    }
 
     assert(buffer.size() == ctx.mixer.scratchBuffer.size());
-    FetchCallback cb =
-        std::bind(&MP2KChnPSGSquare::sampleFetchCallback, this, std::placeholders::_1, std::placeholders::_2);
-    rs->Process(ctx.mixer.scratchBuffer, interStep, cb);
+    rs->Process(ctx.mixer.scratchBuffer, getInterStep(args), [this](auto &fetchBuffer, size_t samplesRequired) {
+        return sampleFetchCallback(fetchBuffer, samplesRequired);
+    });
 
     for (size_t i = 0; i < buffer.size(); i++) {
         const float samp = ctx.mixer.scratchBuffer[i];
@@ -441,20 +465,26 @@ void MP2KChnPSGSquare::Process(std::span<sample> buffer, MixingArgs &args)
         rVol += rVolStep;
     }
 
-    if (sweepEnabled) {
-        assert(sweepStartCount >= 0);
-        if (sweepStartCount == 0) {
-            sweepTimer *= sweepCoeff;
-            if (isSweepAscending(sweep))
-                sweepTimer = std::min(sweepTimer, sweepConvergence);
-            else
-                sweepTimer = std::max(sweepTimer, sweepConvergence);
-        } else {
-            sweepStartCount -= 128;
-            if (sweepStartCount < 0)
-                sweepStartCount = 0;
-        }
-    }
+    stepSweep();
+}
+
+void MP2KChnPSGSquare::Skip(size_t numSamples, MixingArgs &args)
+{
+    if (envState == EnvState::DEAD)
+        return;
+    stepEnvelope();
+    if (envState == EnvState::DEAD)
+        return;
+
+    updateVolFade();
+
+    if (numSamples == 0)
+        return;
+
+    rs->Skip(numSamples, getInterStep(args), [this](auto &fetchBuffer, size_t samplesRequired) {
+        return sampleFetchCallback(fetchBuffer, samplesRequired);
+    });
+    stepSweep();
 }
 
 VoiceFlags MP2KChnPSGSquare::GetVoiceType() const noexcept
@@ -484,6 +514,35 @@ VoiceFlags MP2KChnPSGSquare::GetVoiceType() const noexcept
     }
 }
 
+float MP2KChnPSGSquare::getInterStep(const MixingArgs &args) const
+{
+    if (sweepEnabled) {
+        // Debug::print("sweepTimer=%f sweepConvergence=%f sweepCoeff=%f resultFreq=%f",
+        //         sweepTimer, sweepConvergence, sweepCoeff, timer2freq(sweepTimer));
+        return 8.0f * timer2freq(sweepTimer) * args.sampleRateInv;
+    } else {
+        return freq * args.sampleRateInv;
+    }
+}
+
+void MP2KChnPSGSquare::stepSweep()
+{
+    if (sweepEnabled) {
+        assert(sweepStartCount >= 0);
+        if (sweepStartCount == 0) {
+            sweepTimer *= sweepCoeff;
+            if (isSweepAscending(sweep))
+                sweepTimer = std::min(sweepTimer, sweepConvergence);
+            else
+                sweepTimer = std::max(sweepTimer, sweepConvergence);
+        } else {
+            sweepStartCount -= 128;
+            if (sweepStartCount < 0)
+                sweepStartCount = 0;
+        }
+    }
+}
+
 bool MP2KChnPSGSquare::sampleFetchCallback(std::vector<float> &fetchBuffer, size_t samplesRequired)
 {
     if (fetchBuffer.size() >= samplesRequired)
@@ -584,7 +643,7 @@ MP2KChnPSGWave::MP2KChnPSGWave(
             wavePtr = dummyWave;
     }
 
-    this->rs = Resampler::MakeResampler(ResamplerType::BLEP);
+    this->rs = ctx.channelRecycler.TakeResampler(ResamplerType::BLEP, ctx.agbplaySoundMode.resamplerPolyphase);
 
     /* wave samples are unsigned by default, so we'll calculate the required
      * DC offset correction */
@@ -631,6 +690,16 @@ MP2KChnPSGWave::MP2KChnPSGWave(
     }
 }
 
+MP2KChnPSGWave::MP2KChnPSGWave(const MP2KChnPSGWave &other, MP2KContext &ctx, MP2KTrack *trackOrg) :
+    MP2KChnPSG(other, ctx, trackOrg),
+    dcCorrection100(other.dcCorrection100),
+    dcCorrection75(other.dcCorrection75),
+    dcCorrection50(other.dcCorrection50),
+    dcCorrection25(other.dcCorrection25),
+    wavePtr(other.wavePtr)
+{
+}
+
 void MP2KChnPSGWave::SetPitch(int16_t pitch)
 {
     freq =
@@ -656,9 +725,9 @@ void MP2KChnPSGWave::Process(std::span<sample> buffer, MixingArgs &args)
     float interStep = freq * args.sampleRateInv;
 
     assert(ctx.mixer.scratchBuffer.size() == buffer.size());
-    FetchCallback cb =
-        std::bind(&MP2KChnPSGWave::sampleFetchCallback, this, std::placeholders::_1, std::placeholders::_2);
-    rs->Process(ctx.mixer.scratchBuffer, interStep, cb);
+    rs->Process(ctx.mixer.scratchBuffer, interStep, [this](auto &fetchBuffer, size_t samplesRequired) {
+        return sampleFetchCallback(fetchBuffer, samplesRequired);
+    });
 
     for (size_t i = 0; i < buffer.size(); i++) {
         const float samp = ctx.mixer.scratchBuffer[i];
@@ -669,6 +738,22 @@ void MP2KChnPSGWave::Process(std::span<sample> buffer, MixingArgs &args)
     }
 }
 
+void MP2KChnPSGWave::Skip(size_t numSamples, MixingArgs &args)
+{
+    stepEnvelope();
+    if (envState == EnvState::DEAD)
+        return;
+
+    updateVolFade();
+
+    if (numSamples == 0)
+        return;
+
+    rs->Skip(numSamples, freq * args.sampleRateInv, [this](auto &fetchBuffer, size_t samplesRequired) {
+        return sampleFetchCallback(fetchBuffer, samplesRequired);
+    });
+}
+
 VoiceFlags MP2KChnPSGWave::GetVoiceType() const noexcept
 {
     return VoiceFlags::PSG_WAVE;
@@ -792,21 +877,23 @@ bool MP2KChnPSGWave::sampleFetchCallback(std::vector<float> &fetchBuffer, size_t
  */
 
 MP2KChnPSGNoise::MP2KChnPSGNoise(MP2KContext &ctx, MP2KTrack *track, uint32_t instrNp, ADSR env, Note note) :
-    MP2KChnPSG(ctx, track, env, note), instrNp(instrNp)
-{
-    /* Noise is first generated at the generators frequency and converted to
-     * AGB's DAC output rate using nearest neighbor.
-     * In order to sound good, we then resample this signal again to our actual
-     * output rate using a bandlimited sinc resampler. */
-    this->rs = Resampler::MakeResampler(ResamplerType::NEAREST);
-    this->srs = Resampler::MakeResampler(ResamplerType::SINC);
-    if ((instrNp & 0x1) == 0) {
-        noiseState = 0x4000;
-        noiseLfsrMask = 0x6000;
-    } else {
-        noiseState = 0x40;
-        noiseLfsrMask = 0x60;
-    }
+    MP2KChnPSG(ctx, track, env, note),
+    synth(ctx.channelRecycler.TakeBuffer()),
+    instrNp(instrNp),
+    lfsrSequence((instrNp & 0x1) == 0 ? lfsrSequence15 : lfsrSequence7)
+{
+}
+
+MP2KChnPSGNoise::MP2KChnPSGNoise(const MP2KChnPSGNoise &other, MP2KContext &ctx, MP2KTrack *trackOrg) :
+    MP2KChnPSG(other, ctx, trackOrg),
+    synth(other.synth),
+    instrNp(other.instrNp),
+    lfsrSequence(other.lfsrSequence),
+    lfsrPos(other.lfsrPos),
+    noiseLevel(other.noiseLevel),
+    dacTickTime(other.dacTickTime),
+    lfsrCountdown(other.lfsrCountdown)
+{
 }
 
 void MP2KChnPSGNoise::SetPitch(int16_t pitch)
@@ -836,34 +923,15 @@ void MP2KChnPSGNoise::Process(std::span<sample> buffer, MixingArgs &args)
     if (buffer.size() == 0)
         return;
 
-    static const std::array<float, 4> noiseFreqs{32768.0f, 65536.0f, 131072.0f, 262144.0f};
-    const float noiseFreq = noiseFreqs[ctx.mp2kSoundMode.dacConfig % noiseFreqs.size()];
-
     VolumeFade vol = getVol();
     float lVolStep = (vol.toVolLeft - vol.fromVolLeft) * args.samplesPerBufferInv;
     float rVolStep = (vol.toVolRight - vol.fromVolRight) * args.samplesPerBufferInv;
     float lVol = vol.fromVolLeft;
     float rVol = vol.fromVolRight;
-    float interStep = freq / noiseFreq;
 
+    generateSteps(buffer.size());
     assert(ctx.mixer.scratchBuffer.size() == buffer.size());
-    /* In order to get accurate noise sound like on hardware, we first nearest-neighbour/zero-order-hold
-     * interpolate the generated noise to whatever is the current DAC PWM rate.
-     * After that, we use the bandlimited sinc resampler to convert this to our actual output rate to
-     * avoid aliasing.
-     * Accordingly, we need to perform two resampling steps, thus the somewhat confusing lambda. */
-    FetchCallback cbSinc = [this, interStep](std::vector<float> &fetchBuffer, size_t samplesRequired) {
-        if (fetchBuffer.size() >= samplesRequired)
-            return true;
-        const size_t samplesToFetch = samplesRequired - fetchBuffer.size();
-        const size_t i = fetchBuffer.size();
-        fetchBuffer.resize(samplesRequired);
-        FetchCallback cbNearest =
-            std::bind(&MP2KChnPSGNoise::sampleFetchCallback, this, std::placeholders::_1, std::placeholders::_2);
-        return rs->Process({&fetchBuffer[i], samplesToFetch}, interStep, cbNearest);
-    };
-
-    srs->Process(ctx.mixer.scratchBuffer, noiseFreq / float(ctx.sampleRate), cbSinc);
+    synth.Render(ctx.mixer.scratchBuffer);
 
     for (size_t i = 0; i < buffer.size(); i++) {
         const float samp = ctx.mixer.scratchBuffer[i];
@@ -874,6 +942,27 @@ void MP2KChnPSGNoise::Process(std::span<sample> buffer, MixingArgs &args)
     }
 }
 
+void MP2KChnPSGNoise::Recycle(ChannelRecycler &recycler)
+{
+    MP2KChnPSG::Recycle(recycler);
+    recycler.PutBuffer(synth.TakeBuffer());
+}
+
+void MP2KChnPSGNoise::Skip(size_t numSamples, [[maybe_unused]] MixingArgs &args)
+{
+    stepEnvelope();
+    if (envState == EnvState::DEAD)
+        return;
+
+    updateVolFade();
+
+    if (numSamples == 0)
+        return;
+
+    generateSteps(numSamples);
+    synth.Skip(numSamples);
+}
+
 VoiceFlags MP2KChnPSGNoise::GetVoiceType() const noexcept
 {
     if (instrNp == 0x0)
@@ -882,26 +971,147 @@ VoiceFlags MP2KChnPSGNoise::GetVoiceType() const noexcept
         return VoiceFlags::PSG_NOISE_7;
 }
 
-bool MP2KChnPSGNoise::sampleFetchCallback(std::vector<float> &fetchBuffer, size_t samplesRequired)
+/*
+ * private MP2KChnPSGNoise
+ */
+
+void MP2KChnPSGNoise::generateSteps(size_t numSamples)
 {
-    if (fetchBuffer.size() >= samplesRequired)
-        return true;
-    size_t samplesToFetch = samplesRequired - fetchBuffer.size();
-    size_t i = fetchBuffer.size();
-    fetchBuffer.resize(samplesRequired);
+    static const std::array<float, 4> noiseFreqs{32768.0f, 65536.0f, 131072.0f, 262144.0f};
+    const float noiseFreq = noiseFreqs[ctx.mp2kSoundMode.dacConfig % noiseFreqs.size()];
+
+    /* In order to get accurate noise sound like on hardware, the LFSR output is sampled at whatever is the current
+     * DAC PWM rate (zero-order-hold), i.e. the output can only change on a DAC tick.
+     * Instead of generating the signal at the DAC rate and resampling it, only the level changes
+     * are added as bandlimited steps at the time of their DAC tick, which avoids aliasing as well. */
+    const float bufferEnd = static_cast<float>(numSamples);
+    const float samplesPerTick = float(ctx.sampleRate) / noiseFreq;
+    const int64_t ticksInBuffer = static_cast<int64_t>(std::ceil((bufferEnd - dacTickTime) / samplesPerTick));
+
+    std::vector<BlepSynth::Step> &steps = ctx.mixer.stepBuffer;
+    steps.resize(static_cast<size_t>(ticksInBuffer));
+    size_t numSteps = 0;
+    if (freq >= noiseFreq)
+        numSteps = generateStepsDense(noiseFreq, samplesPerTick, ticksInBuffer);
+    else if (freq > 0.0f)
+        numSteps = generateStepsSparse(noiseFreq, samplesPerTick, ticksInBuffer);
+    else
+        lfsrCountdown -= ticksInBuffer << LFSR_COUNTDOWN_FRAC_BITS;
+
+    // advance to the first DAC tick of the next buffer
+    dacTickTime = std::max(dacTickTime + static_cast<float>(ticksInBuffer) * samplesPerTick - bufferEnd, 0.0f);
+
+    synth.AddSteps({steps.data(), numSteps});
+}
+
+/* Both variants write one step per DAC tick on which the LFSR shifts. Steps are written unconditionally
+ * and only kept if the level actually changed, because that is random and a branch on it would mispredict
+ * all the time. */
+
+size_t MP2KChnPSGNoise::generateStepsDense(float noiseFreq, float samplesPerTick, int64_t ticksInBuffer)
+{
+    /* The LFSR shifts at least once per DAC tick, so every tick is visited.
+     * Only the value after the last shift of a tick is output. */
+    const int64_t one = int64_t(1) << LFSR_COUNTDOWN_FRAC_BITS;
+    const int64_t ticksPerShift = static_cast<int64_t>(noiseFreq / freq * float(one));
+    const int64_t shiftsPerTick = static_cast<int64_t>(freq / noiseFreq * float(one));
+    // work on local copies, so the compiler can keep them in registers
+    const LfsrSequence &sequence = lfsrSequence;
+    const float firstTickTime = dacTickTime;
+    uint32_t pos = lfsrPos;
+    float prevLevel = noiseLevel;
+    BlepSynth::Step *stepOut = ctx.mixer.stepBuffer.data();
+    size_t numSteps = 0;
+
+    // shifts due up to the first tick, with the fraction of the next shift
+    int64_t shiftPhase = std::max(one - ((lfsrCountdown * shiftsPerTick) >> LFSR_COUNTDOWN_FRAC_BITS), int64_t(0));
+    for (int64_t tick = 0; tick < ticksInBuffer; tick++) {
+        const uint32_t shifts = static_cast<uint32_t>(shiftPhase >> LFSR_COUNTDOWN_FRAC_BITS);
+        shiftPhase += shiftsPerTick - (int64_t(shifts) << LFSR_COUNTDOWN_FRAC_BITS);
+        // only possible for the first tick, if the previous buffer ended just after a shift
+        if (shifts == 0)
+            continue;
+
+        assert(shifts <= LfsrSequence::PADDING);
+        const float level = sequence.Sample(pos + shifts - 1);
+        pos += shifts;
+        if (pos >= sequence.period)
+            pos -= sequence.period;
+
+        stepOut[numSteps] = {firstTickTime + static_cast<float>(tick) * samplesPerTick, level - prevLevel};
+        numSteps += level != prevLevel;
+        prevLevel = level;
+    }
+
+    lfsrPos = pos;
+    noiseLevel = prevLevel;
+    lfsrCountdown = ((one - shiftPhase) * ticksPerShift) >> LFSR_COUNTDOWN_FRAC_BITS;
+    return numSteps;
+}
 
+size_t MP2KChnPSGNoise::generateStepsSparse(float noiseFreq, float samplesPerTick, int64_t ticksInBuffer)
+{
+    /* The LFSR shifts at most once per DAC tick, so the ticks in between can be skipped. */
+    const int64_t one = int64_t(1) << LFSR_COUNTDOWN_FRAC_BITS;
+    const int64_t ticksPerShift = static_cast<int64_t>(noiseFreq / freq * float(one));
+    // work on local copies, so the compiler can keep them in registers
+    const LfsrSequence &sequence = lfsrSequence;
+    const float firstTickTime = dacTickTime;
+    uint32_t pos = lfsrPos;
+    int64_t countdown = lfsrCountdown;
+    float prevLevel = noiseLevel;
+    BlepSynth::Step *stepOut = ctx.mixer.stepBuffer.data();
+    size_t numSteps = 0;
+
+    while (true) {
+        // round up to the next DAC tick
+        const int64_t tick = (countdown + one - 1) >> LFSR_COUNTDOWN_FRAC_BITS;
+        if (tick >= ticksInBuffer)
+            break;
+        countdown += ticksPerShift;
+
+        const float level = sequence.Sample(pos);
+        if (++pos == sequence.period)
+            pos = 0;
+
+        stepOut[numSteps] = {firstTickTime + static_cast<float>(tick) * samplesPerTick, level - prevLevel};
+        numSteps += level != prevLevel;
+        prevLevel = level;
+    }
+
+    lfsrPos = pos;
+    noiseLevel = prevLevel;
+    lfsrCountdown = countdown - (ticksInBuffer << LFSR_COUNTDOWN_FRAC_BITS);
+    return numSteps;
+}
+
+MP2KChnPSGNoise::LfsrSequence::LfsrSequence(uint16_t initialState, uint16_t lfsrMask)
+{
+    /* The output only depends on the number of shifts since note start, so the whole
+     * period of the LFSR is precalculated. PADDING samples are repeated at the end,
+     * so a sample up to PADDING shifts ahead can be read without wrapping around. */
+    std::vector<bool> sequence;
+    uint16_t state = initialState;
     do {
-        float sample;
-        if (noiseState & 1) {
-            sample = 0.5f;
-            noiseState >>= 1;
-            noiseState ^= noiseLfsrMask;
-        } else {
-            sample = -0.5f;
-            noiseState >>= 1;
-        }
-        fetchBuffer[i++] = sample;
-    } while (--samplesToFetch > 0);
+        const uint16_t bit = state & 1;
+        sequence.push_back(bit != 0);
+        state = static_cast<uint16_t>((state >> 1) ^ (bit ? lfsrMask : 0));
+    } while (state != initialState);
+
+    period = static_cast<uint32_t>(sequence.size());
+    bits.resize((period + PADDING + 31) / 32, 0);
+    for (uint32_t i = 0; i < period + PADDING; i++) {
+        if (sequence[i % period])
+            bits[i / 32] |= 1u << (i % 32);
+    }
+}
 
-    return true;
+float MP2KChnPSGNoise::LfsrSequence::Sample(uint32_t pos) const
+{
+    assert(pos < period + PADDING);
+    // branchless, the output bit is random after all
+    return static_cast<float>((bits[pos / 32] >> (pos % 32)) & 1) - 0.5f;
 }
+
+const MP2KChnPSGNoise::LfsrSequence MP2KChnPSGNoise::lfsrSequence15(0x4000, 0x6000);
+const MP2KChnPSGNoise::LfsrSequence MP2KChnPSGNoise::lfsrSequence7(0x40, 0x60);
@@ -1,12 +1,13 @@
 #pragma once
 
+#include "BlepSynth.hpp"
 #include "MP2KChn.hpp"
 #include "Types.hpp"
 
 #include <cstddef>
 #include <cstdint>
-#include <memory>
 #include <span>
+#include <vector>
 
 struct MP2KContext;
 struct MP2KTrack;
@@ -15,11 +16,14 @@ class MP2KChnPSG : public MP2KChn
 {
 public:
     MP2KChnPSG(MP2KContext &ctx, MP2KTrack *track, ADSR env, Note note, bool useStairstep = false);
+    MP2KChnPSG(const MP2KChnPSG &other, MP2KContext &ctx, MP2KTrack *trackOrg);
     MP2KChnPSG(const MP2KChnPSG &) = delete;
     MP2KChnPSG &operator=(const MP2KChnPSG &) = delete;
     virtual ~MP2KChnPSG() = default;
 
     virtual void Process(std::span<sample> buffer, MixingArgs &args) = 0;
+    /* Advances like Process for numSamples output samples, without producing any output. */
+    virtual void Skip(size_t numSamples, MixingArgs &args) = 0;
     void SetVol(uint16_t vol, int16_t pan);
     void Release() noexcept override;
     void Release(bool fastRelease) noexcept;
@@ -62,12 +66,16 @@ class MP2KChnPSGSquare : public MP2KChnPSG
 {
 public:
     MP2KChnPSGSquare(MP2KContext &ctx, MP2KTrack *track, uint32_t instrDuty, ADSR env, Note note, uint8_t sweep);
+    MP2KChnPSGSquare(const MP2KChnPSGSquare &other, MP2KContext &ctx, MP2KTrack *trackOrg);
 
     void SetPitch(int16_t pitch) override;
     void Process(std::span<sample> buffer, MixingArgs &args) override;
+    void Skip(size_t numSamples, MixingArgs &args) override;
     VoiceFlags GetVoiceType() const noexcept override;
 
 private:
+    float getInterStep(const MixingArgs &args) const;
+    void stepSweep();
     bool sampleFetchCallback(std::vector<float> &fetchBuffer, size_t samplesRequired);
 
     static bool isSweepEnabled(uint8_t sweep);
@@ -91,9 +99,11 @@ class MP2KChnPSGWave : public MP2KChnPSG
 {
 public:
     MP2KChnPSGWave(MP2KContext &ctx, MP2KTrack *track, uint32_t instrWave, ADSR env, Note note, bool useStairstep);
+    MP2KChnPSGWave(const MP2KChnPSGWave &other, MP2KContext &ctx, MP2KTrack *trackOrg);
 
     void SetPitch(int16_t pitch) override;
     void Process(std::span<sample> buffer, MixingArgs &args) override;
+    void Skip(size_t numSamples, MixingArgs &args) override;
     VoiceFlags GetVoiceType() const noexcept override;
 
 private:
@@ -111,15 +121,41 @@ class MP2KChnPSGNoise : public MP2KChnPSG
 {
 public:
     MP2KChnPSGNoise(MP2KContext &ctx, MP2KTrack *track, uint32_t instrNp, ADSR env, Note note);
+    MP2KChnPSGNoise(const MP2KChnPSGNoise &other, MP2KContext &ctx, MP2KTrack *trackOrg);
 
     void SetPitch(int16_t pitch) override;
     void Process(std::span<sample> buffer, MixingArgs &args) override;
+    void Recycle(ChannelRecycler &recycler) override;
+    void Skip(size_t numSamples, MixingArgs &args) override;
     VoiceFlags GetVoiceType() const noexcept override;
 
 private:
-    bool sampleFetchCallback(std::vector<float> &fetchBuffer, size_t samplesRequired);
-    std::unique_ptr<Resampler> srs;
+    struct LfsrSequence
+    {
+        LfsrSequence(uint16_t initialState, uint16_t lfsrMask);
+        float Sample(uint32_t pos) const;
+
+        static inline const uint32_t PADDING = 64;
+        uint32_t period;
+        std::vector<uint32_t> bits;
+    };
+
+    void generateSteps(size_t numSamples);
+    size_t generateStepsDense(float noiseFreq, float samplesPerTick, int64_t ticksInBuffer);
+    size_t generateStepsSparse(float noiseFreq, float samplesPerTick, int64_t ticksInBuffer);
+
+    static const LfsrSequence lfsrSequence15;
+    static const LfsrSequence lfsrSequence7;
+
+    BlepSynth synth;
     const uint32_t instrNp;
-    uint16_t noiseState;
-    uint16_t noiseLfsrMask;
+    const LfsrSequence &lfsrSequence;
+    /* number of LFSR shifts since note start, modulo the LFSR period */
+    uint32_t lfsrPos = 0;
+    float noiseLevel = 0.0f;
+    /* time of the first DAC tick in the next buffer, in output samples from its start */
+    float dacTickTime = 0.0f;
+    /* DAC ticks from that first tick until the LFSR shifts the next time, as fixed point number */
+    int64_t lfsrCountdown = 0;
+    static inline const int LFSR_COUNTDOWN_FRAC_BITS = 16;
 };
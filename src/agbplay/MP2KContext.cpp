@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <utility>
 
 MP2KContext::MP2KContext(
     uint32_t sampleRate,
@@ -22,7 +23,12 @@ MP2KContext::MP2KContext(
     agbplaySoundMode(agbplaySoundMode),
     songTableInfo(songTableInfo),
     memaccArea(256),
-    masterLoudnessCalculator(LOUDNESS_LP_FREQ, sampleRate)
+    masterLoudnessCalculator(LOUDNESS_LP_FREQ, sampleRate),
+    sndChannels(channelRecycler),
+    sq1Channels(channelRecycler),
+    sq2Channels(channelRecycler),
+    waveChannels(channelRecycler),
+    noiseChannels(channelRecycler)
 {
     assert(playerTableInfo.size() <= 32);
 
@@ -31,12 +37,14 @@ MP2KContext::MP2KContext(
 
     mixer.UpdateFixedModeRate();
     mixer.UpdateReverb();
+    reader.SetEventCacheEnabled(true);
 }
 
 void MP2KContext::m4aSoundMain()
 {
     reader.Process();
     mixer.Process();
+    unmeteredSamples += masterAudioBuffer.size();
 }
 
 void MP2KContext::m4aSoundMode(uint32_t mode)
@@ -194,6 +202,39 @@ void MP2KContext::m4aMPlayContinue(uint8_t playerIdx)
     players.at(playerIdx).playing = true;
 }
 
+void MP2KContext::m4aSoundMainDry()
+{
+    reader.Process();
+    mixer.ProcessDry();
+}
+
+void MP2KContext::m4aSoundMainSkip()
+{
+    /* Slower than m4aSoundMainDry, but channels end up where m4aSoundMain would have left them. */
+    reader.Process();
+    mixer.ProcessSkip();
+}
+
+size_t MP2KContext::m4aSoundMainBlock(size_t maxSubframes)
+{
+    /* Same as calling m4aSoundMain for each subframe, but the output of all subframes ends up in one larger block.
+     * Sequencer events are still processed once per subframe, so they are applied at the same sample offsets.
+     * Stops early if the song ended, the subframe which ended it is dropped from the block.
+     * Returns the number of subframes in the block. */
+    mixer.BeginBlock(maxSubframes);
+    size_t subframes = 0;
+    while (subframes < maxSubframes) {
+        reader.Process();
+        mixer.ProcessSubframe(subframes);
+        if (SongEnded())
+            break;
+        subframes++;
+    }
+    mixer.EndBlock(subframes);
+    unmeteredSamples += masterAudioBuffer.size();
+    return subframes;
+}
+
 void MP2KContext::m4aSoundClear()
 {
     sndChannels.clear();
@@ -203,8 +244,13 @@ void MP2KContext::m4aSoundClear()
     noiseChannels.clear();
 
     for (MP2KPlayer &player : players) {
+        if (player.reverbBus)
+            player.reverbBus->Reset();
         for (MP2KTrack &trk : player.tracks) {
-            trk.reverb->Reset();
+            if (trk.reverb)
+                trk.reverb->Reset();
+            if (trk.nativeBus)
+                trk.nativeBus->Reset();
         }
     }
 }
@@ -224,8 +270,35 @@ bool MP2KContext::SongEnded() const
     return reader.EndReached() && mixer.IsFadeDone();
 }
 
+SongAnalysis MP2KContext::AnalyzeSong(uint16_t songId, size_t maxSubframes)
+{
+    /* This stops all players, so don't use it on a context which is currently playing. */
+    m4aMPlayAllStop();
+    m4aSoundClear();
+    m4aSongNumStart(songId);
+
+    SongAnalysis analysis;
+    while (analysis.totalSubframes < maxSubframes) {
+        m4aSoundMainDry();
+        if (SongEnded()) {
+            analysis.ended = true;
+            break;
+        }
+        if (!reader.EndReached())
+            analysis.endSubframe++;
+        analysis.totalSubframes++;
+    }
+
+    analysis.numLoops = reader.GetNumLoops();
+    return analysis;
+}
+
 void MP2KContext::GetVisualizerState(MP2KVisualizerState &visualizerState)
 {
+    /* The meters are only updated here, from the last mixed block. */
+    const size_t elapsedSamples = unmeteredSamples;
+    unmeteredSamples = 0;
+
     visualizerState.activeChannels = sndChannels.size();
     visualizerState.players.resize(players.size());
     visualizerState.primaryPlayer = primaryPlayer;
@@ -244,7 +317,10 @@ void MP2KContext::GetVisualizerState(MP2KVisualizerState &visualizerState)
             MP2KTrack &trk_src = player_src.tracks.at(trackIdx);
             auto &trk_dst = player_dst.tracks.at(trackIdx);
 
-            trk_src.loudnessCalculator.CalcLoudness(trk_src.audioBuffer);
+            if (trk_src.audioBufferClear)
+                trk_src.loudnessCalculator.CalcLoudness({}, elapsedSamples);
+            else
+                trk_src.loudnessCalculator.CalcLoudness(trk_src.audioBuffer, elapsedSamples);
             trk_src.loudnessCalculator.GetLoudness(
                 trk_dst.rmsLeft, trk_dst.rmsRight, trk_dst.peakLeft, trk_dst.peakRight
             );
@@ -265,7 +341,7 @@ void MP2KContext::GetVisualizerState(MP2KVisualizerState &visualizerState)
         }
     }
 
-    masterLoudnessCalculator.CalcLoudness(masterAudioBuffer);
+    masterLoudnessCalculator.CalcLoudness(masterAudioBuffer, elapsedSamples);
     masterLoudnessCalculator.GetLoudness(
         visualizerState.masterRmsLeft,
         visualizerState.masterRmsRight,
@@ -273,3 +349,152 @@ void MP2KContext::GetVisualizerState(MP2KVisualizerState &visualizerState)
         visualizerState.masterPeakRight
     );
 }
+
+template<typename T>
+static void
+    saveChannels(MP2KContext &ctx, const ChannelPool<T> &pool, std::vector<MP2KSnapshot::Channel<T>> &channels)
+{
+    channels.clear();
+    for (const T &chn : pool) {
+        MP2KSnapshot::Channel<T> &dst = channels.emplace_back();
+        dst.chn = std::make_unique<T>(chn, ctx, nullptr);
+
+        /* channels are identified by the indices of their track, since the tracks of the restoring context differ */
+        bool found = false;
+        for (size_t playerIdx = 0; playerIdx < ctx.players.size() && !found; playerIdx++) {
+            const MP2KPlayer &player = ctx.players[playerIdx];
+            for (size_t trackIdx = 0; trackIdx < player.tracks.size() && !found; trackIdx++) {
+                if (chn.trackOrg != &player.tracks[trackIdx])
+                    continue;
+                dst.playerIdx = static_cast<uint8_t>(playerIdx);
+                dst.trackIdx = static_cast<uint8_t>(trackIdx);
+                found = true;
+            }
+        }
+        assert(found);
+
+        dst.linkRank = MP2KSnapshot::LINK_NONE;
+        if (chn.track != nullptr) {
+            size_t rank = 0;
+            for (const MP2KChn *c = chn.track->channels; c != &chn; c = c->next)
+                rank++;
+            dst.linkRank = rank;
+        }
+    }
+}
+
+template<typename T>
+static void restoreChannels(
+    MP2KContext &ctx,
+    const std::vector<MP2KSnapshot::Channel<T>> &channels,
+    ChannelPool<T> &pool,
+    std::vector<std::pair<size_t, MP2KChn *>> &links
+)
+{
+    for (const MP2KSnapshot::Channel<T> &src : channels) {
+        MP2KTrack *trk = &ctx.players.at(src.playerIdx).tracks.at(src.trackIdx);
+        T &chn = pool.emplace_back(*src.chn, ctx, trk);
+        if (src.linkRank != MP2KSnapshot::LINK_NONE)
+            links.emplace_back(src.linkRank, &chn);
+    }
+}
+
+void MP2KContext::SaveSnapshot(MP2KSnapshot &snapshot)
+{
+    snapshot.mp2kSoundMode = mp2kSoundMode;
+    snapshot.reverbType = agbplaySoundMode.reverbType;
+    snapshot.nativeMixRate = agbplaySoundMode.nativeMixRate;
+    snapshot.sharedReverb = agbplaySoundMode.sharedReverb;
+    snapshot.readerState = reader.GetState();
+    snapshot.fadeState = mixer.GetFadeState();
+    snapshot.memaccArea = memaccArea;
+    snapshot.primaryPlayer = primaryPlayer;
+
+    snapshot.players.resize(players.size());
+    for (size_t playerIdx = 0; playerIdx < players.size(); playerIdx++) {
+        const MP2KPlayer &player_src = players[playerIdx];
+        MP2KSnapshot::Player &player_dst = snapshot.players[playerIdx];
+
+        player_dst.state = player_src;
+        player_dst.reverbBus = player_src.reverbBus ? player_src.reverbBus->Clone() : nullptr;
+        player_dst.tracks.resize(player_src.tracks.size());
+        for (size_t trackIdx = 0; trackIdx < player_src.tracks.size(); trackIdx++) {
+            const MP2KTrack &trk_src = player_src.tracks[trackIdx];
+            MP2KSnapshot::Track &trk_dst = player_dst.tracks[trackIdx];
+
+            trk_dst.state = trk_src;
+            trk_dst.reverb = trk_src.reverb ? trk_src.reverb->Clone() : nullptr;
+            trk_dst.nativeBus = trk_src.nativeBus ? trk_src.nativeBus->Clone() : nullptr;
+        }
+    }
+
+    saveChannels(*this, sndChannels, snapshot.sndChannels);
+    saveChannels(*this, sq1Channels, snapshot.sq1Channels);
+    saveChannels(*this, sq2Channels, snapshot.sq2Channels);
+    saveChannels(*this, waveChannels, snapshot.waveChannels);
+    saveChannels(*this, noiseChannels, snapshot.noiseChannels);
+}
+
+void MP2KContext::RestoreSnapshot(const MP2KSnapshot &snapshot)
+{
+    if (snapshot.players.size() != players.size())
+        throw Xcept(
+            "Cannot restore snapshot with {} players into context with {} players",
+            snapshot.players.size(),
+            players.size()
+        );
+
+    m4aSoundClear();
+
+    /* recreates reverbs and mix buses for the restored sound mode, they are replaced by the copies below if the
+     * snapshot has the same kind */
+    mp2kSoundMode = snapshot.mp2kSoundMode;
+    mixer.UpdateFixedModeRate();
+    mixer.UpdateReverb();
+    const bool sameEffects = snapshot.reverbType == agbplaySoundMode.reverbType
+        && snapshot.nativeMixRate == agbplaySoundMode.nativeMixRate
+        && snapshot.sharedReverb == agbplaySoundMode.sharedReverb;
+
+    reader.SetState(snapshot.readerState);
+    mixer.SetFadeState(snapshot.fadeState);
+    memaccArea = snapshot.memaccArea;
+    primaryPlayer = snapshot.primaryPlayer;
+
+    for (size_t playerIdx = 0; playerIdx < players.size(); playerIdx++) {
+        const MP2KSnapshot::Player &player_src = snapshot.players[playerIdx];
+        MP2KPlayer &player_dst = players[playerIdx];
+
+        if (player_src.tracks.size() != player_dst.tracks.size())
+            throw Xcept("Cannot restore snapshot, player {} has a different number of tracks", playerIdx);
+
+        static_cast<MP2KPlayerState &>(player_dst) = player_src.state;
+        if (sameEffects && player_src.reverbBus && player_dst.reverbBus)
+            player_dst.reverbBus = player_src.reverbBus->Clone();
+        for (size_t trackIdx = 0; trackIdx < player_dst.tracks.size(); trackIdx++) {
+            const MP2KSnapshot::Track &trk_src = player_src.tracks[trackIdx];
+            MP2KTrack &trk_dst = player_dst.tracks[trackIdx];
+
+            static_cast<MP2KTrackState &>(trk_dst) = trk_src.state;
+            /* the event cache of this context may differ, the event is looked up again by position */
+            trk_dst.eventIdx = SequenceEvent::NONE;
+            trk_dst.audioBufferClear = false;
+            if (sameEffects && trk_src.reverb && trk_dst.reverb)
+                trk_dst.reverb = trk_src.reverb->Clone();
+            if (sameEffects && trk_src.nativeBus && trk_dst.nativeBus)
+                trk_dst.nativeBus = trk_src.nativeBus->Clone();
+        }
+    }
+
+    /* Pools keep the order of the snapshot, which is the order channels are mixed in. Channels of different pools
+     * may be mixed in one track list, so they are linked once all of them exist: back to front, since linking
+     * inserts at the front. */
+    std::vector<std::pair<size_t, MP2KChn *>> links;
+    restoreChannels(*this, snapshot.sndChannels, sndChannels, links);
+    restoreChannels(*this, snapshot.sq1Channels, sq1Channels, links);
+    restoreChannels(*this, snapshot.sq2Channels, sq2Channels, links);
+    restoreChannels(*this, snapshot.waveChannels, waveChannels, links);
+    restoreChannels(*this, snapshot.noiseChannels, noiseChannels, links);
+    std::sort(links.begin(), links.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+    for (const auto &[rank, chn] : links)
+        chn->LinkToTrack();
+}
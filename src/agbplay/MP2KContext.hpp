@@ -1,15 +1,16 @@
 #pragma once
 
+#include "ChannelPool.hpp"
 #include "LoudnessCalculator.hpp"
 #include "MP2KChnPCM.hpp"
 #include "MP2KChnPSG.hpp"
 #include "MP2KPlayer.hpp"
+#include "MP2KSnapshot.hpp"
 #include "Rom.hpp"
 #include "SequenceReader.hpp"
 #include "SoundMixer.hpp"
 
 #include <cstdint>
-#include <list>
 #include <vector>
 
 /* Instead of defining lots of global objects, we define
@@ -48,6 +49,9 @@ struct MP2KContext
     void m4aMPlayAllContinue();
 
     /* custom helper functions */
+    void m4aSoundMainDry();
+    void m4aSoundMainSkip();
+    size_t m4aSoundMainBlock(size_t maxSubframes);
     void m4aSoundClear();
     void m4aMPlayKill(uint8_t playerIdx);
     void m4aMPlayAllKill();
@@ -55,7 +59,10 @@ struct MP2KContext
     bool m4aMPlayIsPlaying(uint8_t playerIdx) const;
 
     bool SongEnded() const;
+    SongAnalysis AnalyzeSong(uint16_t songId, size_t maxSubframes);
     void GetVisualizerState(MP2KVisualizerState &visualizerState);
+    void SaveSnapshot(MP2KSnapshot &snapshot);
+    void RestoreSnapshot(const MP2KSnapshot &snapshot);
 
     const Rom &rom;
     SequenceReader reader;
@@ -68,13 +75,16 @@ struct MP2KContext
     std::vector<uint8_t> memaccArea;    // TODO, this will have to be accessible from outside for emulator support
     std::vector<sample> masterAudioBuffer;
     LoudnessCalculator masterLoudnessCalculator;
+    /* samples mixed since the meters were last updated by GetVisualizerState */
+    size_t unmeteredSamples = 0;
 
-    // sound channels
-    std::list<MP2KChnPCM> sndChannels;
-    std::list<MP2KChnPSGSquare> sq1Channels;
-    std::list<MP2KChnPSGSquare> sq2Channels;
-    std::list<MP2KChnPSGWave> waveChannels;
-    std::list<MP2KChnPSGNoise> noiseChannels;
+    // sound channels, the recycler has to outlive the pools
+    ChannelRecycler channelRecycler;
+    ChannelPool<MP2KChnPCM> sndChannels;
+    ChannelPool<MP2KChnPSGSquare> sq1Channels;
+    ChannelPool<MP2KChnPSGSquare> sq2Channels;
+    ChannelPool<MP2KChnPSGWave> waveChannels;
+    ChannelPool<MP2KChnPSGNoise> noiseChannels;
 
     uint8_t primaryPlayer = 0;    // <-- this is only used for visualization, perhaps move outside from here
 };
@@ -1,6 +1,7 @@
 #include "MP2KPlayer.hpp"
 
 #include "MP2KTrack.hpp"
+#include "NativeMixBus.hpp"
 #include "ReverbEffect.hpp"
 #include "Rom.hpp"    // TODO remove once Rom is deglobalized
 
@@ -5,22 +5,15 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 class Rom;
 struct MP2KContext;
 
-struct MP2KPlayer
+/* The sequencer state of a player, which is copied for snapshots (see MP2KSnapshot) */
+struct MP2KPlayerState
 {
-    MP2KPlayer(const MP2KContext &ctx, const PlayerInfo &playerInfo, uint8_t playerIdx);
-    MP2KPlayer(const MP2KPlayer &) = delete;
-    MP2KPlayer(MP2KPlayer &&) = default;
-    MP2KPlayer &operator=(const MP2KPlayer &) = delete;
-
-    void Init(const Rom &rom, size_t songHeaderPos);
-
-    std::vector<MP2KTrack> tracks;
-
     /* playback state */
     bool playing = false;
     bool finished = true;
@@ -38,6 +31,23 @@ struct MP2KPlayer
     uint8_t tracksUsed = 0;
     uint8_t reverb = 0;
     uint8_t priority = 0;
+};
+
+struct MP2KPlayer : MP2KPlayerState
+{
+    MP2KPlayer(const MP2KContext &ctx, const PlayerInfo &playerInfo, uint8_t playerIdx);
+    MP2KPlayer(const MP2KPlayer &) = delete;
+    MP2KPlayer(MP2KPlayer &&) = default;
+    MP2KPlayer &operator=(const MP2KPlayer &) = delete;
+
+    void Init(const Rom &rom, size_t songHeaderPos);
+
+    std::vector<MP2KTrack> tracks;
+
+    /* Only if AgbplaySoundMode::sharedReverb is enabled (instead of MP2KTrack::reverb).
+     * The buffer only holds what the reverb adds to the tracks. */
+    std::unique_ptr<ReverbEffect> reverbBus;
+    std::vector<sample> reverbBusBuffer;
 
     /* player constants */
     const uint8_t trackLimit;
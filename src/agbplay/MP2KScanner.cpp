@@ -297,8 +297,9 @@ bool MP2KScanner::IsPosReferenced(size_t pos) const
 bool MP2KScanner::IsPosReferenced(size_t pos, size_t &findStartPos, size_t &referencePos) const
 {
     bool foundReference = false;
+    const RomSpan romData = rom.GetSpan(0, rom.Size());
     for (size_t j = findStartPos; j < rom.Size() - 3; j += 4) {
-        const size_t referenceCandidate = rom.ReadU32(j);
+        const size_t referenceCandidate = romData.ReadU32(j);
         if (!rom.ValidPointer(referenceCandidate))
             continue;
         if (referenceCandidate - AGB_MAP_ROM != pos)
@@ -314,8 +315,9 @@ bool MP2KScanner::IsPosReferenced(size_t pos, size_t &findStartPos, size_t &refe
 
 bool MP2KScanner::IsPosReferenced(const std::vector<size_t> &poss, size_t &index) const
 {
+    const RomSpan romData = rom.GetSpan(0, rom.Size());
     for (size_t j = SEARCH_START; j < rom.Size() - 3; j += 4) {
-        const size_t referenceCandidate = rom.ReadU32(j);
+        const size_t referenceCandidate = romData.ReadU32(j);
         if (!rom.ValidPointer(referenceCandidate))
             continue;
 
@@ -334,23 +336,24 @@ bool MP2KScanner::IsValidSongTableEntry(size_t pos, bool relaxed) const
 {
     if (!rom.ValidRange(pos, 8))
         return false;
+    const RomSpan entry = rom.GetSpan(pos, 8);
 
     /* 0. (optional) during GSF scanning, a relaxed scan is used. This is because
      * GSFs have unused entries from the GSF set zeroed, but we have to assume
      * they are valid for location of the song table start. */
-    if (relaxed && rom.ReadU32(pos) == 0 && rom.ReadU32(pos + 4) == 0)
+    if (relaxed && entry.ReadU32(0) == 0 && entry.ReadU32(4) == 0)
         return true;
 
     /* 1. check if pointer to song is valid */
-    if (!rom.ValidPointer(rom.ReadU32(pos + 0)))
+    if (!rom.ValidPointer(entry.ReadU32(0)))
         return false;
 
     /* 2. check if music player numbers are correct.
      * Special case: For GSF sets p2 is always zero instead of equal to p1 */
-    const uint8_t p1 = rom.ReadU8(pos + 4);
-    const uint8_t z1 = rom.ReadU8(pos + 5);
-    const uint8_t p2 = rom.ReadU8(pos + 6);
-    const uint8_t z2 = rom.ReadU8(pos + 7);
+    const uint8_t p1 = entry.ReadU8(4);
+    const uint8_t z1 = entry.ReadU8(5);
+    const uint8_t p2 = entry.ReadU8(6);
+    const uint8_t z2 = entry.ReadU8(7);
 
     if (z1 != 0 || z2 != 0 || (rom.IsGsf() ? (p2 != 0) : (p1 != p2)))
         return false;
@@ -415,8 +418,9 @@ void MP2KScanner::InitPointerCache()
     wordPointerCache.clear();
 
     /* find list of all pointers in ROM */
+    const RomSpan romData = rom.GetSpan(0, rom.Size());
     for (size_t i = SEARCH_START; i < rom.Size() - 3; i += 4) {
-        const uint32_t ptr = rom.ReadU32(i);
+        const uint32_t ptr = romData.ReadU32(i);
         if (rom.ValidPointer(ptr) && (ptr % 4) == 0)
             wordPointerCache.insert(ptr);
     }
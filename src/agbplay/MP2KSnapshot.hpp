@@ -0,0 +1,88 @@
+#pragma once
+
+#include "MP2KChnPCM.hpp"
+#include "MP2KChnPSG.hpp"
+#include "MP2KPlayer.hpp"
+#include "NativeMixBus.hpp"
+#include "ReverbEffect.hpp"
+#include "SequenceReader.hpp"
+#include "SoundMixer.hpp"
+#include "Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/* MP2KSnapshot is a copy of everything in a MP2KContext which changes during playback: players, tracks,
+ * channels (including their resampler and envelope state) and the reverb buffers.
+ * Restoring it (MP2KContext::RestoreSnapshot) continues playback exactly where the snapshot was taken,
+ * so a seek only has to render from the nearest snapshot instead of the start of the song.
+ *
+ * Snapshots do not contain the ROM, the configuration or any output buffers. They may be restored into
+ * any context which was created with the same ROM, song table and player table. */
+
+struct MP2KSnapshot
+{
+    template<typename T> struct Channel
+    {
+        /* Only used as source for copies. It is not linked to any track and still refers to the context the snapshot
+         * was taken from, which may not exist anymore. */
+        std::unique_ptr<T> chn;
+        uint8_t playerIdx;
+        uint8_t trackIdx;
+        /* position in the track's channel list, LINK_NONE if the channel has been removed from it */
+        size_t linkRank;
+    };
+
+    static inline const size_t LINK_NONE = SIZE_MAX;
+
+    /* Reverbs and mix buses may be left empty (e.g. if they were never used), the restoring context then keeps
+     * its own ones, which are reset. */
+    struct Track
+    {
+        MP2KTrackState state;
+        std::unique_ptr<ReverbEffect> reverb;
+        std::unique_ptr<NativeMixBus> nativeBus;
+    };
+
+    struct Player
+    {
+        MP2KPlayerState state;
+        std::vector<Track> tracks;
+        std::unique_ptr<ReverbEffect> reverbBus;
+    };
+
+    /* Drops the reverbs and mix buses which are not fed while skipping (see SoundMixer::ProcessSkip), so snapshots
+     * taken while skipping don't take up memory for them. */
+    void DropSkippedEffects()
+    {
+        for (Player &player : players) {
+            player.reverbBus.reset();
+            if (nativeMixRate)
+                continue;
+            for (Track &trk : player.tracks) {
+                trk.reverb.reset();
+                trk.nativeBus.reset();
+            }
+        }
+    }
+
+    MP2KSoundMode mp2kSoundMode;
+    /* only the settings which determine the kind of reverbs and mix buses */
+    ReverbType reverbType = ReverbType::NORMAL;
+    bool nativeMixRate = false;
+    bool sharedReverb = false;
+
+    SequenceReader::State readerState;
+    SoundMixer::FadeState fadeState;
+    std::vector<Player> players;
+    std::vector<uint8_t> memaccArea;
+    uint8_t primaryPlayer = 0;
+
+    std::vector<Channel<MP2KChnPCM>> sndChannels;
+    std::vector<Channel<MP2KChnPSGSquare>> sq1Channels;
+    std::vector<Channel<MP2KChnPSGSquare>> sq2Channels;
+    std::vector<Channel<MP2KChnPSGWave>> waveChannels;
+    std::vector<Channel<MP2KChnPSGNoise>> noiseChannels;
+};
@@ -2,6 +2,7 @@
 
 #include "MP2KChn.hpp"
 #include "MP2KContext.hpp"
+#include "NativeMixBus.hpp"
 #include "ReverbEffect.hpp"
 
 #include <cassert>
@@ -45,6 +46,7 @@ void MP2KTrack::Init(size_t pos)
     updateVolume = false;
     updatePitch = false;
     channels = nullptr;
+    eventIdx = SequenceEvent::NONE;
     activeNotes.reset();
     activeVoiceTypes = VoiceFlags::NONE;
 }
@@ -9,6 +9,7 @@
 // TODO remove dependency for NUM_NOTES, and possibly remove active notes state?
 #include "Constants.hpp"
 #include "LoudnessCalculator.hpp"
+#include "SequenceEventCache.hpp"
 #include "Types.hpp"
 
 #define TRACK_CALL_STACK_SIZE 3
@@ -17,28 +18,14 @@ enum class MODT : int { PITCH = 0, VOL, PAN };
 
 struct MP2KChn;
 struct MP2KContext;
+class NativeMixBus;
 class ReverbEffect;
 
-struct MP2KTrack
+/* The sequencer state of a track, which is copied for snapshots (see MP2KSnapshot) */
+struct MP2KTrackState
 {
-    MP2KTrack(const MP2KContext &ctx, uint8_t trackIdx);
-    MP2KTrack(const MP2KTrack &) = delete;
-    MP2KTrack(MP2KTrack &&) = default;
-    MP2KTrack &operator=(const MP2KTrack &) = delete;
-
-    void Init(size_t pos);
-    void Stop();
-
-    int16_t GetPitch();
-    uint16_t GetVol();
-    int16_t GetPan();
-    void ResetLfoValue();
-
     std::bitset<NUM_NOTES> activeNotes;
     VoiceFlags activeVoiceTypes;
-    std::vector<sample> audioBuffer;
-    std::unique_ptr<ReverbEffect> reverb;
-    LoudnessCalculator loudnessCalculator;
 
     size_t pos;
     size_t returnPos[TRACK_CALL_STACK_SIZE];
@@ -67,12 +54,38 @@ struct MP2KTrack
     int8_t bend;
     int8_t tune;
     int8_t keyShift;
-    bool muted;
     bool enabled;
     bool updateVolume;
     bool updatePitch;
+    /* current position in the SequenceReader's event cache, if enabled */
+    uint32_t eventIdx;
+};
 
-    const uint8_t trackIdx;
+struct MP2KTrack : MP2KTrackState
+{
+    MP2KTrack(const MP2KContext &ctx, uint8_t trackIdx);
+    MP2KTrack(const MP2KTrack &) = delete;
+    MP2KTrack(MP2KTrack &&) = default;
+    MP2KTrack &operator=(const MP2KTrack &) = delete;
 
+    void Init(size_t pos);
+    void Stop();
+
+    int16_t GetPitch();
+    uint16_t GetVol();
+    int16_t GetPan();
+    void ResetLfoValue();
+
+    std::vector<sample> audioBuffer;
+    std::unique_ptr<ReverbEffect> reverb;
+    std::unique_ptr<NativeMixBus> nativeBus;    // only if AgbplaySoundMode::nativeMixRate is enabled
+    LoudnessCalculator loudnessCalculator;
+    /* SoundMixer: whether anything was mixed into audioBuffer during the current subframe
+     * and whether audioBuffer is known to contain only zeros, so silent tracks can be skipped */
+    bool audible = false;
+    bool audioBufferClear = false;
+
+    bool muted;
+    const uint8_t trackIdx;
     MP2KChn *channels = nullptr;
 };
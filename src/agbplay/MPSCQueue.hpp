@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+/* MPSCQueue passes values from any number of producer threads to one consumer thread without locks.
+ * Push links a new node into a stack with a single compare and swap. The consumer takes the whole stack
+ * at once and reverses it, so values come out in the order they were pushed. Neither side ever waits
+ * for the other one.
+ *
+ * Nodes are allocated by the producer and freed by the consumer, so the consumer should not be
+ * a thread which must never allocate (like the audio callback). */
+
+template<typename T> class MPSCQueue
+{
+public:
+    MPSCQueue() = default;
+    MPSCQueue(const MPSCQueue &) = delete;
+    MPSCQueue &operator=(const MPSCQueue &) = delete;
+    ~MPSCQueue()
+    {
+        freeList(head.load(std::memory_order_acquire));
+        freeList(pending);
+    }
+
+    /* may be called from any thread */
+    void Push(T value)
+    {
+        Node *node = new Node{std::move(value), head.load(std::memory_order_relaxed)};
+        while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    /* consumer only, calls func for each value pushed so far. If func throws, the remaining values are kept. */
+    template<typename F> void Drain(F &&func)
+    {
+        /* reverse the newest first stack and append it to what may be left from a previous call */
+        Node *node = head.exchange(nullptr, std::memory_order_acquire);
+        Node *reversed = nullptr;
+        while (node) {
+            Node *next = node->next;
+            node->next = reversed;
+            reversed = node;
+            node = next;
+        }
+        Node **tail = &pending;
+        while (*tail)
+            tail = &(*tail)->next;
+        *tail = reversed;
+
+        while (pending) {
+            std::unique_ptr<Node> front(pending);
+            pending = front->next;
+            func(std::move(front->value));
+        }
+    }
+
+private:
+    struct Node
+    {
+        T value;
+        Node *next;
+    };
+
+    static void freeList(Node *node)
+    {
+        while (node) {
+            Node *next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    std::atomic<Node *> head = nullptr;
+    /* consumer only, values which were taken from the stack but not consumed yet, oldest first */
+    Node *pending = nullptr;
+};
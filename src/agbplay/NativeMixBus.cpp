@@ -0,0 +1,120 @@
+#include "NativeMixBus.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+/*
+ * public NativeMixBus
+ */
+
+NativeMixBus::NativeMixBus(uint32_t fixedModeRate, uint32_t sampleRate, ResamplerPolyphase polyphase) :
+    phaseInc(float(fixedModeRate) / float(sampleRate)),
+    rsLeft(Resampler::MakeResampler(ResamplerType::SINC, polyphase)),
+    rsRight(Resampler::MakeResampler(ResamplerType::SINC, polyphase))
+{
+    Reset();
+}
+
+NativeMixBus::NativeMixBus(const NativeMixBus &other) :
+    phaseInc(other.phaseInc),
+    rsLeft(other.rsLeft->Clone()),
+    rsRight(other.rsRight->Clone()),
+    mixBuffer(other.mixBuffer),
+    pendingLeft(other.pendingLeft),
+    pendingRight(other.pendingRight),
+    silentSamples(other.silentSamples),
+    outLeft(other.outLeft),
+    outRight(other.outRight)
+{
+}
+
+void NativeMixBus::Prepare(size_t outputSamples)
+{
+    const size_t required = rsLeft->SamplesRequired(outputSamples, phaseInc);
+    assert(required >= pendingLeft.size());
+    mixBuffer.assign(required - pendingLeft.size(), sample{0.0f, 0.0f});
+}
+
+std::span<sample> NativeMixBus::GetMixBuffer()
+{
+    return mixBuffer;
+}
+
+bool NativeMixBus::Resample(std::span<sample> buffer)
+{
+    if (!pushMixBuffer())
+        return false;
+
+    outLeft.resize(buffer.size());
+    outRight.resize(buffer.size());
+    const size_t consumed = rsLeft->ProcessDirect(outLeft, phaseInc, pendingLeft.data());
+    [[maybe_unused]] const size_t consumedRight = rsRight->ProcessDirect(outRight, phaseInc, pendingRight.data());
+    assert(consumed == consumedRight);
+
+    for (size_t i = 0; i < buffer.size(); i++) {
+        buffer[i].left += outLeft[i];
+        buffer[i].right += outRight[i];
+    }
+
+    popPending(consumed);
+    return true;
+}
+
+bool NativeMixBus::Skip(size_t outputSamples)
+{
+    if (!pushMixBuffer())
+        return false;
+
+    const size_t consumed = rsLeft->SkipDirect(outputSamples, phaseInc);
+    [[maybe_unused]] const size_t consumedRight = rsRight->SkipDirect(outputSamples, phaseInc);
+    assert(consumed == consumedRight);
+
+    popPending(consumed);
+    return true;
+}
+
+std::unique_ptr<NativeMixBus> NativeMixBus::Clone() const
+{
+    return std::unique_ptr<NativeMixBus>(new NativeMixBus(*this));
+}
+
+void NativeMixBus::Reset()
+{
+    rsLeft->Reset();
+    rsRight->Reset();
+    pendingLeft.assign(rsLeft->LeadIn(), 0.0f);
+    pendingRight.assign(rsRight->LeadIn(), 0.0f);
+    silentSamples = pendingLeft.size();
+    mixBuffer.clear();
+}
+
+/*
+ * private NativeMixBus
+ */
+
+/* returns false if nothing but silence is pending, the bus is reset then */
+bool NativeMixBus::pushMixBuffer()
+{
+    for (const sample &s : mixBuffer) {
+        pendingLeft.push_back(s.left);
+        pendingRight.push_back(s.right);
+        if (s.left == 0.0f && s.right == 0.0f)
+            silentSamples++;
+        else
+            silentSamples = 0;
+    }
+
+    /* Most tracks are silent most of the time. If nothing but silence is pending, the output is silent as well
+     * and the resampler can start over, only its phase is lost. */
+    if (silentSamples >= pendingLeft.size()) {
+        Reset();
+        return false;
+    }
+    return true;
+}
+
+void NativeMixBus::popPending(size_t consumed)
+{
+    pendingLeft.erase(pendingLeft.begin(), pendingLeft.begin() + static_cast<std::ptrdiff_t>(consumed));
+    pendingRight.erase(pendingRight.begin(), pendingRight.begin() + static_cast<std::ptrdiff_t>(consumed));
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Resampler.hpp"
+#include "Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+/* NativeMixBus collects the PCM channels of one track at the fixed mode rate, like the GBA mixes them
+ * into its DMA buffer. The bus is then converted to the output rate with a single high quality resampler
+ * per side, instead of one per channel (see AgbplaySoundMode::nativeMixRate).
+ *
+ * PSG channels don't use the bus. The GBA doesn't mix them at the fixed mode rate either, they are generated by
+ * the sound hardware and added to the DMA output afterwards. Square and wave channels keep their own BLEP resampler
+ * and noise channels their BlepSynth, since sampling them at the fixed mode rate would be less accurate.
+ *
+ * Each buffer, Prepare clears the part of the bus which has to be mixed (GetMixBuffer), then Resample adds
+ * the converted output to the track's buffer. The number of bus samples varies from buffer to buffer,
+ * since the fixed mode rate usually isn't a multiple of the buffer rate. */
+class NativeMixBus
+{
+public:
+    NativeMixBus(uint32_t fixedModeRate, uint32_t sampleRate, ResamplerPolyphase polyphase);
+    NativeMixBus &operator=(const NativeMixBus &) = delete;
+
+    void Prepare(size_t outputSamples);
+    std::span<sample> GetMixBuffer();
+    /* returns false if the bus was silent and nothing was added to buffer */
+    bool Resample(std::span<sample> buffer);
+    /* same as Resample for outputSamples, but the output is only skipped */
+    bool Skip(size_t outputSamples);
+    void Reset();
+    /* copies the bus including the resampler history, e.g. for snapshots */
+    std::unique_ptr<NativeMixBus> Clone() const;
+
+private:
+    NativeMixBus(const NativeMixBus &other);
+
+    bool pushMixBuffer();
+    void popPending(size_t consumed);
+
+    const float phaseInc;
+    std::unique_ptr<Resampler> rsLeft;
+    std::unique_ptr<Resampler> rsRight;
+    std::vector<sample> mixBuffer;
+    /* pending samples at the fixed mode rate, starting with the resampler's filter history */
+    std::vector<float> pendingLeft;
+    std::vector<float> pendingRight;
+    /* number of silent samples at the end of pending */
+    size_t silentSamples = 0;
+    std::vector<float> outLeft;
+    std::vector<float> outRight;
+};
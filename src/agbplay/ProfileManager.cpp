@@ -332,6 +332,8 @@ void ProfileManager::LoadProfile(const std::filesystem::path &filePath)
             p.agbplaySoundMode.resamplerTypeNormal = str2res(sm["resamplerTypeNormal"]);
         if (sm.contains("resamplerTypeFixed") && sm["resamplerTypeFixed"].is_string())
             p.agbplaySoundMode.resamplerTypeFixed = str2res(sm["resamplerTypeFixed"]);
+        if (sm.contains("resamplerPolyphase") && sm["resamplerPolyphase"].is_string())
+            p.agbplaySoundMode.resamplerPolyphase = str2polyphase(sm["resamplerPolyphase"]);
         if (sm.contains("reverbType") && sm["reverbType"].is_string())
             p.agbplaySoundMode.reverbType = str2rev(sm["reverbType"]);
         if (sm.contains("cgbPolyphony") && sm["cgbPolyphony"].is_string())
@@ -346,6 +348,10 @@ void ProfileManager::LoadProfile(const std::filesystem::path &filePath)
             p.agbplaySoundMode.accurateCh3Volume = sm["accurateCh3Volume"];
         if (sm.contains("emulateCgbSustainBug") && sm["emulateCgbSustainBug"].is_boolean())
             p.agbplaySoundMode.emulateCgbSustainBug = sm["emulateCgbSustainBug"];
+        if (sm.contains("nativeMixRate") && sm["nativeMixRate"].is_boolean())
+            p.agbplaySoundMode.nativeMixRate = sm["nativeMixRate"];
+        if (sm.contains("sharedReverb") && sm["sharedReverb"].is_boolean())
+            p.agbplaySoundMode.sharedReverb = sm["sharedReverb"];
     }
 
     /* load game match */
@@ -454,6 +460,7 @@ void ProfileManager::SaveProfile(std::shared_ptr<Profile> &p)
     json jasm = json::object();
     jasm["resamplerTypeNormal"] = res2str(p->agbplaySoundMode.resamplerTypeNormal);
     jasm["resamplerTypeFixed"] = res2str(p->agbplaySoundMode.resamplerTypeFixed);
+    jasm["resamplerPolyphase"] = polyphase2str(p->agbplaySoundMode.resamplerPolyphase);
     jasm["reverbType"] = rev2str(p->agbplaySoundMode.reverbType);
     jasm["cgbPolyphony"] = cgbPoly2str(p->agbplaySoundMode.cgbPolyphony);
     jasm["dmaBufferLen"] = p->agbplaySoundMode.dmaBufferLen;
@@ -461,6 +468,8 @@ void ProfileManager::SaveProfile(std::shared_ptr<Profile> &p)
     jasm["accurateCh3Quantization"] = p->agbplaySoundMode.accurateCh3Quantization;
     jasm["accurateCh3Volume"] = p->agbplaySoundMode.accurateCh3Volume;
     jasm["emulateCgbSustainBug"] = p->agbplaySoundMode.emulateCgbSustainBug;
+    jasm["nativeMixRate"] = p->agbplaySoundMode.nativeMixRate;
+    jasm["sharedReverb"] = p->agbplaySoundMode.sharedReverb;
     j["agbplaySoundMode"] = std::move(jasm);
 
     /* save game match */
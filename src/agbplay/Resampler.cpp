@@ -2,55 +2,268 @@
 
 #include "Debug.hpp"
 #include "ResamplerAVX2.hpp"
+#include "ResamplerAVX512.hpp"
+#include "ResamplerNEON.hpp"
+#include "ResamplerSSE41.hpp"
 #include "Util.hpp"
+#include "Xcept.hpp"
 
 #include <boost/math/special_functions/sinc.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
 
-const bool AVX2_SUPPORTED = []() {
+template<typename T> static std::unique_ptr<Resampler> makeResampler()
+{
+    return std::make_unique<T>();
+}
+
+/* Dot products for the polyphase modes, see Resampler::resamplePolyphase.
+ * Four partial sums, so the additions do not form a single dependency chain. */
+static const auto scalarDot = [](const float *kernel, const float *src, size_t taps) {
+    std::array<float, 4> sum{};
+    for (size_t i = 0; i < taps; i += 4) {
+        for (size_t j = 0; j < 4; j++)
+            sum[j] += kernel[i + j] * src[i + j];
+    }
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+};
+
+static const auto scalarDot2 =
+    [](const float *kernel0, const float *kernel1, const float *src, size_t taps, float &sum0, float &sum1) {
+        sum0 = scalarDot(kernel0, src, taps);
+        sum1 = scalarDot(kernel1, src, taps);
+    };
+
+static bool cpuSupports(ResamplerSimd simd)
+{
 #if defined(__x86_64__) || defined(i386) || defined(__i386__) || defined(__386)
     __builtin_cpu_init();
-    if (__builtin_cpu_supports("avx2"))
-        return std::getenv("AGBPLAY_NO_AVX") ? false : true;
-    else
+    switch (simd) {
+    case ResamplerSimd::SCALAR:
+        return true;
+    case ResamplerSimd::SSE41:
+        return __builtin_cpu_supports("sse4.1");
+    case ResamplerSimd::NEON:
         return false;
+    case ResamplerSimd::AVX2:
+        return __builtin_cpu_supports("avx2");
+    case ResamplerSimd::AVX512:
+        return __builtin_cpu_supports("avx512f");
+    }
+    return false;
 #elif defined(_M_X64) || defined(_M_IX86)
-    static_assert(false, "AVX2 detection in MSVC is not yet implemented");
+    static_assert(false, "SIMD detection in MSVC is not yet implemented");
+#elif defined(__aarch64__) && __has_include(<arm_neon.h>)
+    return simd == ResamplerSimd::SCALAR || simd == ResamplerSimd::NEON;
 #else
-    return false;
+    return simd == ResamplerSimd::SCALAR;
 #endif
-}();
+}
+
+struct SimdVariant
+{
+    ResamplerSimd simd;
+    const char *name;
+    bool supported;
+    std::unique_ptr<Resampler> (*makeSinc)();
+    std::unique_ptr<Resampler> (*makeBlep)();
+    std::unique_ptr<Resampler> (*makeBlamp)();
+};
+
+/* indexed by ResamplerSimd */
+static const std::array<SimdVariant, 5> SIMD_VARIANTS{{
+    {
+        ResamplerSimd::SCALAR,
+        "scalar",
+        cpuSupports(ResamplerSimd::SCALAR),
+        makeResampler<SincResampler>,
+        makeResampler<BlepResampler>,
+        makeResampler<BlampResampler>,
+    },
+    {
+        ResamplerSimd::SSE41,
+        "sse4.1",
+        cpuSupports(ResamplerSimd::SSE41),
+        makeResampler<SincResamplerSSE41>,
+        makeResampler<BlepResamplerSSE41>,
+        makeResampler<BlampResamplerSSE41>,
+    },
+    {
+        ResamplerSimd::NEON,
+        "neon",
+        cpuSupports(ResamplerSimd::NEON),
+        makeResampler<SincResamplerNEON>,
+        makeResampler<BlepResamplerNEON>,
+        makeResampler<BlampResamplerNEON>,
+    },
+    {
+        ResamplerSimd::AVX2,
+        "avx2",
+        cpuSupports(ResamplerSimd::AVX2),
+        makeResampler<SincResamplerAVX2>,
+        makeResampler<BlepResamplerAVX2>,
+        makeResampler<BlampResamplerAVX2>,
+    },
+    {
+        ResamplerSimd::AVX512,
+        "avx512",
+        cpuSupports(ResamplerSimd::AVX512),
+        makeResampler<SincResamplerAVX512>,
+        makeResampler<BlepResamplerAVX512>,
+        makeResampler<BlampResamplerAVX512>,
+    },
+}};
+
+static ResamplerSimd selectSimd()
+{
+    if (const char *name = std::getenv("AGBPLAY_SIMD")) {
+        for (const SimdVariant &v : SIMD_VARIANTS) {
+            if (strcmp(v.name, name) != 0)
+                continue;
+            if (v.supported)
+                return v.simd;
+            Debug::print("AGBPLAY_SIMD: {} is not supported by this CPU, ignoring", name);
+            break;
+        }
+    }
+
+    const bool noAvx = std::getenv("AGBPLAY_NO_AVX") != nullptr;
+    for (size_t i = SIMD_VARIANTS.size(); i-- > 0;) {
+        const SimdVariant &v = SIMD_VARIANTS[i];
+        if (noAvx && (v.simd == ResamplerSimd::AVX2 || v.simd == ResamplerSimd::AVX512))
+            continue;
+        if (v.supported)
+            return v.simd;
+    }
+    return ResamplerSimd::SCALAR;
+}
+
+/* indexed by ResamplerPolyphase */
+static const std::array<const char *, 3> POLYPHASE_NAMES{"off", "nearest", "linear"};
+
+static std::optional<ResamplerPolyphase> selectPolyphase()
+{
+    if (const char *name = std::getenv("AGBPLAY_POLYPHASE")) {
+        for (size_t i = 0; i < POLYPHASE_NAMES.size(); i++) {
+            if (strcmp(POLYPHASE_NAMES[i], name) == 0)
+                return static_cast<ResamplerPolyphase>(i);
+        }
+        Debug::print("AGBPLAY_POLYPHASE: unknown mode {}, ignoring", name);
+    }
+    return std::nullopt;
+}
+
+std::unique_ptr<Resampler> Resampler::MakeResampler(ResamplerType t, ResamplerPolyphase polyphase)
+{
+    return MakeResampler(t, GetActiveSimd(), GetActivePolyphase(polyphase));
+}
 
-std::unique_ptr<Resampler> Resampler::MakeResampler(ResamplerType t)
+std::unique_ptr<Resampler> Resampler::MakeResampler(ResamplerType t, ResamplerSimd simd)
 {
+    return MakeResampler(t, simd, GetActivePolyphase(ResamplerPolyphase::OFF));
+}
+
+std::unique_ptr<Resampler> Resampler::MakeResampler(ResamplerType t, ResamplerSimd simd, ResamplerPolyphase polyphase)
+{
+    const SimdVariant &v = SIMD_VARIANTS.at(static_cast<size_t>(simd));
+    if (!v.supported)
+        throw Xcept("MakeResampler: SIMD variant {} is not supported by this CPU", v.name);
+
+    std::unique_ptr<Resampler> rs;
     switch (t) {
     case ResamplerType::NEAREST:
-        return std::make_unique<NearestResampler>();
+        rs = std::make_unique<NearestResampler>();
+        rs->type = t;
+        return rs;
     case ResamplerType::LINEAR:
-        return std::make_unique<LinearResampler>();
+        rs = std::make_unique<LinearResampler>();
+        rs->type = t;
+        return rs;
     case ResamplerType::SINC:
-        if (AVX2_SUPPORTED)
-            return std::make_unique<SincResamplerAVX2>();
-        else
-            return std::make_unique<SincResampler>();
+        rs = v.makeSinc();
+        break;
     case ResamplerType::BLEP:
-        if (AVX2_SUPPORTED)
-            return std::make_unique<BlepResamplerAVX2>();
-        else
-            return std::make_unique<BlepResampler>();
+        rs = v.makeBlep();
+        break;
     case ResamplerType::BLAMP:
-        if (AVX2_SUPPORTED)
-            return std::make_unique<BlampResamplerAVX2>();
-        else
-            return std::make_unique<BlampResampler>();
+        rs = v.makeBlamp();
+        break;
+    }
+    if (!rs)
+        throw std::logic_error("MakeResampler: Trying to to instantiate resampler for invalid enum value");
+    rs->polyphase = polyphase;
+    rs->type = t;
+    rs->simd = simd;
+    return rs;
+}
+
+std::unique_ptr<Resampler> Resampler::Clone() const
+{
+    /* None of the subclasses have any state of their own, so copying the state of the base is sufficient. */
+    std::unique_ptr<Resampler> rs = MakeResampler(type, simd, polyphase);
+    rs->fetchBuffer = fetchBuffer;
+    rs->phase = phase;
+    rs->polyphaseBank = polyphaseBank;
+    return rs;
+}
+
+ResamplerSimd Resampler::GetActiveSimd()
+{
+    static const ResamplerSimd activeSimd = selectSimd();
+    return activeSimd;
+}
+
+bool Resampler::IsSimdSupported(ResamplerSimd simd)
+{
+    return SIMD_VARIANTS.at(static_cast<size_t>(simd)).supported;
+}
+
+const char *Resampler::GetSimdName(ResamplerSimd simd)
+{
+    return SIMD_VARIANTS.at(static_cast<size_t>(simd)).name;
+}
+
+ResamplerPolyphase Resampler::GetActivePolyphase(ResamplerPolyphase configured)
+{
+    static const std::optional<ResamplerPolyphase> overridePolyphase = selectPolyphase();
+    return overridePolyphase.value_or(configured);
+}
+
+const char *Resampler::GetPolyphaseName(ResamplerPolyphase polyphase)
+{
+    return POLYPHASE_NAMES.at(static_cast<size_t>(polyphase));
+}
+
+void Resampler::PolyphaseBank::Update(float newSincStep, KernelFunc kernelFunc)
+{
+    if (newSincStep == sincStep && !coeffs.empty())
+        return;
+
+    sincStep = newSincStep;
+    coeffs.resize((PHASES + 1) * TAPS);
+    for (size_t p = 0; p <= PHASES; p++) {
+        const std::span<float> row(&coeffs[p * TAPS], TAPS);
+        kernelFunc(float(p) / float(PHASES), sincStep, row);
+
+        // normalizing here saves the division by the kernel sum for every output sample
+        float kernelSum = 0.0f;
+        for (const float k : row)
+            kernelSum += k;
+        for (float &k : row)
+            k /= kernelSum;
     }
-    throw std::logic_error("MakeResampler: Trying to to instantiate resampler for invalid enum value");
+}
+
+Resampler::Resampler(size_t fetchMargin, size_t leadIn) : fetchMargin(fetchMargin), leadIn(leadIn)
+{
 }
 
 Resampler::~Resampler()
 {
 }
 
-NearestResampler::NearestResampler()
+NearestResampler::NearestResampler() : Resampler(0, 0)
 {
 }
 
@@ -64,34 +277,21 @@ void NearestResampler::Reset()
     phase = 0.0f;
 }
 
-bool NearestResampler::Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback)
+size_t NearestResampler::Resample(std::span<float> buffer, float phaseInc, const float *src)
 {
-    if (buffer.size() == 0)
-        return true;
-
-    phaseInc = std::max(phaseInc, 0.0f);
-
-    size_t samplesRequired = size_t(phase + phaseInc * static_cast<float>(buffer.size()));
-    // be sure and fetch one more sample in case of odd rounding errors
-    samplesRequired += 1;
-    const bool continuePlayback = fetchCallback(fetchBuffer, samplesRequired);
-
     int32_t fi = 0;
     for (size_t i = 0; i < buffer.size(); i++) {
-        buffer[i] = fetchBuffer[static_cast<size_t>(fi)];
+        buffer[i] = src[static_cast<size_t>(fi)];
         phase += phaseInc;
         const int32_t istep = static_cast<int32_t>(phase);
         phase -= static_cast<float>(istep);
         fi += istep;
     }
 
-    // remove first fi elements from the fetch buffer since they are no longer needed
-    fetchBuffer.erase(fetchBuffer.begin(), fetchBuffer.begin() + fi);
-
-    return continuePlayback;
+    return static_cast<size_t>(fi);
 }
 
-LinearResampler::LinearResampler()
+LinearResampler::LinearResampler() : Resampler(1, 0)
 {
     Reset();
 }
@@ -106,24 +306,12 @@ void LinearResampler::Reset()
     phase = 0.0f;
 }
 
-bool LinearResampler::Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback)
+size_t LinearResampler::Resample(std::span<float> buffer, float phaseInc, const float *src)
 {
-    if (buffer.size() == 0)
-        return true;
-
-    phaseInc = std::max(phaseInc, 0.0f);
-
-    size_t samplesRequired = static_cast<size_t>(phase + phaseInc * static_cast<float>(buffer.size()));
-    // be sure and fetch one more sample in case of odd rounding errors
-    samplesRequired += 1;
-    // fetch one more for linear interpolation
-    samplesRequired += 1;
-    const bool continuePlayback = fetchCallback(fetchBuffer, samplesRequired);
-
     int32_t fi = 0;
     for (size_t i = 0; i < buffer.size(); i++) {
-        const float a = fetchBuffer[static_cast<size_t>(fi)];
-        const float b = fetchBuffer[static_cast<size_t>(fi) + 1];
+        const float a = src[static_cast<size_t>(fi)];
+        const float b = src[static_cast<size_t>(fi) + 1];
         buffer[i] = a + phase * (b - a);
         phase += phaseInc;
         const int32_t istep = static_cast<int32_t>(phase);
@@ -131,13 +319,10 @@ bool LinearResampler::Process(std::span<float> buffer, float phaseInc, const Fet
         fi += istep;
     }
 
-    // remove first fi elements from the fetch buffer since they are no longer needed
-    fetchBuffer.erase(fetchBuffer.begin(), fetchBuffer.begin() + fi);
-
-    return continuePlayback;
+    return static_cast<size_t>(fi);
 }
 
-SincResampler::SincResampler()
+SincResampler::SincResampler() : Resampler(INTERP_FILTER_SIZE * 2, INTERP_FILTER_SIZE)
 {
     Reset();
 }
@@ -149,25 +334,19 @@ SincResampler::~SincResampler()
 void SincResampler::Reset()
 {
     fetchBuffer.clear();
-    fetchBuffer.resize(INTERP_FILTER_SIZE, 0.0f);
+    fetchBuffer.resize(leadIn, 0.0f);
     phase = 0.0f;
 }
 
-bool SincResampler::Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback)
+size_t SincResampler::Resample(std::span<float> buffer, float phaseInc, const float *src)
 {
-    if (buffer.size() == 0)
-        return true;
-
-    phaseInc = std::max(phaseInc, 0.0f);
-
-    size_t samplesRequired = static_cast<size_t>(phase + phaseInc * static_cast<float>(buffer.size()));
-    // be sure and fetch one more sample in case of odd rounding errors
-    samplesRequired += 1;
-    // fetch a few more for complete windowed sinc interpolation
-    samplesRequired += INTERP_FILTER_SIZE * 2;
-    const bool continuePlayback = fetchCallback(fetchBuffer, samplesRequired);
     const float sincStep = phaseInc > INTERP_FILTER_CUTOFF_FREQ ? INTERP_FILTER_CUTOFF_FREQ / phaseInc : 1.00f;
 
+    if (polyphase != ResamplerPolyphase::OFF) {
+        polyphaseBank.Update(sincStep, polyphaseKernel);
+        return resamplePolyphase(buffer, phaseInc, src, scalarDot, scalarDot2);
+    }
+
     int32_t fi = 0;
     for (size_t i = 0; i < buffer.size(); i++) {
         float sampleSum = 0.0f;
@@ -179,7 +358,7 @@ bool SincResampler::Process(std::span<float> buffer, float phaseInc, const Fetch
             const float s = fast_sincf(sincIndex);
             const float w = window_func(windowIndex);
             const float kernel = s * w;
-            sampleSum += kernel * fetchBuffer[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1];
+            sampleSum += kernel * src[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1];
             kernelSum += kernel;
         }
 
@@ -191,10 +370,16 @@ bool SincResampler::Process(std::span<float> buffer, float phaseInc, const Fetch
         buffer[i] = sampleSum / kernelSum;
     }
 
-    // remove first fi elements from the fetch buffer since they are no longer needed
-    fetchBuffer.erase(fetchBuffer.begin(), fetchBuffer.begin() + fi);
+    return static_cast<size_t>(fi);
+}
 
-    return continuePlayback;
+void SincResampler::polyphaseKernel(float phase, float sincStep, std::span<float> kernel)
+{
+    for (int wi = -INTERP_FILTER_SIZE + 1; wi <= INTERP_FILTER_SIZE; wi++) {
+        const float windowIndex = float(wi) - phase;
+        kernel[static_cast<size_t>(wi + INTERP_FILTER_SIZE) - 1] =
+            fast_sincf(windowIndex * sincStep) * window_func(windowIndex);
+    }
 }
 
 /*
@@ -270,7 +455,7 @@ inline float SincResampler::window_func(float t)
     return winLut[left_index] + fraction * (winLut[right_index] - winLut[left_index]);
 }
 
-BlepResampler::BlepResampler()
+BlepResampler::BlepResampler() : Resampler(INTERP_FILTER_SIZE * 2, INTERP_FILTER_SIZE)
 {
     Reset();
 }
@@ -282,25 +467,19 @@ BlepResampler::~BlepResampler()
 void BlepResampler::Reset()
 {
     fetchBuffer.clear();
-    fetchBuffer.resize(INTERP_FILTER_SIZE, 0.0f);
+    fetchBuffer.resize(leadIn, 0.0f);
     phase = 0.0f;
 }
 
-bool BlepResampler::Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback)
+size_t BlepResampler::Resample(std::span<float> buffer, float phaseInc, const float *src)
 {
-    if (buffer.size() == 0)
-        return true;
-
-    phaseInc = std::max(phaseInc, 0.0f);
-
-    size_t samplesRequired = static_cast<size_t>(phase + phaseInc * static_cast<float>(buffer.size()));
-    // be sure and fetch one more sample in case of odd rounding errors
-    samplesRequired += 1;
-    // fetch a few more for complete windowed sinc interpolation
-    samplesRequired += INTERP_FILTER_SIZE * 2;
-    const bool continuePlayback = fetchCallback(fetchBuffer, samplesRequired);
     const float sincStep = INTERP_FILTER_CUTOFF_FREQ / phaseInc;
 
+    if (polyphase != ResamplerPolyphase::OFF) {
+        polyphaseBank.Update(sincStep, polyphaseKernel);
+        return resamplePolyphase(buffer, phaseInc, src, scalarDot, scalarDot2);
+    }
+
     int32_t fi = 0;
     for (size_t i = 0; i < buffer.size(); i++) {
         float sampleSum = 0.0f;
@@ -311,7 +490,7 @@ bool BlepResampler::Process(std::span<float> buffer, float phaseInc, const Fetch
         for (int wi = -INTERP_FILTER_SIZE + 1; wi <= INTERP_FILTER_SIZE; wi++) {
             const float sr = fast_Si((float(wi) - phase + 0.5f) * sincStep);
             const float kernel = sr - sl;
-            sampleSum += kernel * fetchBuffer[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1];
+            sampleSum += kernel * src[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1];
             kernelSum += kernel;
             sl = sr;
         }
@@ -325,9 +504,17 @@ bool BlepResampler::Process(std::span<float> buffer, float phaseInc, const Fetch
     }
 
     // remove first i elements from the fetch buffer since they are no longer needed
-    fetchBuffer.erase(fetchBuffer.begin(), fetchBuffer.begin() + fi);
+    return static_cast<size_t>(fi);
+}
 
-    return continuePlayback;
+void BlepResampler::polyphaseKernel(float phase, float sincStep, std::span<float> kernel)
+{
+    float sl = fast_Si((float(-INTERP_FILTER_SIZE + 1) - phase - 0.5f) * sincStep);
+    for (int wi = -INTERP_FILTER_SIZE + 1; wi <= INTERP_FILTER_SIZE; wi++) {
+        const float sr = fast_Si((float(wi) - phase + 0.5f) * sincStep);
+        kernel[static_cast<size_t>(wi + INTERP_FILTER_SIZE) - 1] = sr - sl;
+        sl = sr;
+    }
 }
 
 const std::array<float, Resampler::INTERP_FILTER_LUT_SIZE + 2> BlepResampler::SiLut = []() {
@@ -353,7 +540,7 @@ const std::array<float, Resampler::INTERP_FILTER_LUT_SIZE + 2> BlepResampler::Si
     return l;
 }();
 
-BlampResampler::BlampResampler()
+BlampResampler::BlampResampler() : Resampler(INTERP_FILTER_SIZE * 2, INTERP_FILTER_SIZE)
 {
     Reset();
 }
@@ -365,25 +552,19 @@ BlampResampler::~BlampResampler()
 void BlampResampler::Reset()
 {
     fetchBuffer.clear();
-    fetchBuffer.resize(INTERP_FILTER_SIZE, 0.0f);
+    fetchBuffer.resize(leadIn, 0.0f);
     phase = 0.0f;
 }
 
-bool BlampResampler::Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback)
+size_t BlampResampler::Resample(std::span<float> buffer, float phaseInc, const float *src)
 {
-    if (buffer.size() == 0)
-        return true;
-
-    phaseInc = std::max(phaseInc, 0.0f);
-
-    size_t samplesRequired = static_cast<size_t>(phase + phaseInc * static_cast<float>(buffer.size()));
-    // be sure and fetch one more sample in case of odd rounding errors
-    samplesRequired += 1;
-    // fetch a few more for complete windowed sinc interpolation
-    samplesRequired += INTERP_FILTER_SIZE * 2;
-    const bool continuePlayback = fetchCallback(fetchBuffer, samplesRequired);
     const float sincStep = INTERP_FILTER_CUTOFF_FREQ / phaseInc;
 
+    if (polyphase != ResamplerPolyphase::OFF) {
+        polyphaseBank.Update(sincStep, polyphaseKernel);
+        return resamplePolyphase(buffer, phaseInc, src, scalarDot, scalarDot2);
+    }
+
     int32_t fi = 0;
     for (size_t i = 0; i < buffer.size(); i++) {
         float sampleSum = 0.0f;
@@ -396,7 +577,7 @@ bool BlampResampler::Process(std::span<float> buffer, float phaseInc, const Fetc
             const float TiIndexRight = (float(wi) - phase + 1.0f) * sincStep;
             const float sr = fast_Ti(TiIndexRight);
             const float kernel = sr - 2.0f * sm + sl;
-            sampleSum += kernel * fetchBuffer[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1];
+            sampleSum += kernel * src[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1];
             kernelSum += kernel;
             sl = sm;
             sm = sr;
@@ -411,9 +592,19 @@ bool BlampResampler::Process(std::span<float> buffer, float phaseInc, const Fetc
     }
 
     // remove first i elements from the fetch buffer since they are no longer needed
-    fetchBuffer.erase(fetchBuffer.begin(), fetchBuffer.begin() + fi);
+    return static_cast<size_t>(fi);
+}
 
-    return continuePlayback;
+void BlampResampler::polyphaseKernel(float phase, float sincStep, std::span<float> kernel)
+{
+    float sl = fast_Ti((float(-INTERP_FILTER_SIZE + 1) - phase - 1.0f) * sincStep);
+    float sm = fast_Ti((float(-INTERP_FILTER_SIZE + 1) - phase) * sincStep);
+    for (int wi = -INTERP_FILTER_SIZE + 1; wi <= INTERP_FILTER_SIZE; wi++) {
+        const float sr = fast_Ti((float(wi) - phase + 1.0f) * sincStep);
+        kernel[static_cast<size_t>(wi + INTERP_FILTER_SIZE) - 1] = sr - 2.0f * sm + sl;
+        sl = sm;
+        sm = sr;
+    }
 }
 
 // I call "Ti" the integral of Si function. I don't know its proper name
@@ -2,33 +2,149 @@
 
 #include "Types.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
-#include <functional>
 #include <memory>
 #include <span>
 #include <vector>
 
+/* SIMD instruction set the sinc/BLEP/BLAMP resamplers are implemented with.
+ * Sorted from least to most preferred. */
+enum class ResamplerSimd : int { SCALAR, SSE41, NEON, AVX2, AVX512 };
+
 /*
- * res_data_fetch_cb fetches samplesRequired samples to fetchBuffer
- * so that the buffer can provide exactly samplesRequired samples
+ * A sample source fetches samplesRequired samples to fetchBuffer
+ * so that the buffer can provide exactly samplesRequired samples.
+ * It is called as bool(std::vector<float> &fetchBuffer, size_t samplesRequired)
+ * and passed as template parameter, so the fetch can be inlined into Process.
  *
  * returns false in case of 'end of stream'
  */
-typedef std::function<bool(std::vector<float> &fetchBuffer, size_t samplesRequired)> FetchCallback;
-
 class Resampler
 {
 public:
-    static std::unique_ptr<Resampler> MakeResampler(ResamplerType t);
+    /* Creates a resampler with the active SIMD variant. The active variant is the best one the CPU supports,
+     * unless overridden by the environment: AGBPLAY_SIMD=<name> selects a variant by name,
+     * AGBPLAY_NO_AVX excludes the AVX2 and AVX512 variants. The polyphase mode is taken from
+     * GetActivePolyphase(polyphase). */
+    static std::unique_ptr<Resampler> MakeResampler(ResamplerType t, ResamplerPolyphase polyphase);
+    static std::unique_ptr<Resampler> MakeResampler(ResamplerType t, ResamplerSimd simd);
+    static std::unique_ptr<Resampler> MakeResampler(ResamplerType t, ResamplerSimd simd, ResamplerPolyphase polyphase);
+    /* Creates a resampler of the same type and SIMD variant, which continues exactly where this one is. */
+    std::unique_ptr<Resampler> Clone() const;
+    static ResamplerSimd GetActiveSimd();
+    static bool IsSimdSupported(ResamplerSimd simd);
+    static const char *GetSimdName(ResamplerSimd simd);
+    /* Returns the polyphase mode configured in the profile (AgbplaySoundMode::resamplerPolyphase), unless it is
+     * overridden by the environment: AGBPLAY_POLYPHASE=<name> (off, nearest or linear). */
+    static ResamplerPolyphase GetActivePolyphase(ResamplerPolyphase configured);
+    static const char *GetPolyphaseName(ResamplerPolyphase polyphase);
+    ResamplerType GetType() const { return type; }
+    ResamplerPolyphase GetPolyphase() const { return polyphase; }
 
     // return value false by Process signals the "end of stream"
-    virtual bool Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback) = 0;
+    template<typename Source> bool Process(std::span<float> buffer, float phaseInc, Source &&source)
+    {
+        if (buffer.size() == 0)
+            return true;
+
+        const bool continuePlayback = source(fetchBuffer, SamplesRequired(buffer.size(), phaseInc));
+
+        const size_t consumed = Resample(buffer, std::max(phaseInc, 0.0f), fetchBuffer.data());
+        fetchBuffer.erase(fetchBuffer.begin(), fetchBuffer.begin() + static_cast<std::ptrdiff_t>(consumed));
+        return continuePlayback;
+    }
+
+    /* Zero-copy variant of Process for sources which are already available as contiguous float array.
+     * src[0] is the oldest sample the resampler still needs, which initially is LeadIn() samples before
+     * the first sample of the stream. SamplesRequired() samples must be readable from src.
+     * Returns by how many samples src has to be advanced for the next call.
+     * Process and ProcessDirect must not be mixed without a Reset in between. */
+    size_t ProcessDirect(std::span<float> buffer, float phaseInc, const float *src)
+    {
+        if (buffer.size() == 0)
+            return 0;
+        return Resample(buffer, std::max(phaseInc, 0.0f), src);
+    }
+
+    /* Advances exactly like Process for numSamples output samples, including the fetch from source,
+     * but without calculating any output. Used to skip through a song without rendering it. */
+    template<typename Source> bool Skip(size_t numSamples, float phaseInc, Source &&source)
+    {
+        if (numSamples == 0)
+            return true;
+
+        const bool continuePlayback = source(fetchBuffer, SamplesRequired(numSamples, phaseInc));
+
+        const size_t consumed = advance(numSamples, std::max(phaseInc, 0.0f));
+        fetchBuffer.erase(fetchBuffer.begin(), fetchBuffer.begin() + static_cast<std::ptrdiff_t>(consumed));
+        return continuePlayback;
+    }
+
+    /* Same as Skip for ProcessDirect, returns by how many samples src has to be advanced. */
+    size_t SkipDirect(size_t numSamples, float phaseInc)
+    {
+        if (numSamples == 0)
+            return 0;
+        return advance(numSamples, std::max(phaseInc, 0.0f));
+    }
+
+    size_t SamplesRequired(size_t numSamples, float phaseInc) const
+    {
+        phaseInc = std::max(phaseInc, 0.0f);
+
+        size_t samplesRequired = static_cast<size_t>(phase + phaseInc * static_cast<float>(numSamples));
+        // be sure and fetch one more sample in case of odd rounding errors
+        samplesRequired += 1;
+        // fetch a few more for the interpolation filter
+        samplesRequired += fetchMargin;
+        return samplesRequired;
+    }
+
+    // number of (silent) samples the filter history starts with after Reset
+    size_t LeadIn() const { return leadIn; }
+
     virtual void Reset() = 0;
     virtual ~Resampler();
 
 protected:
+    Resampler(size_t fetchMargin, size_t leadIn);
+
+    /* Resample from src to buffer and return the number of samples which are no longer needed.
+     * Only called with a non-empty buffer and with enough samples available in src. */
+    virtual size_t Resample(std::span<float> buffer, float phaseInc, const float *src) = 0;
+
+    /* Steps the phase like every Resample implementation does and returns the number of consumed samples.
+     * Must stay in sync with them, otherwise Skip drifts away from Process. */
+    size_t advance(size_t numSamples, float phaseInc)
+    {
+        int32_t fi = 0;
+        if (phaseInc < 1.0f) {
+            /* phase + phaseInc stays below 2, so the step is either 0 or 1. Comparing instead of converting
+             * to int and back makes the loop carried dependency a lot shorter, with the same result. */
+            for (size_t i = 0; i < numSamples; i++) {
+                phase += phaseInc;
+                const bool step = phase >= 1.0f;
+                phase -= step ? 1.0f : 0.0f;
+                fi += step;
+            }
+            return static_cast<size_t>(fi);
+        }
+
+        for (size_t i = 0; i < numSamples; i++) {
+            phase += phaseInc;
+            const int32_t istep = static_cast<int32_t>(phase);
+            phase -= static_cast<float>(istep);
+            fi += istep;
+        }
+        return static_cast<size_t>(fi);
+    }
+
+    const size_t fetchMargin;
+    const size_t leadIn;
     std::vector<float> fetchBuffer;
     float phase = 0.0f;
 
@@ -47,6 +163,67 @@ protected:
      * A numerical integration is performed with N samples per value.
      * Not required to be power-of-two, but perhaps a good idea to be. */
     static inline const uint16_t INTEGRAL_RESOLUTION = 256;
+
+    /* Filter kernel precalculated for PHASES + 1 evenly spaced fractional phases from 0 to 1 (inclusive),
+     * each normalized to a sum of 1. The kernel depends on the sinc step, which depends on the pitch
+     * when downsampling (and always for BLEP/BLAMP), so the bank is recalculated whenever the step changes. */
+    class PolyphaseBank
+    {
+    public:
+        /* writes the TAPS kernel values for the given phase, not normalized */
+        using KernelFunc = void (*)(float phase, float sincStep, std::span<float> kernel);
+
+        void Update(float sincStep, KernelFunc kernelFunc);
+        const float *Row(size_t phaseIndex) const { return &coeffs[phaseIndex * TAPS]; }
+
+        static inline const size_t PHASES = 64;
+        static inline const size_t TAPS = INTERP_FILTER_SIZE * 2;
+
+    private:
+        std::vector<float> coeffs;
+        float sincStep = 0.0f;
+    };
+
+    /* Resampling loop for the polyphase modes, shared by all SIMD variants.
+     * dot(kernel, src, taps) returns the dot product of kernel and src, dot2(kernel0, kernel1, src, taps, sum0, sum1)
+     * does the same for two kernels at once. taps is always PolyphaseBank::TAPS. Pass lambdas instead of function
+     * pointers: every variant then gets its own instantiation, which is required since the variants are compiled
+     * with different instruction sets. */
+    template<typename Dot, typename Dot2>
+    size_t resamplePolyphase(std::span<float> buffer, float phaseInc, const float *src, Dot &&dot, Dot2 &&dot2)
+    {
+        const float phases = float(PolyphaseBank::PHASES);
+
+        int32_t fi = 0;
+        for (size_t i = 0; i < buffer.size(); i++) {
+            const float *s = &src[fi];
+            if (polyphase == ResamplerPolyphase::LINEAR) {
+                const float p = phase * phases;
+                const size_t pi = static_cast<size_t>(p);
+                const float fraction = p - static_cast<float>(pi);
+                float sum0, sum1;
+                dot2(polyphaseBank.Row(pi), polyphaseBank.Row(pi + 1), s, PolyphaseBank::TAPS, sum0, sum1);
+                buffer[i] = sum0 + fraction * (sum1 - sum0);
+            } else {
+                buffer[i] = dot(polyphaseBank.Row(static_cast<size_t>(phase * phases + 0.5f)), s, PolyphaseBank::TAPS);
+            }
+
+            phase += phaseInc;
+            const int32_t istep = static_cast<int32_t>(phase);
+            phase -= static_cast<float>(istep);
+            fi += istep;
+        }
+
+        return static_cast<size_t>(fi);
+    }
+
+    ResamplerPolyphase polyphase = ResamplerPolyphase::OFF;
+    PolyphaseBank polyphaseBank;
+
+private:
+    // as passed to MakeResampler, for Clone
+    ResamplerType type = ResamplerType::LINEAR;
+    ResamplerSimd simd = ResamplerSimd::SCALAR;
 };
 
 class NearestResampler : public Resampler
@@ -54,7 +231,7 @@ class NearestResampler : public Resampler
 public:
     NearestResampler();
     ~NearestResampler() override;
-    bool Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback) override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
     void Reset() override;
 };
 
@@ -63,7 +240,7 @@ class LinearResampler : public Resampler
 public:
     LinearResampler();
     ~LinearResampler() override;
-    bool Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback) override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
     void Reset() override;
 };
 
@@ -72,7 +249,7 @@ class SincResampler : public Resampler
 public:
     SincResampler();
     virtual ~SincResampler() override;
-    virtual bool Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback) override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
     void Reset() override;
 
 private:
@@ -82,6 +259,8 @@ private:
     static float window_func(float t);
 
 protected:
+    static void polyphaseKernel(float phase, float sincStep, std::span<float> kernel);
+
     static const std::array<float, INTERP_FILTER_LUT_SIZE> cosLut;
     static const std::array<float, INTERP_FILTER_LUT_SIZE + 2> sincLut;
     static const std::array<float, INTERP_FILTER_LUT_SIZE + 2> winLut;
@@ -92,7 +271,7 @@ class BlepResampler : public Resampler
 public:
     BlepResampler();
     virtual ~BlepResampler() override;
-    virtual bool Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback) override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
     void Reset() override;
 
 protected:
@@ -109,6 +288,8 @@ protected:
         return std::copysignf(retval, signed_t);
     }
 
+    static void polyphaseKernel(float phase, float sincStep, std::span<float> kernel);
+
     static const std::array<float, INTERP_FILTER_LUT_SIZE + 2> SiLut;
 };
 
@@ -117,7 +298,7 @@ class BlampResampler : public Resampler
 public:
     BlampResampler();
     ~BlampResampler() override;
-    bool Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback) override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
     void Reset() override;
 
 protected:
@@ -137,5 +318,7 @@ protected:
             return retval;
     }
 
+    static void polyphaseKernel(float phase, float sincStep, std::span<float> kernel);
+
     static const std::array<float, INTERP_FILTER_LUT_SIZE + 2> TiLut;
 };
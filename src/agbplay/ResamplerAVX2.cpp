@@ -1,5 +1,7 @@
 #include "ResamplerAVX2.hpp"
 
+#if __has_include(<immintrin.h>)
+
 #include <cmath>
 
 /* A few AVX2 helper functions */
@@ -39,24 +41,41 @@ static inline void avx2_hsum2(__m256 va, __m256 vb, float &a, float &b)
 static const __m256i rotateLeftConst = _mm256_set_epi32(6, 5, 4, 3, 2, 1, 0, 7);
 static const __m256i rotateLeft2Const = _mm256_set_epi32(5, 4, 3, 2, 1, 0, 7, 6);
 
+/* Dot products for the polyphase modes, see Resampler::resamplePolyphase. taps must be a multiple of 8. */
+static const auto avx2Dot = [](const float *kernel, const float *src, size_t taps) {
+    __m256 sumV = _mm256_setzero_ps();
+    for (size_t i = 0; i < taps; i += 8)
+        sumV = _mm256_add_ps(sumV, _mm256_mul_ps(_mm256_loadu_ps(&kernel[i]), _mm256_loadu_ps(&src[i])));
+    float sum, unused;
+    avx2_hsum2(sumV, _mm256_setzero_ps(), sum, unused);
+    return sum;
+};
+
+static const auto avx2Dot2 =
+    [](const float *kernel0, const float *kernel1, const float *src, size_t taps, float &sum0, float &sum1) {
+        __m256 sum0V = _mm256_setzero_ps();
+        __m256 sum1V = _mm256_setzero_ps();
+        for (size_t i = 0; i < taps; i += 8) {
+            const __m256 srcV = _mm256_loadu_ps(&src[i]);
+            sum0V = _mm256_add_ps(sum0V, _mm256_mul_ps(_mm256_loadu_ps(&kernel0[i]), srcV));
+            sum1V = _mm256_add_ps(sum1V, _mm256_mul_ps(_mm256_loadu_ps(&kernel1[i]), srcV));
+        }
+        avx2_hsum2(sum0V, sum1V, sum0, sum1);
+    };
+
 SincResamplerAVX2::~SincResamplerAVX2()
 {
 }
 
-bool SincResamplerAVX2::Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback)
+size_t SincResamplerAVX2::Resample(std::span<float> buffer, float phaseInc, const float *src)
 {
-    if (buffer.size() == 0)
-        return true;
+    const float sincStep = phaseInc > INTERP_FILTER_CUTOFF_FREQ ? INTERP_FILTER_CUTOFF_FREQ / phaseInc : 1.00f;
 
-    phaseInc = std::max(phaseInc, 0.0f);
+    if (polyphase != ResamplerPolyphase::OFF) {
+        polyphaseBank.Update(sincStep, polyphaseKernel);
+        return resamplePolyphase(buffer, phaseInc, src, avx2Dot, avx2Dot2);
+    }
 
-    size_t samplesRequired = static_cast<size_t>(phase + phaseInc * static_cast<float>(buffer.size()));
-    // be sure and fetch one more sample in case of odd rounding errors
-    samplesRequired += 1;
-    // fetch a few more for complete windowed sinc interpolation
-    samplesRequired += INTERP_FILTER_SIZE * 2;
-    const bool continuePlayback = fetchCallback(fetchBuffer, samplesRequired);
-    const float sincStep = phaseInc > INTERP_FILTER_CUTOFF_FREQ ? INTERP_FILTER_CUTOFF_FREQ / phaseInc : 1.00f;
     const __m256 sincStepV = _mm256_set1_ps(sincStep);
     const __m256i sincWinSizeV = _mm256_set1_epi32(INTERP_FILTER_SIZE);
 
@@ -76,7 +95,7 @@ bool SincResamplerAVX2::Process(std::span<float> buffer, float phaseInc, const F
             const __m256 wV = window_func(windowIndexV);
             const __m256 kernelV = _mm256_mul_ps(sV, wV);
             const __m256 fetchedSampleV =
-                _mm256_loadu_ps(&fetchBuffer[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1]);
+                _mm256_loadu_ps(&src[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1]);
             sampleSumV = _mm256_add_ps(sampleSumV, _mm256_mul_ps(kernelV, fetchedSampleV));
             kernelSumV = _mm256_add_ps(kernelSumV, kernelV);
         }
@@ -92,8 +111,7 @@ bool SincResamplerAVX2::Process(std::span<float> buffer, float phaseInc, const F
         buffer[i] = sampleSum / kernelSum;
     }
 
-    fetchBuffer.erase(fetchBuffer.begin(), fetchBuffer.begin() + fi);
-    return continuePlayback;
+    return static_cast<size_t>(fi);
 }
 
 inline __m256 SincResamplerAVX2::fast_sinf(__m256 t)
@@ -144,20 +162,15 @@ BlepResamplerAVX2::~BlepResamplerAVX2()
 {
 }
 
-bool BlepResamplerAVX2::Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback)
+size_t BlepResamplerAVX2::Resample(std::span<float> buffer, float phaseInc, const float *src)
 {
-    if (buffer.size() == 0)
-        return true;
+    const float sincStep = INTERP_FILTER_CUTOFF_FREQ / phaseInc;
 
-    phaseInc = std::max(phaseInc, 0.0f);
+    if (polyphase != ResamplerPolyphase::OFF) {
+        polyphaseBank.Update(sincStep, polyphaseKernel);
+        return resamplePolyphase(buffer, phaseInc, src, avx2Dot, avx2Dot2);
+    }
 
-    size_t samplesRequired = static_cast<size_t>(phase + phaseInc * static_cast<float>(buffer.size()));
-    // be sure and fetch one more sample in case of odd rounding errors
-    samplesRequired += 1;
-    // fetch a few more for complete windowed sinc interpolation
-    samplesRequired += INTERP_FILTER_SIZE * 2;
-    const bool continuePlayback = fetchCallback(fetchBuffer, samplesRequired);
-    const float sincStep = INTERP_FILTER_CUTOFF_FREQ / phaseInc;
     const __m256 sincStepV = _mm256_set1_ps(sincStep);
     const __m256i sincWinSizeV = _mm256_set1_epi32(INTERP_FILTER_SIZE);
 
@@ -180,7 +193,7 @@ bool BlepResamplerAVX2::Process(std::span<float> buffer, float phaseInc, const F
             const __m256 slV = _mm256_blend_ps(srRotV, slNextLoV, 0x01);
             const __m256 kernelV = _mm256_sub_ps(srV, slV);
             const __m256 fetchedSampleV =
-                _mm256_loadu_ps(&fetchBuffer[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1]);
+                _mm256_loadu_ps(&src[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1]);
             sampleSumV = _mm256_add_ps(sampleSumV, _mm256_mul_ps(kernelV, fetchedSampleV));
             kernelSumV = _mm256_add_ps(kernelSumV, kernelV);
             slNextLoV = srRotV;
@@ -196,8 +209,7 @@ bool BlepResamplerAVX2::Process(std::span<float> buffer, float phaseInc, const F
         buffer[i] = sampleSum / kernelSum;
     }
 
-    fetchBuffer.erase(fetchBuffer.begin(), fetchBuffer.begin() + fi);
-    return continuePlayback;
+    return static_cast<size_t>(fi);
 }
 
 inline __m256 BlepResamplerAVX2::fast_Si(__m256 t)
@@ -219,20 +231,15 @@ BlampResamplerAVX2::~BlampResamplerAVX2()
 {
 }
 
-bool BlampResamplerAVX2::Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback)
+size_t BlampResamplerAVX2::Resample(std::span<float> buffer, float phaseInc, const float *src)
 {
-    if (buffer.size() == 0)
-        return true;
+    const float sincStep = INTERP_FILTER_CUTOFF_FREQ / phaseInc;
 
-    phaseInc = std::max(phaseInc, 0.0f);
+    if (polyphase != ResamplerPolyphase::OFF) {
+        polyphaseBank.Update(sincStep, polyphaseKernel);
+        return resamplePolyphase(buffer, phaseInc, src, avx2Dot, avx2Dot2);
+    }
 
-    size_t samplesRequired = static_cast<size_t>(phase + phaseInc * static_cast<float>(buffer.size()));
-    // be sure and fetch one more sample in case of odd rounding errors
-    samplesRequired += 1;
-    // fetch a few more for complete windowed sinc interpolation
-    samplesRequired += INTERP_FILTER_SIZE * 2;
-    const bool continuePlayback = fetchCallback(fetchBuffer, samplesRequired);
-    const float sincStep = INTERP_FILTER_CUTOFF_FREQ / phaseInc;
     const __m256 sincStepV = _mm256_set1_ps(sincStep);
     const __m256i sincWinSizeV = _mm256_set1_epi32(INTERP_FILTER_SIZE);
 
@@ -257,7 +264,7 @@ bool BlampResamplerAVX2::Process(std::span<float> buffer, float phaseInc, const
             const __m256 smV = _mm256_shuffle_ps(slV, srV, 0b10011001);               // {6, 5, 4, 3, 2, 1, 0, -1}
             const __m256 kernelV = _mm256_add_ps(_mm256_sub_ps(_mm256_sub_ps(srV, smV), smV), slV);
             const __m256 fetchedSampleV =
-                _mm256_loadu_ps(&fetchBuffer[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1]);
+                _mm256_loadu_ps(&src[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1]);
             sampleSumV = _mm256_add_ps(sampleSumV, _mm256_mul_ps(kernelV, fetchedSampleV));
             kernelSumV = _mm256_add_ps(kernelSumV, kernelV);
             slNextLoV = srRotV;
@@ -274,8 +281,7 @@ bool BlampResamplerAVX2::Process(std::span<float> buffer, float phaseInc, const
         buffer[i] = sampleSum / kernelSum;
     }
 
-    fetchBuffer.erase(fetchBuffer.begin(), fetchBuffer.begin() + fi);
-    return continuePlayback;
+    return static_cast<size_t>(fi);
 }
 
 inline __m256 BlampResamplerAVX2::fast_Ti(__m256 t)
@@ -294,3 +300,5 @@ inline __m256 BlampResamplerAVX2::fast_Ti(__m256 t)
     const __m256 isOutOfRange = _mm256_cmp_ps(old_t, _mm256_set1_ps(float(INTERP_FILTER_SIZE)), _CMP_GT_OS);
     return _mm256_or_ps(_mm256_andnot_ps(isOutOfRange, retval), _mm256_and_ps(isOutOfRange, outOfRangeRetval));
 }
+
+#endif
@@ -10,7 +10,7 @@ class SincResamplerAVX2 : public SincResampler
 {
 public:
     ~SincResamplerAVX2() override;
-    bool Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback) override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
 
 private:
     static __m256 fast_sinf(__m256 t);
@@ -23,7 +23,7 @@ class BlepResamplerAVX2 : public BlepResampler
 {
 public:
     ~BlepResamplerAVX2() override;
-    virtual bool Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback) override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
 
 private:
     static __m256 fast_Si(__m256 t);
@@ -33,7 +33,7 @@ class BlampResamplerAVX2 : public BlampResampler
 {
 public:
     ~BlampResamplerAVX2() override;
-    bool Process(std::span<float> buffer, float phaseInc, const FetchCallback &fetchCallback) override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
 
 private:
     static __m256 fast_Ti(__m256 t);
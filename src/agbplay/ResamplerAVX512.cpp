@@ -0,0 +1,278 @@
+/* GCC 12 warns about the deliberately uninitialized pass-through operand in its own AVX512 intrinsics
+ * (_mm512_undefined_ps), which is a false positive. Only the intrinsics are excluded from the warning: it is
+ * reported at their location in the intrinsics header, so the code in this file is still checked. */
+#if defined(__GNUC__) && !defined(__clang__) && __has_include(<immintrin.h>)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#endif
+
+#include "ResamplerAVX512.hpp"
+
+#if __has_include(<immintrin.h>)
+
+#include <cmath>
+#include <cstdint>
+
+/* A few AVX512 helper functions.
+ * Only AVX512F is used, so float bit operations are done on the integer registers. */
+
+static inline __m512 avx512_copysign(__m512 x, __m512 s)
+{
+    const __m512i signMask = _mm512_set1_epi32(INT32_MIN);
+    return _mm512_castsi512_ps(_mm512_or_si512(
+        _mm512_andnot_si512(signMask, _mm512_castps_si512(x)), _mm512_and_si512(signMask, _mm512_castps_si512(s))
+    ));
+}
+
+/* t must be scaled to LUT index already */
+static inline __m512 avx512_lut_interp(const float *lut, __m512 t)
+{
+    const __m512i leftIndex = _mm512_cvttps_epi32(t);
+    const __m512 fraction = _mm512_sub_ps(t, _mm512_cvtepi32_ps(leftIndex));
+    const __m512i rightIndex = _mm512_add_epi32(leftIndex, _mm512_set1_epi32(1));
+    const __m512 leftFetch = _mm512_i32gather_ps(leftIndex, lut, sizeof(float));
+    const __m512 rightFetch = _mm512_i32gather_ps(rightIndex, lut, sizeof(float));
+    return _mm512_add_ps(leftFetch, _mm512_mul_ps(fraction, _mm512_sub_ps(rightFetch, leftFetch)));
+}
+
+/* Used with _mm512_permutex2var_ps(prev, idx, cur) to shift a vector up by one or two elements,
+ * filling the lowest elements with the highest elements of the previous vector.
+ * Unlike the AVX2 code these are not static globals: their initializers would run at load time,
+ * which would fault on CPUs without AVX512. */
+static inline __m512i avx512_shift_up1_idx()
+{
+    return _mm512_set_epi32(30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15);
+}
+
+static inline __m512i avx512_shift_up2_idx()
+{
+    return _mm512_set_epi32(29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14);
+}
+
+static inline __m512i avx512_lane_index1()
+{
+    return _mm512_set_epi32(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+}
+
+/* Dot products for the polyphase modes, see Resampler::resamplePolyphase. taps must be a multiple of 16. */
+static const auto avx512Dot = [](const float *kernel, const float *src, size_t taps) {
+    __m512 sumV = _mm512_setzero_ps();
+    for (size_t i = 0; i < taps; i += 16)
+        sumV = _mm512_fmadd_ps(_mm512_loadu_ps(&kernel[i]), _mm512_loadu_ps(&src[i]), sumV);
+    return _mm512_reduce_add_ps(sumV);
+};
+
+static const auto avx512Dot2 =
+    [](const float *kernel0, const float *kernel1, const float *src, size_t taps, float &sum0, float &sum1) {
+        __m512 sum0V = _mm512_setzero_ps();
+        __m512 sum1V = _mm512_setzero_ps();
+        for (size_t i = 0; i < taps; i += 16) {
+            const __m512 srcV = _mm512_loadu_ps(&src[i]);
+            sum0V = _mm512_fmadd_ps(_mm512_loadu_ps(&kernel0[i]), srcV, sum0V);
+            sum1V = _mm512_fmadd_ps(_mm512_loadu_ps(&kernel1[i]), srcV, sum1V);
+        }
+        sum0 = _mm512_reduce_add_ps(sum0V);
+        sum1 = _mm512_reduce_add_ps(sum1V);
+    };
+
+SincResamplerAVX512::~SincResamplerAVX512()
+{
+}
+
+size_t SincResamplerAVX512::Resample(std::span<float> buffer, float phaseInc, const float *src)
+{
+    const float sincStep = phaseInc > INTERP_FILTER_CUTOFF_FREQ ? INTERP_FILTER_CUTOFF_FREQ / phaseInc : 1.00f;
+
+    if (polyphase != ResamplerPolyphase::OFF) {
+        polyphaseBank.Update(sincStep, polyphaseKernel);
+        return resamplePolyphase(buffer, phaseInc, src, avx512Dot, avx512Dot2);
+    }
+
+    const __m512 sincStepV = _mm512_set1_ps(sincStep);
+    const __m512i sincWinSizeV = _mm512_set1_epi32(INTERP_FILTER_SIZE);
+
+    int32_t fi = 0;
+    for (size_t i = 0; i < buffer.size(); i++) {
+        __m512 sampleSumV = _mm512_setzero_ps();
+        __m512 kernelSumV = _mm512_setzero_ps();
+        const __m512 phaseV = _mm512_set1_ps(phase);
+        __m512i wiV = _mm512_sub_epi32(avx512_lane_index1(), sincWinSizeV);
+
+        for (int wi = -INTERP_FILTER_SIZE + 1; wi <= INTERP_FILTER_SIZE;
+             wi += 16, wiV = _mm512_add_epi32(wiV, _mm512_set1_epi32(16))) {
+            const __m512 windowIndexV = _mm512_sub_ps(_mm512_cvtepi32_ps(wiV), phaseV);
+            const __m512 sincIndexV = _mm512_mul_ps(windowIndexV, sincStepV);
+
+            const __m512 sV = fast_sincf(sincIndexV);
+            const __m512 wV = window_func(windowIndexV);
+            const __m512 kernelV = _mm512_mul_ps(sV, wV);
+            const __m512 fetchedSampleV =
+                _mm512_loadu_ps(&src[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1]);
+            sampleSumV = _mm512_add_ps(sampleSumV, _mm512_mul_ps(kernelV, fetchedSampleV));
+            kernelSumV = _mm512_add_ps(kernelSumV, kernelV);
+        }
+
+        const float kernelSum = _mm512_reduce_add_ps(kernelSumV);
+        const float sampleSum = _mm512_reduce_add_ps(sampleSumV);
+
+        phase += phaseInc;
+        const int32_t istep = static_cast<int32_t>(phase);
+        phase -= static_cast<float>(istep);
+        fi += istep;
+
+        buffer[i] = sampleSum / kernelSum;
+    }
+
+    return static_cast<size_t>(fi);
+}
+
+inline __m512 SincResamplerAVX512::fast_sincf(__m512 t)
+{
+    t = _mm512_abs_ps(t);
+    t = _mm512_mul_ps(t, _mm512_set1_ps(float(double(INTERP_FILTER_LUT_SIZE) / double(INTERP_FILTER_SIZE))));
+    return avx512_lut_interp(sincLut.data(), t);
+}
+
+inline __m512 SincResamplerAVX512::window_func(__m512 t)
+{
+    t = _mm512_abs_ps(t);
+    t = _mm512_mul_ps(t, _mm512_set1_ps(float(double(INTERP_FILTER_LUT_SIZE) / double(INTERP_FILTER_SIZE))));
+    return avx512_lut_interp(winLut.data(), t);
+}
+
+BlepResamplerAVX512::~BlepResamplerAVX512()
+{
+}
+
+size_t BlepResamplerAVX512::Resample(std::span<float> buffer, float phaseInc, const float *src)
+{
+    const float sincStep = INTERP_FILTER_CUTOFF_FREQ / phaseInc;
+
+    if (polyphase != ResamplerPolyphase::OFF) {
+        polyphaseBank.Update(sincStep, polyphaseKernel);
+        return resamplePolyphase(buffer, phaseInc, src, avx512Dot, avx512Dot2);
+    }
+
+    const __m512 sincStepV = _mm512_set1_ps(sincStep);
+    const __m512i sincWinSizeV = _mm512_set1_epi32(INTERP_FILTER_SIZE);
+
+    int32_t fi = 0;
+    for (size_t i = 0; i < buffer.size(); i++) {
+        __m512 sampleSumV = _mm512_setzero_ps();
+        __m512 kernelSumV = _mm512_setzero_ps();
+        const __m512 phaseV = _mm512_set1_ps(phase);
+        __m512i wiV = _mm512_sub_epi32(avx512_lane_index1(), sincWinSizeV);
+
+        /* only the highest element is used for the first iteration */
+        const float sl = BlepResampler::fast_Si((float(-INTERP_FILTER_SIZE + 1) - phase - 0.5f) * sincStep);
+        __m512 srPrevV = _mm512_set1_ps(sl);
+
+        for (int wi = -INTERP_FILTER_SIZE + 1; wi <= INTERP_FILTER_SIZE;
+             wi += 16, wiV = _mm512_add_epi32(wiV, _mm512_set1_epi32(16))) {
+            const __m512 wiMPhaseV = _mm512_sub_ps(_mm512_cvtepi32_ps(wiV), phaseV);
+            const __m512 SiIndexRightV = _mm512_mul_ps(_mm512_add_ps(wiMPhaseV, _mm512_set1_ps(0.5f)), sincStepV);
+            const __m512 srV = fast_Si(SiIndexRightV);
+            const __m512 slV = _mm512_permutex2var_ps(srPrevV, avx512_shift_up1_idx(), srV);
+            const __m512 kernelV = _mm512_sub_ps(srV, slV);
+            const __m512 fetchedSampleV =
+                _mm512_loadu_ps(&src[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1]);
+            sampleSumV = _mm512_add_ps(sampleSumV, _mm512_mul_ps(kernelV, fetchedSampleV));
+            kernelSumV = _mm512_add_ps(kernelSumV, kernelV);
+            srPrevV = srV;
+        }
+
+        const float kernelSum = _mm512_reduce_add_ps(kernelSumV);
+        const float sampleSum = _mm512_reduce_add_ps(sampleSumV);
+
+        phase += phaseInc;
+        const int32_t istep = static_cast<int32_t>(phase);
+        phase -= static_cast<float>(istep);
+        fi += istep;
+
+        buffer[i] = sampleSum / kernelSum;
+    }
+
+    return static_cast<size_t>(fi);
+}
+
+inline __m512 BlepResamplerAVX512::fast_Si(__m512 t)
+{
+    const __m512 signed_t = t;
+    t = _mm512_abs_ps(t);
+    t = _mm512_min_ps(t, _mm512_set1_ps(float(INTERP_FILTER_SIZE)));
+    t = _mm512_mul_ps(t, _mm512_set1_ps(float(double(INTERP_FILTER_LUT_SIZE) / double(INTERP_FILTER_SIZE))));
+    return avx512_copysign(avx512_lut_interp(SiLut.data(), t), signed_t);
+}
+
+BlampResamplerAVX512::~BlampResamplerAVX512()
+{
+}
+
+size_t BlampResamplerAVX512::Resample(std::span<float> buffer, float phaseInc, const float *src)
+{
+    const float sincStep = INTERP_FILTER_CUTOFF_FREQ / phaseInc;
+
+    if (polyphase != ResamplerPolyphase::OFF) {
+        polyphaseBank.Update(sincStep, polyphaseKernel);
+        return resamplePolyphase(buffer, phaseInc, src, avx512Dot, avx512Dot2);
+    }
+
+    const __m512 sincStepV = _mm512_set1_ps(sincStep);
+    const __m512i sincWinSizeV = _mm512_set1_epi32(INTERP_FILTER_SIZE);
+
+    int32_t fi = 0;
+    for (size_t i = 0; i < buffer.size(); i++) {
+        __m512 sampleSumV = _mm512_setzero_ps();
+        __m512 kernelSumV = _mm512_setzero_ps();
+        const __m512 phaseV = _mm512_set1_ps(phase);
+        __m512i wiV = _mm512_sub_epi32(avx512_lane_index1(), sincWinSizeV);
+
+        /* only the two highest elements are used for the first iteration */
+        const float sl = BlampResampler::fast_Ti((float(-INTERP_FILTER_SIZE + 1) - phase - 1.0f) * sincStep);
+        const float sm = BlampResampler::fast_Ti((float(-INTERP_FILTER_SIZE + 1) - phase) * sincStep);
+        __m512 srPrevV = _mm512_set_ps(sm, sl, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+
+        for (int wi = -INTERP_FILTER_SIZE + 1; wi <= INTERP_FILTER_SIZE;
+             wi += 16, wiV = _mm512_add_epi32(wiV, _mm512_set1_epi32(16))) {
+            const __m512 wiMPhaseV = _mm512_sub_ps(_mm512_cvtepi32_ps(wiV), phaseV);
+            const __m512 TiIndexRightV = _mm512_mul_ps(_mm512_add_ps(wiMPhaseV, _mm512_set1_ps(1.0f)), sincStepV);
+            const __m512 srV = fast_Ti(TiIndexRightV);
+            const __m512 smV = _mm512_permutex2var_ps(srPrevV, avx512_shift_up1_idx(), srV);
+            const __m512 slV = _mm512_permutex2var_ps(srPrevV, avx512_shift_up2_idx(), srV);
+            const __m512 kernelV = _mm512_add_ps(_mm512_sub_ps(_mm512_sub_ps(srV, smV), smV), slV);
+            const __m512 fetchedSampleV =
+                _mm512_loadu_ps(&src[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1]);
+            sampleSumV = _mm512_add_ps(sampleSumV, _mm512_mul_ps(kernelV, fetchedSampleV));
+            kernelSumV = _mm512_add_ps(kernelSumV, kernelV);
+            srPrevV = srV;
+        }
+
+        const float kernelSum = _mm512_reduce_add_ps(kernelSumV);
+        const float sampleSum = _mm512_reduce_add_ps(sampleSumV);
+
+        phase += phaseInc;
+        const int32_t istep = static_cast<int32_t>(phase);
+        phase -= static_cast<float>(istep);
+        fi += istep;
+
+        buffer[i] = sampleSum / kernelSum;
+    }
+
+    return static_cast<size_t>(fi);
+}
+
+inline __m512 BlampResamplerAVX512::fast_Ti(__m512 t)
+{
+    t = _mm512_abs_ps(t);
+    const __m512 old_t = t;
+    t = _mm512_min_ps(t, _mm512_set1_ps(float(INTERP_FILTER_SIZE)));
+    t = _mm512_mul_ps(t, _mm512_set1_ps(float(double(INTERP_FILTER_LUT_SIZE) / double(INTERP_FILTER_SIZE))));
+    const __m512 retval = avx512_lut_interp(TiLut.data(), t);
+    const __m512 outOfRangeRetval = _mm512_mul_ps(old_t, _mm512_set1_ps(0.5f));
+    const __mmask16 isOutOfRange = _mm512_cmp_ps_mask(old_t, _mm512_set1_ps(float(INTERP_FILTER_SIZE)), _CMP_GT_OS);
+    return _mm512_mask_blend_ps(isOutOfRange, retval, outOfRangeRetval);
+}
+
+#endif
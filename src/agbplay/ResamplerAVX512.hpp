@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Resampler.hpp"
+
+#if __has_include(<immintrin.h>)
+
+#include <immintrin.h>
+
+class SincResamplerAVX512 : public SincResampler
+{
+public:
+    ~SincResamplerAVX512() override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
+
+private:
+    static __m512 fast_sincf(__m512 t);
+    static __m512 window_func(__m512 t);
+};
+
+class BlepResamplerAVX512 : public BlepResampler
+{
+public:
+    ~BlepResamplerAVX512() override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
+
+private:
+    static __m512 fast_Si(__m512 t);
+};
+
+class BlampResamplerAVX512 : public BlampResampler
+{
+public:
+    ~BlampResamplerAVX512() override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
+
+private:
+    static __m512 fast_Ti(__m512 t);
+};
+
+#else    // if AVX512 intrinsics header not available
+
+#include <stdexcept>
+
+class SincResamplerAVX512 : public SincResampler
+{
+public:
+    SincResamplerAVX512()
+    {
+        throw std::logic_error("Attempting to instantiate SincResamplerAVX512 on platform without AVX512");
+    }
+};
+
+class BlepResamplerAVX512 : public BlepResampler
+{
+public:
+    BlepResamplerAVX512()
+    {
+        throw std::logic_error("Attempting to instantiate BlepResamplerAVX512 on platform without AVX512");
+    }
+};
+
+class BlampResamplerAVX512 : public BlampResampler
+{
+public:
+    BlampResamplerAVX512()
+    {
+        throw std::logic_error("Attempting to instantiate BlampResamplerAVX512 on platform without AVX512");
+    }
+};
+
+#endif
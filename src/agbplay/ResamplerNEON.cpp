@@ -0,0 +1,253 @@
+#include "ResamplerNEON.hpp"
+
+#if defined(__aarch64__) && __has_include(<arm_neon.h>)
+
+#include <cmath>
+#include <cstdint>
+
+/* A few NEON helper functions */
+
+static inline float32x4_t neon_copysign(float32x4_t x, float32x4_t s)
+{
+    const uint32x4_t signMask = vdupq_n_u32(0x80000000u);
+    return vbslq_f32(signMask, s, x);
+}
+
+/* NEON has no gather, so the LUT is read with scalar loads. t must be scaled to LUT index already. */
+static inline float32x4_t neon_lut_interp(const float *lut, float32x4_t t)
+{
+    const int32x4_t leftIndex = vcvtq_s32_f32(t);
+    const float32x4_t fraction = vsubq_f32(t, vcvtq_f32_s32(leftIndex));
+    const int32_t i0 = vgetq_lane_s32(leftIndex, 0);
+    const int32_t i1 = vgetq_lane_s32(leftIndex, 1);
+    const int32_t i2 = vgetq_lane_s32(leftIndex, 2);
+    const int32_t i3 = vgetq_lane_s32(leftIndex, 3);
+    const float left[4] = {lut[i0], lut[i1], lut[i2], lut[i3]};
+    const float right[4] = {lut[i0 + 1], lut[i1 + 1], lut[i2 + 1], lut[i3 + 1]};
+    const float32x4_t leftFetch = vld1q_f32(left);
+    const float32x4_t rightFetch = vld1q_f32(right);
+    return vaddq_f32(leftFetch, vmulq_f32(fraction, vsubq_f32(rightFetch, leftFetch)));
+}
+
+static inline int32x4_t neon_wi_init(int32_t filterSize)
+{
+    const int32_t laneIndex[4] = {1, 2, 3, 4};
+    return vsubq_s32(vld1q_s32(laneIndex), vdupq_n_s32(filterSize));
+}
+
+/* Dot products for the polyphase modes, see Resampler::resamplePolyphase. taps must be a multiple of 4. */
+static const auto neonDot = [](const float *kernel, const float *src, size_t taps) {
+    float32x4_t sumV = vdupq_n_f32(0.0f);
+    for (size_t i = 0; i < taps; i += 4)
+        sumV = vmlaq_f32(sumV, vld1q_f32(&kernel[i]), vld1q_f32(&src[i]));
+    return vaddvq_f32(sumV);
+};
+
+static const auto neonDot2 =
+    [](const float *kernel0, const float *kernel1, const float *src, size_t taps, float &sum0, float &sum1) {
+        float32x4_t sum0V = vdupq_n_f32(0.0f);
+        float32x4_t sum1V = vdupq_n_f32(0.0f);
+        for (size_t i = 0; i < taps; i += 4) {
+            const float32x4_t srcV = vld1q_f32(&src[i]);
+            sum0V = vmlaq_f32(sum0V, vld1q_f32(&kernel0[i]), srcV);
+            sum1V = vmlaq_f32(sum1V, vld1q_f32(&kernel1[i]), srcV);
+        }
+        sum0 = vaddvq_f32(sum0V);
+        sum1 = vaddvq_f32(sum1V);
+    };
+
+SincResamplerNEON::~SincResamplerNEON()
+{
+}
+
+size_t SincResamplerNEON::Resample(std::span<float> buffer, float phaseInc, const float *src)
+{
+    const float sincStep = phaseInc > INTERP_FILTER_CUTOFF_FREQ ? INTERP_FILTER_CUTOFF_FREQ / phaseInc : 1.00f;
+
+    if (polyphase != ResamplerPolyphase::OFF) {
+        polyphaseBank.Update(sincStep, polyphaseKernel);
+        return resamplePolyphase(buffer, phaseInc, src, neonDot, neonDot2);
+    }
+
+    const float32x4_t sincStepV = vdupq_n_f32(sincStep);
+
+    int32_t fi = 0;
+    for (size_t i = 0; i < buffer.size(); i++) {
+        float32x4_t sampleSumV = vdupq_n_f32(0.0f);
+        float32x4_t kernelSumV = vdupq_n_f32(0.0f);
+        const float32x4_t phaseV = vdupq_n_f32(phase);
+        int32x4_t wiV = neon_wi_init(INTERP_FILTER_SIZE);
+
+        for (int wi = -INTERP_FILTER_SIZE + 1; wi <= INTERP_FILTER_SIZE;
+             wi += 4, wiV = vaddq_s32(wiV, vdupq_n_s32(4))) {
+            const float32x4_t windowIndexV = vsubq_f32(vcvtq_f32_s32(wiV), phaseV);
+            const float32x4_t sincIndexV = vmulq_f32(windowIndexV, sincStepV);
+
+            const float32x4_t sV = fast_sincf(sincIndexV);
+            const float32x4_t wV = window_func(windowIndexV);
+            const float32x4_t kernelV = vmulq_f32(sV, wV);
+            const float32x4_t fetchedSampleV =
+                vld1q_f32(&src[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1]);
+            sampleSumV = vaddq_f32(sampleSumV, vmulq_f32(kernelV, fetchedSampleV));
+            kernelSumV = vaddq_f32(kernelSumV, kernelV);
+        }
+
+        const float kernelSum = vaddvq_f32(kernelSumV);
+        const float sampleSum = vaddvq_f32(sampleSumV);
+
+        phase += phaseInc;
+        const int32_t istep = static_cast<int32_t>(phase);
+        phase -= static_cast<float>(istep);
+        fi += istep;
+
+        buffer[i] = sampleSum / kernelSum;
+    }
+
+    return static_cast<size_t>(fi);
+}
+
+inline float32x4_t SincResamplerNEON::fast_sincf(float32x4_t t)
+{
+    t = vabsq_f32(t);
+    t = vmulq_f32(t, vdupq_n_f32(float(double(INTERP_FILTER_LUT_SIZE) / double(INTERP_FILTER_SIZE))));
+    return neon_lut_interp(sincLut.data(), t);
+}
+
+inline float32x4_t SincResamplerNEON::window_func(float32x4_t t)
+{
+    t = vabsq_f32(t);
+    t = vmulq_f32(t, vdupq_n_f32(float(double(INTERP_FILTER_LUT_SIZE) / double(INTERP_FILTER_SIZE))));
+    return neon_lut_interp(winLut.data(), t);
+}
+
+BlepResamplerNEON::~BlepResamplerNEON()
+{
+}
+
+size_t BlepResamplerNEON::Resample(std::span<float> buffer, float phaseInc, const float *src)
+{
+    const float sincStep = INTERP_FILTER_CUTOFF_FREQ / phaseInc;
+
+    if (polyphase != ResamplerPolyphase::OFF) {
+        polyphaseBank.Update(sincStep, polyphaseKernel);
+        return resamplePolyphase(buffer, phaseInc, src, neonDot, neonDot2);
+    }
+
+    const float32x4_t sincStepV = vdupq_n_f32(sincStep);
+
+    int32_t fi = 0;
+    for (size_t i = 0; i < buffer.size(); i++) {
+        float32x4_t sampleSumV = vdupq_n_f32(0.0f);
+        float32x4_t kernelSumV = vdupq_n_f32(0.0f);
+        const float32x4_t phaseV = vdupq_n_f32(phase);
+        int32x4_t wiV = neon_wi_init(INTERP_FILTER_SIZE);
+
+        const float sl = BlepResampler::fast_Si((float(-INTERP_FILTER_SIZE + 1) - phase - 0.5f) * sincStep);
+        float32x4_t srPrevV = vdupq_n_f32(sl);
+
+        for (int wi = -INTERP_FILTER_SIZE + 1; wi <= INTERP_FILTER_SIZE;
+             wi += 4, wiV = vaddq_s32(wiV, vdupq_n_s32(4))) {
+            const float32x4_t wiMPhaseV = vsubq_f32(vcvtq_f32_s32(wiV), phaseV);
+            const float32x4_t SiIndexRightV = vmulq_f32(vaddq_f32(wiMPhaseV, vdupq_n_f32(0.5f)), sincStepV);
+            const float32x4_t srV = fast_Si(SiIndexRightV);
+            const float32x4_t slV = vextq_f32(srPrevV, srV, 3);
+            const float32x4_t kernelV = vsubq_f32(srV, slV);
+            const float32x4_t fetchedSampleV =
+                vld1q_f32(&src[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1]);
+            sampleSumV = vaddq_f32(sampleSumV, vmulq_f32(kernelV, fetchedSampleV));
+            kernelSumV = vaddq_f32(kernelSumV, kernelV);
+            srPrevV = srV;
+        }
+
+        const float kernelSum = vaddvq_f32(kernelSumV);
+        const float sampleSum = vaddvq_f32(sampleSumV);
+
+        phase += phaseInc;
+        const int32_t istep = static_cast<int32_t>(phase);
+        phase -= static_cast<float>(istep);
+        fi += istep;
+
+        buffer[i] = sampleSum / kernelSum;
+    }
+
+    return static_cast<size_t>(fi);
+}
+
+inline float32x4_t BlepResamplerNEON::fast_Si(float32x4_t t)
+{
+    const float32x4_t signed_t = t;
+    t = vabsq_f32(t);
+    t = vminq_f32(t, vdupq_n_f32(float(INTERP_FILTER_SIZE)));
+    t = vmulq_f32(t, vdupq_n_f32(float(double(INTERP_FILTER_LUT_SIZE) / double(INTERP_FILTER_SIZE))));
+    return neon_copysign(neon_lut_interp(SiLut.data(), t), signed_t);
+}
+
+BlampResamplerNEON::~BlampResamplerNEON()
+{
+}
+
+size_t BlampResamplerNEON::Resample(std::span<float> buffer, float phaseInc, const float *src)
+{
+    const float sincStep = INTERP_FILTER_CUTOFF_FREQ / phaseInc;
+
+    if (polyphase != ResamplerPolyphase::OFF) {
+        polyphaseBank.Update(sincStep, polyphaseKernel);
+        return resamplePolyphase(buffer, phaseInc, src, neonDot, neonDot2);
+    }
+
+    const float32x4_t sincStepV = vdupq_n_f32(sincStep);
+
+    int32_t fi = 0;
+    for (size_t i = 0; i < buffer.size(); i++) {
+        float32x4_t sampleSumV = vdupq_n_f32(0.0f);
+        float32x4_t kernelSumV = vdupq_n_f32(0.0f);
+        const float32x4_t phaseV = vdupq_n_f32(phase);
+        int32x4_t wiV = neon_wi_init(INTERP_FILTER_SIZE);
+
+        const float sl = BlampResampler::fast_Ti((float(-INTERP_FILTER_SIZE + 1) - phase - 1.0f) * sincStep);
+        const float sm = BlampResampler::fast_Ti((float(-INTERP_FILTER_SIZE + 1) - phase) * sincStep);
+        const float srPrevInit[4] = {0.0f, 0.0f, sl, sm};
+        float32x4_t srPrevV = vld1q_f32(srPrevInit);
+
+        for (int wi = -INTERP_FILTER_SIZE + 1; wi <= INTERP_FILTER_SIZE;
+             wi += 4, wiV = vaddq_s32(wiV, vdupq_n_s32(4))) {
+            const float32x4_t wiMPhaseV = vsubq_f32(vcvtq_f32_s32(wiV), phaseV);
+            const float32x4_t TiIndexRightV = vmulq_f32(vaddq_f32(wiMPhaseV, vdupq_n_f32(1.0f)), sincStepV);
+            const float32x4_t srV = fast_Ti(TiIndexRightV);
+            const float32x4_t smV = vextq_f32(srPrevV, srV, 3);
+            const float32x4_t slV = vextq_f32(srPrevV, srV, 2);
+            const float32x4_t kernelV = vaddq_f32(vsubq_f32(vsubq_f32(srV, smV), smV), slV);
+            const float32x4_t fetchedSampleV =
+                vld1q_f32(&src[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1]);
+            sampleSumV = vaddq_f32(sampleSumV, vmulq_f32(kernelV, fetchedSampleV));
+            kernelSumV = vaddq_f32(kernelSumV, kernelV);
+            srPrevV = srV;
+        }
+
+        const float kernelSum = vaddvq_f32(kernelSumV);
+        const float sampleSum = vaddvq_f32(sampleSumV);
+
+        phase += phaseInc;
+        const int32_t istep = static_cast<int32_t>(phase);
+        phase -= static_cast<float>(istep);
+        fi += istep;
+
+        buffer[i] = sampleSum / kernelSum;
+    }
+
+    return static_cast<size_t>(fi);
+}
+
+inline float32x4_t BlampResamplerNEON::fast_Ti(float32x4_t t)
+{
+    t = vabsq_f32(t);
+    const float32x4_t old_t = t;
+    t = vminq_f32(t, vdupq_n_f32(float(INTERP_FILTER_SIZE)));
+    t = vmulq_f32(t, vdupq_n_f32(float(double(INTERP_FILTER_LUT_SIZE) / double(INTERP_FILTER_SIZE))));
+    const float32x4_t retval = neon_lut_interp(TiLut.data(), t);
+    const float32x4_t outOfRangeRetval = vmulq_f32(old_t, vdupq_n_f32(0.5f));
+    const uint32x4_t isOutOfRange = vcgtq_f32(old_t, vdupq_n_f32(float(INTERP_FILTER_SIZE)));
+    return vbslq_f32(isOutOfRange, outOfRangeRetval, retval);
+}
+
+#endif
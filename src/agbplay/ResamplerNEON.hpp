@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Resampler.hpp"
+
+#if defined(__aarch64__) && __has_include(<arm_neon.h>)
+
+#include <arm_neon.h>
+
+class SincResamplerNEON : public SincResampler
+{
+public:
+    ~SincResamplerNEON() override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
+
+private:
+    static float32x4_t fast_sincf(float32x4_t t);
+    static float32x4_t window_func(float32x4_t t);
+};
+
+class BlepResamplerNEON : public BlepResampler
+{
+public:
+    ~BlepResamplerNEON() override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
+
+private:
+    static float32x4_t fast_Si(float32x4_t t);
+};
+
+class BlampResamplerNEON : public BlampResampler
+{
+public:
+    ~BlampResamplerNEON() override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
+
+private:
+    static float32x4_t fast_Ti(float32x4_t t);
+};
+
+#else    // if not AArch64 or no NEON intrinsics header available
+
+#include <stdexcept>
+
+class SincResamplerNEON : public SincResampler
+{
+public:
+    SincResamplerNEON()
+    {
+        throw std::logic_error("Attempting to instantiate SincResamplerNEON on platform without NEON");
+    }
+};
+
+class BlepResamplerNEON : public BlepResampler
+{
+public:
+    BlepResamplerNEON()
+    {
+        throw std::logic_error("Attempting to instantiate BlepResamplerNEON on platform without NEON");
+    }
+};
+
+class BlampResamplerNEON : public BlampResampler
+{
+public:
+    BlampResamplerNEON()
+    {
+        throw std::logic_error("Attempting to instantiate BlampResamplerNEON on platform without NEON");
+    }
+};
+
+#endif
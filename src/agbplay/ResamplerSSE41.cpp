@@ -0,0 +1,276 @@
+#include "ResamplerSSE41.hpp"
+
+#if __has_include(<smmintrin.h>)
+
+#include <cmath>
+#include <cstdint>
+
+/* A few SSE4.1 helper functions */
+
+static inline __m128 sse41_abs(__m128 x)
+{
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    return _mm_andnot_ps(signMask, x);
+}
+
+static inline __m128 sse41_copysign(__m128 x, __m128 s)
+{
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    return _mm_or_ps(_mm_andnot_ps(signMask, x), _mm_and_ps(signMask, s));
+}
+
+static inline void sse41_hsum2(__m128 va, __m128 vb, float &a, float &b)
+{
+    /* tmp[b[32],b[10] , a[32],a[10]] */
+    const __m128 tmp = _mm_hadd_ps(va, vb);
+    /* tmp2[b[3210],a[3210] , b[3210],a[3210]] */
+    const __m128 tmp2 = _mm_hadd_ps(tmp, tmp);
+    a = _mm_cvtss_f32(tmp2);
+    b = _mm_cvtss_f32(_mm_shuffle_ps(tmp2, tmp2, 0b00000001));
+}
+
+/* SSE has no gather, so the LUT is read with scalar loads. t must be scaled to LUT index already. */
+static inline __m128 sse41_lut_interp(const float *lut, __m128 t)
+{
+    const __m128i leftIndex = _mm_cvttps_epi32(t);
+    const __m128 fraction = _mm_sub_ps(t, _mm_cvtepi32_ps(leftIndex));
+    const int32_t i0 = _mm_cvtsi128_si32(leftIndex);
+    const int32_t i1 = _mm_extract_epi32(leftIndex, 1);
+    const int32_t i2 = _mm_extract_epi32(leftIndex, 2);
+    const int32_t i3 = _mm_extract_epi32(leftIndex, 3);
+    const __m128 leftFetch = _mm_set_ps(lut[i3], lut[i2], lut[i1], lut[i0]);
+    const __m128 rightFetch = _mm_set_ps(lut[i3 + 1], lut[i2 + 1], lut[i1 + 1], lut[i0 + 1]);
+    return _mm_add_ps(leftFetch, _mm_mul_ps(fraction, _mm_sub_ps(rightFetch, leftFetch)));
+}
+
+/* {cur[2], cur[1], cur[0], prev[3]} */
+static inline __m128 sse41_shift_up1(__m128 prev, __m128 cur)
+{
+    return _mm_castsi128_ps(_mm_alignr_epi8(_mm_castps_si128(cur), _mm_castps_si128(prev), 12));
+}
+
+/* {cur[1], cur[0], prev[3], prev[2]} */
+static inline __m128 sse41_shift_up2(__m128 prev, __m128 cur)
+{
+    return _mm_castsi128_ps(_mm_alignr_epi8(_mm_castps_si128(cur), _mm_castps_si128(prev), 8));
+}
+
+/* Dot products for the polyphase modes, see Resampler::resamplePolyphase. taps must be a multiple of 4. */
+static const auto sse41Dot = [](const float *kernel, const float *src, size_t taps) {
+    __m128 sumV = _mm_setzero_ps();
+    for (size_t i = 0; i < taps; i += 4)
+        sumV = _mm_add_ps(sumV, _mm_mul_ps(_mm_loadu_ps(&kernel[i]), _mm_loadu_ps(&src[i])));
+    float sum, unused;
+    sse41_hsum2(sumV, _mm_setzero_ps(), sum, unused);
+    return sum;
+};
+
+static const auto sse41Dot2 =
+    [](const float *kernel0, const float *kernel1, const float *src, size_t taps, float &sum0, float &sum1) {
+        __m128 sum0V = _mm_setzero_ps();
+        __m128 sum1V = _mm_setzero_ps();
+        for (size_t i = 0; i < taps; i += 4) {
+            const __m128 srcV = _mm_loadu_ps(&src[i]);
+            sum0V = _mm_add_ps(sum0V, _mm_mul_ps(_mm_loadu_ps(&kernel0[i]), srcV));
+            sum1V = _mm_add_ps(sum1V, _mm_mul_ps(_mm_loadu_ps(&kernel1[i]), srcV));
+        }
+        sse41_hsum2(sum0V, sum1V, sum0, sum1);
+    };
+
+SincResamplerSSE41::~SincResamplerSSE41()
+{
+}
+
+size_t SincResamplerSSE41::Resample(std::span<float> buffer, float phaseInc, const float *src)
+{
+    const float sincStep = phaseInc > INTERP_FILTER_CUTOFF_FREQ ? INTERP_FILTER_CUTOFF_FREQ / phaseInc : 1.00f;
+
+    if (polyphase != ResamplerPolyphase::OFF) {
+        polyphaseBank.Update(sincStep, polyphaseKernel);
+        return resamplePolyphase(buffer, phaseInc, src, sse41Dot, sse41Dot2);
+    }
+
+    const __m128 sincStepV = _mm_set1_ps(sincStep);
+    const __m128i sincWinSizeV = _mm_set1_epi32(INTERP_FILTER_SIZE);
+
+    int32_t fi = 0;
+    for (size_t i = 0; i < buffer.size(); i++) {
+        __m128 sampleSumV = _mm_setzero_ps();
+        __m128 kernelSumV = _mm_setzero_ps();
+        const __m128 phaseV = _mm_set1_ps(phase);
+        __m128i wiV = _mm_sub_epi32(_mm_set_epi32(4, 3, 2, 1), sincWinSizeV);
+
+        for (int wi = -INTERP_FILTER_SIZE + 1; wi <= INTERP_FILTER_SIZE;
+             wi += 4, wiV = _mm_add_epi32(wiV, _mm_set1_epi32(4))) {
+            const __m128 windowIndexV = _mm_sub_ps(_mm_cvtepi32_ps(wiV), phaseV);
+            const __m128 sincIndexV = _mm_mul_ps(windowIndexV, sincStepV);
+
+            const __m128 sV = fast_sincf(sincIndexV);
+            const __m128 wV = window_func(windowIndexV);
+            const __m128 kernelV = _mm_mul_ps(sV, wV);
+            const __m128 fetchedSampleV =
+                _mm_loadu_ps(&src[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1]);
+            sampleSumV = _mm_add_ps(sampleSumV, _mm_mul_ps(kernelV, fetchedSampleV));
+            kernelSumV = _mm_add_ps(kernelSumV, kernelV);
+        }
+
+        float kernelSum, sampleSum;
+        sse41_hsum2(kernelSumV, sampleSumV, kernelSum, sampleSum);
+
+        phase += phaseInc;
+        const int32_t istep = static_cast<int32_t>(phase);
+        phase -= static_cast<float>(istep);
+        fi += istep;
+
+        buffer[i] = sampleSum / kernelSum;
+    }
+
+    return static_cast<size_t>(fi);
+}
+
+inline __m128 SincResamplerSSE41::fast_sincf(__m128 t)
+{
+    t = sse41_abs(t);
+    t = _mm_mul_ps(t, _mm_set1_ps(float(double(INTERP_FILTER_LUT_SIZE) / double(INTERP_FILTER_SIZE))));
+    return sse41_lut_interp(sincLut.data(), t);
+}
+
+inline __m128 SincResamplerSSE41::window_func(__m128 t)
+{
+    t = sse41_abs(t);
+    t = _mm_mul_ps(t, _mm_set1_ps(float(double(INTERP_FILTER_LUT_SIZE) / double(INTERP_FILTER_SIZE))));
+    return sse41_lut_interp(winLut.data(), t);
+}
+
+BlepResamplerSSE41::~BlepResamplerSSE41()
+{
+}
+
+size_t BlepResamplerSSE41::Resample(std::span<float> buffer, float phaseInc, const float *src)
+{
+    const float sincStep = INTERP_FILTER_CUTOFF_FREQ / phaseInc;
+
+    if (polyphase != ResamplerPolyphase::OFF) {
+        polyphaseBank.Update(sincStep, polyphaseKernel);
+        return resamplePolyphase(buffer, phaseInc, src, sse41Dot, sse41Dot2);
+    }
+
+    const __m128 sincStepV = _mm_set1_ps(sincStep);
+    const __m128i sincWinSizeV = _mm_set1_epi32(INTERP_FILTER_SIZE);
+
+    int32_t fi = 0;
+    for (size_t i = 0; i < buffer.size(); i++) {
+        __m128 sampleSumV = _mm_setzero_ps();
+        __m128 kernelSumV = _mm_setzero_ps();
+        const __m128 phaseV = _mm_set1_ps(phase);
+        __m128i wiV = _mm_sub_epi32(_mm_set_epi32(4, 3, 2, 1), sincWinSizeV);
+
+        const float sl = BlepResampler::fast_Si((float(-INTERP_FILTER_SIZE + 1) - phase - 0.5f) * sincStep);
+        __m128 srPrevV = _mm_set_ps(sl, 0, 0, 0);
+
+        for (int wi = -INTERP_FILTER_SIZE + 1; wi <= INTERP_FILTER_SIZE;
+             wi += 4, wiV = _mm_add_epi32(wiV, _mm_set1_epi32(4))) {
+            const __m128 wiMPhaseV = _mm_sub_ps(_mm_cvtepi32_ps(wiV), phaseV);
+            const __m128 SiIndexRightV = _mm_mul_ps(_mm_add_ps(wiMPhaseV, _mm_set1_ps(0.5f)), sincStepV);
+            const __m128 srV = fast_Si(SiIndexRightV);
+            const __m128 slV = sse41_shift_up1(srPrevV, srV);
+            const __m128 kernelV = _mm_sub_ps(srV, slV);
+            const __m128 fetchedSampleV =
+                _mm_loadu_ps(&src[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1]);
+            sampleSumV = _mm_add_ps(sampleSumV, _mm_mul_ps(kernelV, fetchedSampleV));
+            kernelSumV = _mm_add_ps(kernelSumV, kernelV);
+            srPrevV = srV;
+        }
+
+        float kernelSum, sampleSum;
+        sse41_hsum2(kernelSumV, sampleSumV, kernelSum, sampleSum);
+
+        phase += phaseInc;
+        const int32_t istep = static_cast<int32_t>(phase);
+        phase -= static_cast<float>(istep);
+        fi += istep;
+
+        buffer[i] = sampleSum / kernelSum;
+    }
+
+    return static_cast<size_t>(fi);
+}
+
+inline __m128 BlepResamplerSSE41::fast_Si(__m128 t)
+{
+    const __m128 signed_t = t;
+    t = sse41_abs(t);
+    t = _mm_min_ps(t, _mm_set1_ps(float(INTERP_FILTER_SIZE)));
+    t = _mm_mul_ps(t, _mm_set1_ps(float(double(INTERP_FILTER_LUT_SIZE) / double(INTERP_FILTER_SIZE))));
+    return sse41_copysign(sse41_lut_interp(SiLut.data(), t), signed_t);
+}
+
+BlampResamplerSSE41::~BlampResamplerSSE41()
+{
+}
+
+size_t BlampResamplerSSE41::Resample(std::span<float> buffer, float phaseInc, const float *src)
+{
+    const float sincStep = INTERP_FILTER_CUTOFF_FREQ / phaseInc;
+
+    if (polyphase != ResamplerPolyphase::OFF) {
+        polyphaseBank.Update(sincStep, polyphaseKernel);
+        return resamplePolyphase(buffer, phaseInc, src, sse41Dot, sse41Dot2);
+    }
+
+    const __m128 sincStepV = _mm_set1_ps(sincStep);
+    const __m128i sincWinSizeV = _mm_set1_epi32(INTERP_FILTER_SIZE);
+
+    int32_t fi = 0;
+    for (size_t i = 0; i < buffer.size(); i++) {
+        __m128 sampleSumV = _mm_setzero_ps();
+        __m128 kernelSumV = _mm_setzero_ps();
+        const __m128 phaseV = _mm_set1_ps(phase);
+        __m128i wiV = _mm_sub_epi32(_mm_set_epi32(4, 3, 2, 1), sincWinSizeV);
+
+        const float sl = BlampResampler::fast_Ti((float(-INTERP_FILTER_SIZE + 1) - phase - 1.0f) * sincStep);
+        const float sm = BlampResampler::fast_Ti((float(-INTERP_FILTER_SIZE + 1) - phase) * sincStep);
+        __m128 srPrevV = _mm_set_ps(sm, sl, 0, 0);
+
+        for (int wi = -INTERP_FILTER_SIZE + 1; wi <= INTERP_FILTER_SIZE;
+             wi += 4, wiV = _mm_add_epi32(wiV, _mm_set1_epi32(4))) {
+            const __m128 wiMPhaseV = _mm_sub_ps(_mm_cvtepi32_ps(wiV), phaseV);
+            const __m128 TiIndexRightV = _mm_mul_ps(_mm_add_ps(wiMPhaseV, _mm_set1_ps(1.0f)), sincStepV);
+            const __m128 srV = fast_Ti(TiIndexRightV);
+            const __m128 smV = sse41_shift_up1(srPrevV, srV);
+            const __m128 slV = sse41_shift_up2(srPrevV, srV);
+            const __m128 kernelV = _mm_add_ps(_mm_sub_ps(_mm_sub_ps(srV, smV), smV), slV);
+            const __m128 fetchedSampleV =
+                _mm_loadu_ps(&src[static_cast<size_t>(fi + wi + INTERP_FILTER_SIZE) - 1]);
+            sampleSumV = _mm_add_ps(sampleSumV, _mm_mul_ps(kernelV, fetchedSampleV));
+            kernelSumV = _mm_add_ps(kernelSumV, kernelV);
+            srPrevV = srV;
+        }
+
+        float kernelSum, sampleSum;
+        sse41_hsum2(kernelSumV, sampleSumV, kernelSum, sampleSum);
+
+        phase += phaseInc;
+        const int32_t istep = static_cast<int32_t>(phase);
+        phase -= static_cast<float>(istep);
+        fi += istep;
+
+        buffer[i] = sampleSum / kernelSum;
+    }
+
+    return static_cast<size_t>(fi);
+}
+
+inline __m128 BlampResamplerSSE41::fast_Ti(__m128 t)
+{
+    t = sse41_abs(t);
+    const __m128 old_t = t;
+    t = _mm_min_ps(t, _mm_set1_ps(float(INTERP_FILTER_SIZE)));
+    t = _mm_mul_ps(t, _mm_set1_ps(float(double(INTERP_FILTER_LUT_SIZE) / double(INTERP_FILTER_SIZE))));
+    const __m128 retval = sse41_lut_interp(TiLut.data(), t);
+    const __m128 outOfRangeRetval = _mm_mul_ps(old_t, _mm_set1_ps(0.5f));
+    const __m128 isOutOfRange = _mm_cmpgt_ps(old_t, _mm_set1_ps(float(INTERP_FILTER_SIZE)));
+    return _mm_blendv_ps(retval, outOfRangeRetval, isOutOfRange);
+}
+
+#endif
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Resampler.hpp"
+
+#if __has_include(<smmintrin.h>)
+
+#include <smmintrin.h>
+
+class SincResamplerSSE41 : public SincResampler
+{
+public:
+    ~SincResamplerSSE41() override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
+
+private:
+    static __m128 fast_sincf(__m128 t);
+    static __m128 window_func(__m128 t);
+};
+
+class BlepResamplerSSE41 : public BlepResampler
+{
+public:
+    ~BlepResamplerSSE41() override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
+
+private:
+    static __m128 fast_Si(__m128 t);
+};
+
+class BlampResamplerSSE41 : public BlampResampler
+{
+public:
+    ~BlampResamplerSSE41() override;
+    size_t Resample(std::span<float> buffer, float phaseInc, const float *src) override;
+
+private:
+    static __m128 fast_Ti(__m128 t);
+};
+
+#else    // if SSE4.1 intrinsics header not available
+
+#include <stdexcept>
+
+class SincResamplerSSE41 : public SincResampler
+{
+public:
+    SincResamplerSSE41()
+    {
+        throw std::logic_error("Attempting to instantiate SincResamplerSSE41 on platform without SSE4.1");
+    }
+};
+
+class BlepResamplerSSE41 : public BlepResampler
+{
+public:
+    BlepResamplerSSE41()
+    {
+        throw std::logic_error("Attempting to instantiate BlepResamplerSSE41 on platform without SSE4.1");
+    }
+};
+
+class BlampResamplerSSE41 : public BlampResampler
+{
+public:
+    BlampResamplerSSE41()
+    {
+        throw std::logic_error("Attempting to instantiate BlampResamplerSSE41 on platform without SSE4.1");
+    }
+};
+
+#endif
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 
 /*
  * public ReverbEffect
@@ -26,11 +27,23 @@ ReverbEffect::~ReverbEffect()
 
 void ReverbEffect::Process(std::span<sample> buffer)
 {
+    const size_t numSamples = buffer.size();
+    float peak = 0.0f;
     while (buffer.size() > 0) {
         // TODO change the semantics of ProcessInternal to return 'processed' instead of 'left' samples
         const size_t left = ProcessInternal(buffer);
+        for (const sample &s : buffer.first(buffer.size() - left))
+            peak = std::max(peak, std::max(std::abs(s.left), std::abs(s.right)));
         buffer = buffer.subspan(buffer.size() - left);
     }
+
+    /* All state of the reverbs is derived from what they output during the last two passes through reverbBuffer.
+     * So once the output has been quiet for that long, the tail has decayed and the state can be cleared. */
+    silent = false;
+    if (peak >= SILENCE_THRESHOLD)
+        quietSamples = 0;
+    else if ((quietSamples += numSamples) >= 2 * reverbBuffer.size())
+        Reset();
 }
 
 void ReverbEffect::SetLevel(uint8_t level)
@@ -41,6 +54,18 @@ void ReverbEffect::SetLevel(uint8_t level)
 void ReverbEffect::Reset()
 {
     std::fill(reverbBuffer.begin(), reverbBuffer.end(), sample{0.0f, 0.0f});
+    quietSamples = 0;
+    silent = true;
+}
+
+std::unique_ptr<ReverbEffect> ReverbEffect::Clone() const
+{
+    return std::make_unique<ReverbEffect>(*this);
+}
+
+bool ReverbEffect::IsSilent() const
+{
+    return silent;
 }
 
 std::unique_ptr<ReverbEffect>
@@ -117,6 +142,11 @@ void ReverbGS1::Reset()
     std::fill(gsBuffer.begin(), gsBuffer.end(), sample{0.0f, 0.0f});
 }
 
+std::unique_ptr<ReverbEffect> ReverbGS1::Clone() const
+{
+    return std::make_unique<ReverbGS1>(*this);
+}
+
 size_t ReverbGS1::ProcessInternal(std::span<sample> buffer)
 {
     std::vector<sample> &rbuf = reverbBuffer;
@@ -180,6 +210,11 @@ void ReverbGS2::Reset()
     std::fill(gs2Buffer.begin(), gs2Buffer.end(), sample{0.0f, 0.0f});
 }
 
+std::unique_ptr<ReverbEffect> ReverbGS2::Clone() const
+{
+    return std::make_unique<ReverbGS2>(*this);
+}
+
 size_t ReverbGS2::ProcessInternal(std::span<sample> buffer)
 {
     std::vector<sample> &rbuf = reverbBuffer;
@@ -244,6 +279,11 @@ ReverbTest::~ReverbTest()
 {
 }
 
+std::unique_ptr<ReverbEffect> ReverbTest::Clone() const
+{
+    return std::make_unique<ReverbTest>(*this);
+}
+
 size_t ReverbTest::ProcessInternal(std::span<sample> buffer)
 {
     std::vector<sample> &rbuf = reverbBuffer;
@@ -18,6 +18,10 @@ public:
     void Process(std::span<sample> buffer);
     void SetLevel(uint8_t level);
     virtual void Reset();
+    /* copies the reverb including its buffers, e.g. for snapshots */
+    virtual std::unique_ptr<ReverbEffect> Clone() const;
+    /* True if the reverb tail has decayed completely, so processing silence would only return silence. */
+    bool IsSilent() const;
 
     static std::unique_ptr<ReverbEffect>
         MakeReverb(ReverbType reverbType, uint8_t intensity, size_t sampleRate, uint8_t numDmaBuffers);
@@ -29,6 +33,12 @@ protected:
     std::vector<sample> reverbBuffer;
     size_t bufferPos;
     size_t bufferPos2;
+
+private:
+    /* about -120 dB, tails below that are cut off */
+    static inline const float SILENCE_THRESHOLD = 1.0f / 1048576.0f;
+    size_t quietSamples = 0;
+    bool silent = true;
 };
 
 class ReverbGS1 : public ReverbEffect
@@ -37,6 +47,7 @@ public:
     ReverbGS1(uint8_t intensity, size_t streamRate, uint8_t numAgbBuffers);
     ~ReverbGS1() override;
     void Reset() override;
+    std::unique_ptr<ReverbEffect> Clone() const override;
 
 protected:
     size_t ProcessInternal(std::span<sample> buffer) override;
@@ -49,6 +60,7 @@ public:
     ReverbGS2(uint8_t intesity, size_t streamRate, uint8_t numAgbBuffers, float rPrimFac, float rSecFac);
     ~ReverbGS2() override;
     void Reset() override;
+    std::unique_ptr<ReverbEffect> Clone() const override;
 
 protected:
     size_t ProcessInternal(std::span<sample> buffer) override;
@@ -62,6 +74,7 @@ class ReverbTest : public ReverbEffect
 public:
     ReverbTest(uint8_t intesity, size_t streamRate, uint8_t numAgbBuffers);
     ~ReverbTest() override;
+    std::unique_ptr<ReverbEffect> Clone() const override;
 
 protected:
     size_t ProcessInternal(std::span<sample> buffer) override;
@@ -1,6 +1,7 @@
 #include "Rom.hpp"
 
 #include "Debug.hpp"
+#include "DecodedSampleCache.hpp"
 #include "FileReader.hpp"
 #include "Gsf.hpp"
 #include "Util.hpp"
@@ -21,6 +22,14 @@ std::unique_ptr<Rom> Rom::globalInstance;
  * public
  */
 
+Rom::Rom() : decodedSampleCache(std::make_unique<DecodedSampleCache>())
+{
+}
+
+Rom::Rom(Rom &&) = default;
+
+Rom::~Rom() = default;
+
 Rom Rom::LoadFromFile(const std::filesystem::path &filePath)
 {
     Rom rom;
@@ -3,6 +3,7 @@
 #include "AgbTypes.hpp"
 #include "Xcept.hpp"
 
+#include <cassert>
 #include <cstdint>
 #include <filesystem>
 #include <memory>
@@ -10,17 +11,54 @@
 #include <string>
 #include <vector>
 
+class DecodedSampleCache;
 class FileReader;
 
+/* RomSpan is a part of the ROM which has been verified to be within the ROM once.
+ * Reads from it are not checked anymore (except by assertions in debug builds).
+ * Use this instead of the Rom::Read functions if many reads occur within a known range. */
+class RomSpan
+{
+public:
+    explicit RomSpan(std::span<const uint8_t> data) : data(data) {}
+
+    int8_t ReadS8(size_t offset) const { return static_cast<int8_t>(ReadU8(offset)); }
+
+    uint8_t ReadU8(size_t offset) const
+    {
+        assert(offset < data.size());
+        return data[offset];
+    }
+
+    uint16_t ReadU16(size_t offset) const
+    {
+        assert(offset + 1 < data.size());
+        return static_cast<uint16_t>(data[offset] | (data[offset + 1] << 8));
+    }
+
+    uint32_t ReadU32(size_t offset) const
+    {
+        assert(offset + 3 < data.size());
+        return static_cast<uint32_t>(data[offset + 0]) | (static_cast<uint32_t>(data[offset + 1]) << 8)
+            | (static_cast<uint32_t>(data[offset + 2]) << 16) | (static_cast<uint32_t>(data[offset + 3]) << 24);
+    }
+
+    size_t Size() const { return data.size(); }
+
+private:
+    std::span<const uint8_t> data;
+};
+
 class Rom
 {
 private:
-    Rom() = default;
+    Rom();
 
 public:
-    Rom(Rom &&) = default;
+    Rom(Rom &&);
     Rom(const Rom &) = delete;
     Rom &operator=(const Rom &) = delete;
+    ~Rom();
 
     static Rom LoadFromFile(const std::filesystem::path &filePath);
     static Rom LoadFromBufferCopy(std::span<uint8_t> buffer);    // buffer may be freed afterwards
@@ -75,6 +113,15 @@ public:
 
     const void *GetPtr(size_t pos) const { return &romData[pos]; }
 
+    RomSpan GetSpan(size_t pos, size_t len) const
+    {
+        if (pos > romData.size() || len > romData.size() - pos) [[unlikely]]
+            throw Xcept(
+                "ERROR: Cannot read beyond end of ROM (size={:#x}): {:#x}, length={:#x}", romData.size(), pos, len
+            );
+        return RomSpan(romData.subspan(pos, len));
+    }
+
     size_t Size() const { return romData.size(); }
 
     bool ValidPointer(uint32_t ptr) const
@@ -98,6 +145,9 @@ public:
 
     bool IsGsf() const;
 
+    /* decoded compressed samples, shared by everything that renders from this ROM */
+    DecodedSampleCache &GetDecodedSampleCache() const { return *decodedSampleCache; }
+
 private:
     void Verify();
     void LoadFile(const std::filesystem::path &filePath);
@@ -112,6 +162,7 @@ private:
     std::filesystem::path gsfPath;
 
     bool isGsf = false;
+    std::unique_ptr<DecodedSampleCache> decodedSampleCache;
 
     static std::unique_ptr<Rom> globalInstance;
 };
@@ -0,0 +1,252 @@
+#include "SegmentedRenderer.hpp"
+
+#include "MP2KContext.hpp"
+#include "OS.hpp"
+#include "Rom.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/*
+ * public SegmentedRenderer
+ */
+
+SegmentedRenderer::SegmentedRenderer(
+    uint32_t sampleRate,
+    const Rom &rom,
+    const MP2KSoundMode &mp2kSoundMode,
+    const AgbplaySoundMode &agbplaySoundMode,
+    const SongTableInfo &songTableInfo,
+    const PlayerTableInfo &playerTableInfo
+) :
+    sampleRate(sampleRate),
+    rom(rom),
+    mp2kSoundMode(mp2kSoundMode),
+    agbplaySoundMode(agbplaySoundMode),
+    songTableInfo(songTableInfo),
+    playerTableInfo(playerTableInfo)
+{
+}
+
+uint8_t SegmentedRenderer::TracksUsed(uint16_t songId) const
+{
+    /* read from the song header like m4aSongNumStart and MP2KPlayer::Init do, without setting up a whole context */
+    if (songId >= songTableInfo.count)
+        return 0;
+    const size_t tablePos = songTableInfo.pos + songId * 8;
+    if (rom.ReadU32(tablePos) == 0)
+        return 0;
+    const size_t songPos = rom.ReadAgbPtrToPos(tablePos);
+    const uint8_t playerIdx = rom.ReadU8(tablePos + 4);
+    if (playerIdx >= playerTableInfo.size())
+        return 0;
+    return std::min(rom.ReadU8(songPos + 0), playerTableInfo.at(playerIdx).maxTracks);
+}
+
+size_t SegmentedRenderer::Render(
+    uint16_t songId,
+    bool separateTracks,
+    size_t numThreads,
+    size_t segmentSubframes,
+    const std::function<void(const Streams &)> &streamFunc
+)
+{
+    assert(numThreads > 0 && segmentSubframes > 0);
+
+    auto makeContext = [this]() {
+        return std::make_unique<MP2KContext>(
+            sampleRate, rom, mp2kSoundMode, agbplaySoundMode, songTableInfo, playerTableInfo
+        );
+    };
+
+    auto skipCtx = makeContext();
+    skipCtx->m4aSongNumStart(songId);
+    const uint8_t playerIdx = skipCtx->m4aSongNumPlayerGet(songId);
+    const size_t numStreams = separateTracks ? TracksUsed(songId) : 1;
+    const size_t segmentSamples = segmentSubframes * skipCtx->mixer.GetSamplesPerBuffer();
+    const size_t maxAhead =
+        std::clamp<size_t>(MAX_BUFFERED_SAMPLES / std::max<size_t>(1, numStreams * segmentSamples), 1, numThreads);
+
+    /* segment k starts at k * segmentSubframes, its snapshot is taken warmup(k) before that */
+    auto warmup = [segmentSubframes](size_t k) { return std::min(WARMUP_SUBFRAMES, k * segmentSubframes); };
+
+    struct Segment
+    {
+        Streams streams;
+        size_t samples = 0;
+        bool ended = false;
+    };
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::shared_ptr<const MP2KSnapshot>> snapshots;
+    bool skipDone = false;
+    std::map<size_t, Segment> segments;
+    size_t nextSegment = 0;
+    size_t nextOutput = 0;
+    // also read without the mutex to stop rendering early
+    std::atomic<bool> quit = false;
+    std::exception_ptr error;
+
+    auto fail = [&](std::exception_ptr e) {
+        std::unique_lock lock(mutex);
+        if (!error)
+            error = e;
+        quit = true;
+        cv.notify_all();
+    };
+
+    auto skipFunc = [&]() {
+        OS::LowerThreadPriority();
+        try {
+            size_t subframe = 0;
+            for (size_t k = 0;; k++) {
+                const size_t start = k * segmentSubframes - warmup(k);
+                bool ended = false;
+                while (subframe < start && !ended && !quit) {
+                    skipCtx->m4aSoundMainSkip();
+                    subframe++;
+                    ended = skipCtx->SongEnded();
+                }
+
+                std::shared_ptr<MP2KSnapshot> snapshot;
+                if (!ended) {
+                    snapshot = std::make_shared<MP2KSnapshot>();
+                    skipCtx->SaveSnapshot(*snapshot);
+                    snapshot->DropSkippedEffects();
+                }
+
+                std::unique_lock lock(mutex);
+                if (snapshot)
+                    snapshots.emplace_back(std::move(snapshot));
+                else
+                    skipDone = true;
+                cv.notify_all();
+                if (skipDone)
+                    return;
+                // don't run ahead too far, e.g. for songs which loop endlessly
+                cv.wait(lock, [&]() { return quit || snapshots.size() < nextSegment + numThreads; });
+                if (quit)
+                    return;
+            }
+        } catch (...) {
+            fail(std::current_exception());
+        }
+    };
+
+    auto workerFunc = [&]() {
+        OS::LowerThreadPriority();
+        try {
+            auto ctx = makeContext();
+            while (true) {
+                size_t k;
+                std::shared_ptr<const MP2KSnapshot> snapshot;
+                {
+                    std::unique_lock lock(mutex);
+                    cv.wait(lock, [&]() {
+                        return quit
+                            || (nextSegment < nextOutput + maxAhead && (nextSegment < snapshots.size() || skipDone));
+                    });
+                    if (quit || nextSegment >= snapshots.size())
+                        return;
+                    k = nextSegment++;
+                    snapshot = std::move(snapshots.at(k));
+                }
+
+                ctx->RestoreSnapshot(*snapshot);
+                snapshot.reset();
+
+                Segment segment;
+                segment.streams.resize(numStreams);
+                for (std::vector<sample> &stream : segment.streams)
+                    stream.reserve(segmentSamples);
+                const size_t warmupEnd = warmup(k);
+                const size_t segmentEnd = warmupEnd + segmentSubframes;
+                size_t pos = 0;
+                while (pos < segmentEnd && !segment.ended && !quit) {
+                    // blocks don't reach across the end of the warm-up, so it can be discarded as a whole
+                    const size_t blockEnd = pos < warmupEnd ? warmupEnd : segmentEnd;
+                    const size_t maxSubframes = std::min(BLOCK_SUBFRAMES, blockEnd - pos);
+                    const size_t subframes = ctx->m4aSoundMainBlock(maxSubframes);
+                    segment.ended = subframes < maxSubframes;
+                    if (pos >= warmupEnd) {
+                        for (size_t i = 0; i < numStreams; i++) {
+                            const std::vector<sample> &buffer =
+                                separateTracks ? ctx->players.at(playerIdx).tracks.at(i).audioBuffer
+                                               : ctx->masterAudioBuffer;
+                            segment.streams[i].insert(segment.streams[i].end(), buffer.begin(), buffer.end());
+                        }
+                        segment.samples += ctx->masterAudioBuffer.size();
+                    } else if (segment.ended) {
+                        // the song ended during the warm-up, i.e. right at the end of the previous segment
+                        break;
+                    }
+                    pos += subframes;
+                }
+
+                std::unique_lock lock(mutex);
+                segments.emplace(k, std::move(segment));
+                cv.notify_all();
+            }
+        } catch (...) {
+            fail(std::current_exception());
+        }
+    };
+
+    std::thread skipThread(skipFunc);
+#ifdef __linux__
+    pthread_setname_np(skipThread.native_handle(), "segment skip");
+#endif
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < numThreads; i++) {
+        workers.emplace_back(workerFunc);
+#ifdef __linux__
+        pthread_setname_np(workers.back().native_handle(), "segment render");
+#endif
+    }
+
+    /* pass on the segments in order */
+    size_t samplesRendered = 0;
+    try {
+        for (size_t k = 0;; k++) {
+            Segment segment;
+            {
+                std::unique_lock lock(mutex);
+                cv.wait(lock, [&]() { return quit || segments.contains(k) || (skipDone && k >= snapshots.size()); });
+                if (quit || !segments.contains(k))
+                    break;
+                segment = std::move(segments.at(k));
+                segments.erase(k);
+                nextOutput = k + 1;
+                cv.notify_all();
+            }
+
+            streamFunc(segment.streams);
+            samplesRendered += segment.samples;
+            if (segment.ended)
+                break;
+        }
+    } catch (...) {
+        fail(std::current_exception());
+    }
+
+    {
+        std::unique_lock lock(mutex);
+        quit = true;
+        cv.notify_all();
+    }
+    skipThread.join();
+    for (std::thread &w : workers)
+        w.join();
+
+    if (error)
+        std::rethrow_exception(error);
+    return samplesRendered;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Constants.hpp"
+#include "Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class Rom;
+
+/* SegmentedRenderer renders a single song on multiple threads, by splitting it up into segments along the timeline.
+ *
+ * A skip pass (MP2KContext::m4aSoundMainSkip) runs through the song and takes a snapshot (see MP2KSnapshot) shortly
+ * before each segment. Each segment is then rendered on its own context, continuing from its snapshot, and the
+ * segments are passed on in order. Segments start at subframe boundaries, so the stitched output has exactly the
+ * same length and timing as rendering the song in one go.
+ *
+ * The skip pass leaves the channels exactly where rendering would have left them, but it does not feed the reverbs
+ * (except in native mix rate mode). Each segment therefore starts to render WARMUP_SUBFRAMES early, which fills the
+ * reverbs again, and discards that part of the output. The reverb tails at the start of a segment may still differ
+ * slightly from rendering in one go. */
+
+class SegmentedRenderer
+{
+public:
+    SegmentedRenderer(
+        uint32_t sampleRate,
+        const Rom &rom,
+        const MP2KSoundMode &mp2kSoundMode,
+        const AgbplaySoundMode &agbplaySoundMode,
+        const SongTableInfo &songTableInfo,
+        const PlayerTableInfo &playerTableInfo
+    );
+    SegmentedRenderer(const SegmentedRenderer &) = delete;
+    SegmentedRenderer &operator=(const SegmentedRenderer &) = delete;
+
+    /* output of one segment: the master output, or with separateTracks one stream per used track of the player */
+    using Streams = std::vector<std::vector<sample>>;
+
+    /* number of tracks the song uses, i.e. the number of streams with separateTracks */
+    uint8_t TracksUsed(uint16_t songId) const;
+    /* Renders the song on numThreads threads until it ends and calls streamFunc for each segment, in order and from
+     * the calling thread. Returns the number of samples rendered. */
+    size_t Render(
+        uint16_t songId,
+        bool separateTracks,
+        size_t numThreads,
+        size_t segmentSubframes,
+        const std::function<void(const Streams &)> &streamFunc
+    );
+
+    static inline const size_t SEGMENT_SUBFRAMES = 10 * AGB_FPS * INTERFRAMES;
+    static inline const size_t WARMUP_SUBFRAMES = 2 * AGB_FPS * INTERFRAMES;
+    /* Segments which are finished, but not passed on yet, are kept in memory. Fewer segments are rendered ahead
+     * if they would take up more than this many samples, e.g. when separate tracks are rendered. */
+    static inline const size_t MAX_BUFFERED_SAMPLES = 32 * 1024 * 1024;
+
+private:
+    static inline const size_t BLOCK_SUBFRAMES = 16;
+
+    const uint32_t sampleRate;
+    const Rom &rom;
+    const MP2KSoundMode mp2kSoundMode;
+    const AgbplaySoundMode agbplaySoundMode;
+    const SongTableInfo songTableInfo;
+    const PlayerTableInfo playerTableInfo;
+};
@@ -0,0 +1,59 @@
+#include "SequenceEventCache.hpp"
+
+#include <cassert>
+
+/*
+ * public SequenceEventCache
+ */
+
+uint32_t SequenceEventCache::FindEvent(size_t pos, uint8_t lastCmd) const
+{
+    const auto it = eventIndex.find(makeKey(pos, lastCmd));
+    if (it == eventIndex.end())
+        return SequenceEvent::NONE;
+    return it->second;
+}
+
+uint32_t SequenceEventCache::AddEvent(size_t pos, uint8_t lastCmd, const SequenceEvent &event)
+{
+    assert(events.size() < SequenceEvent::NONE);
+    const uint32_t eventIdx = static_cast<uint32_t>(events.size());
+    events.emplace_back(event);
+    eventIndex.emplace(makeKey(pos, lastCmd), eventIdx);
+    return eventIdx;
+}
+
+const InstrumentMapping *SequenceEventCache::FindMapping(size_t progPos, uint8_t key) const
+{
+    const auto it = mappings.find(makeKey(progPos, key));
+    if (it == mappings.end())
+        return nullptr;
+    return &it->second;
+}
+
+void SequenceEventCache::AddMapping(size_t progPos, uint8_t key, const InstrumentMapping &mapping)
+{
+    mappings.emplace(makeKey(progPos, key), mapping);
+}
+
+const InstrumentInfo *SequenceEventCache::FindInstrument(size_t instrPos) const
+{
+    const auto it = instruments.find(instrPos);
+    if (it == instruments.end())
+        return nullptr;
+    return &it->second;
+}
+
+void SequenceEventCache::AddInstrument(size_t instrPos, const InstrumentInfo &instrument)
+{
+    instruments.emplace(instrPos, instrument);
+}
+
+/*
+ * private SequenceEventCache
+ */
+
+uint64_t SequenceEventCache::makeKey(size_t pos, uint8_t byte)
+{
+    return (static_cast<uint64_t>(pos) << 8) | byte;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/* A SequenceEvent is a single, already decoded track command.
+ * Running status, argument parsing, delay lookup and pointer resolution are
+ * done once when the event is compiled, so playback does not have to parse ROM data again. */
+struct SequenceEvent
+{
+    enum class Type : uint8_t {
+        DELAY,        // value = delay in ticks
+        NOTE,         // value = note length, args = key, velocity, additional length
+        PARAM,        // one argument track/player commands like VOL, PAN, BEND, TEMPO, ...
+        GOTO,         // nextPos = jump target
+        EOT,          // args = key
+        INTERPRET,    // everything else is left to the regular SequenceReader code
+    };
+
+    static inline const uint32_t NONE = UINT32_MAX;
+
+    size_t pos = 0;        // ROM position of the event
+    size_t nextPos = 0;    // ROM position of the following event
+    uint32_t next = NONE;  // index of the following event, resolved on first use
+    Type type = Type::INTERPRET;
+    uint8_t cmd = 0;        // command after resolving running status
+    uint8_t lastCmd = 0;    // running status after this event
+    uint8_t value = 0;
+    uint8_t numArgs = 0;
+    uint8_t args[3] = {0, 0, 0};
+};
+
+/* instrument after resolving key split and rhythm instruments */
+struct InstrumentMapping
+{
+    size_t instrPos;
+    uint8_t midiKeyPitch;
+    int8_t rhythmPan;
+};
+
+/* everything that is required from an instrument to start a channel */
+struct InstrumentInfo
+{
+    uint8_t type;
+    ADSR adsr;
+    uint8_t sweep;
+    uint32_t dutyWaveNp;
+    SampleInfo sampleInfo;
+};
+
+/* SequenceEventCache stores compiled events and resolved instruments for a SequenceReader.
+ * Everything is indexed by ROM position, so the cache stays valid across songs of the same ROM.
+ * Compiling the events is done by SequenceReader. */
+class SequenceEventCache
+{
+public:
+    SequenceEventCache() = default;
+    SequenceEventCache(const SequenceEventCache &) = delete;
+    SequenceEventCache &operator=(const SequenceEventCache &) = delete;
+
+    uint32_t FindEvent(size_t pos, uint8_t lastCmd) const;
+    uint32_t AddEvent(size_t pos, uint8_t lastCmd, const SequenceEvent &event);
+    SequenceEvent &GetEvent(uint32_t eventIdx) { return events[eventIdx]; }
+    size_t NumEvents() const { return events.size(); }
+
+    const InstrumentMapping *FindMapping(size_t progPos, uint8_t key) const;
+    void AddMapping(size_t progPos, uint8_t key, const InstrumentMapping &mapping);
+    const InstrumentInfo *FindInstrument(size_t instrPos) const;
+    void AddInstrument(size_t instrPos, const InstrumentInfo &instrument);
+
+private:
+    static uint64_t makeKey(size_t pos, uint8_t byte);
+
+    std::vector<SequenceEvent> events;
+    std::unordered_map<uint64_t, uint32_t> eventIndex;
+    std::unordered_map<uint64_t, InstrumentMapping> mappings;
+    std::unordered_map<size_t, InstrumentInfo> instruments;
+};
@@ -6,8 +6,10 @@
 #include "Util.hpp"
 #include "Xcept.hpp"
 
+#include <array>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 
 #define NOTE_TIE     -1
 #define NOTE_ALL     0xFE
@@ -17,23 +19,26 @@
  * SequenceReader data
  */
 
-const std::map<uint8_t, uint8_t> SequenceReader::delayLut = {
-    {0x80, 0},  {0x81, 1},  {0x82, 2},  {0x83, 3},  {0x84, 4},  {0x85, 5},  {0x86, 6},  {0x87, 7},  {0x88, 8},
-    {0x89, 9},  {0x8A, 10}, {0x8B, 11}, {0x8C, 12}, {0x8D, 13}, {0x8E, 14}, {0x8F, 15}, {0x90, 16}, {0x91, 17},
-    {0x92, 18}, {0x93, 19}, {0x94, 20}, {0x95, 21}, {0x96, 22}, {0x97, 23}, {0x98, 24}, {0x99, 28}, {0x9A, 30},
-    {0x9B, 32}, {0x9C, 36}, {0x9D, 40}, {0x9E, 42}, {0x9F, 44}, {0xA0, 48}, {0xA1, 52}, {0xA2, 54}, {0xA3, 56},
-    {0xA4, 60}, {0xA5, 64}, {0xA6, 66}, {0xA7, 68}, {0xA8, 72}, {0xA9, 76}, {0xAA, 78}, {0xAB, 80}, {0xAC, 84},
-    {0xAD, 88}, {0xAE, 90}, {0xAF, 92}, {0xB0, 96}
-};
-
-const std::map<uint8_t, uint8_t> SequenceReader::noteLut = {
-    {0xCF, 0},  {0xD0, 1},  {0xD1, 2},  {0xD2, 3},  {0xD3, 4},  {0xD4, 5},  {0xD5, 6},  {0xD6, 7},  {0xD7, 8},
-    {0xD8, 9},  {0xD9, 10}, {0xDA, 11}, {0xDB, 12}, {0xDC, 13}, {0xDD, 14}, {0xDE, 15}, {0xDF, 16}, {0xE0, 17},
-    {0xE1, 18}, {0xE2, 19}, {0xE3, 20}, {0xE4, 21}, {0xE5, 22}, {0xE6, 23}, {0xE7, 24}, {0xE8, 28}, {0xE9, 30},
-    {0xEA, 32}, {0xEB, 36}, {0xEC, 40}, {0xED, 42}, {0xEE, 44}, {0xEF, 48}, {0xF0, 52}, {0xF1, 54}, {0xF2, 56},
-    {0xF3, 60}, {0xF4, 64}, {0xF5, 66}, {0xF6, 68}, {0xF7, 72}, {0xF8, 76}, {0xF9, 78}, {0xFA, 80}, {0xFB, 84},
-    {0xFC, 88}, {0xFD, 90}, {0xFE, 92}, {0xFF, 96}
-};
+/* Both tables are indexed by the command byte directly. Only delay commands (0x80-0xB0) and
+ * note commands (0xCF-0xFF) have valid entries. */
+static constexpr std::array<uint8_t, 256> makeLengthLut(uint8_t firstCmd)
+{
+    constexpr std::array<uint8_t, 49> lengths = {
+        0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+        28, 30, 32, 36, 40, 42, 44, 48, 52, 54, 56, 60, 64, 66, 68, 72, 76, 78, 80, 84, 88, 90, 92, 96,
+    };
+
+    std::array<uint8_t, 256> lut{};
+    for (size_t i = 0; i < lengths.size(); i++)
+        lut[firstCmd + i] = lengths[i];
+    return lut;
+}
+
+static constexpr std::array<uint8_t, 256> delayLut = makeLengthLut(0x80);
+static constexpr std::array<uint8_t, 256> noteLut = makeLengthLut(0xCF);
+
+static_assert(delayLut[0x98] == 24 && delayLut[0xB0] == 96);
+static_assert(noteLut[0xCF] == 0 && noteLut[0xE7] == 24 && noteLut[0xFF] == 96);
 
 /*
  * public SequenceReader
@@ -49,21 +54,35 @@ void SequenceReader::Process()
     for (MP2KPlayer &player : ctx.players)
         playing |= PlayerMain(player);
 
-    if (!playing && !endReached) {
+    if (!playing && !state.endReached) {
         ctx.mixer.StartFadeOut(SONG_FINISH_TIME);
-        endReached = true;
+        state.endReached = true;
     }
 }
 
 bool SequenceReader::EndReached() const
 {
-    return endReached;
+    return state.endReached;
+}
+
+uint8_t SequenceReader::GetNumLoops() const
+{
+    return state.numLoops;
 }
 
 void SequenceReader::Restart()
 {
-    numLoops = 0;
-    endReached = false;
+    state = State{};
+}
+
+SequenceReader::State SequenceReader::GetState() const
+{
+    return state;
+}
+
+void SequenceReader::SetState(const State &state)
+{
+    this->state = state;
 }
 
 void SequenceReader::SetSpeedFactor(float speedFactor)
@@ -76,6 +95,19 @@ float SequenceReader::GetSpeedFactor() const
     return speedFactor;
 }
 
+void SequenceReader::SetEventCacheEnabled(bool enabled)
+{
+    if (!enabled)
+        eventCache.reset();
+    else if (!eventCache)
+        eventCache = std::make_unique<SequenceEventCache>();
+}
+
+bool SequenceReader::IsEventCacheEnabled() const
+{
+    return eventCache != nullptr;
+}
+
 /*
  * private SequenceReader
  */
@@ -112,8 +144,6 @@ bool SequenceReader::PlayerMain(MP2KPlayer &player)
 
 bool SequenceReader::TrackMain(MP2KPlayer &player, MP2KTrack &trk)
 {
-    const Rom &rom = ctx.rom;
-
     if (!trk.enabled)
         return false;
 
@@ -122,35 +152,9 @@ bool SequenceReader::TrackMain(MP2KPlayer &player, MP2KTrack &trk)
 
     /* Count down track delay and process events if necessary. */
     while (trk.delay == 0) {
-        uint8_t cmd = rom.ReadU8(trk.pos);
-
-        // check if a previous command should be repeated
-        if (cmd < 0x80) {
-            cmd = trk.lastCmd;
-            if (cmd < 0x80) {
-                // song data error, command not initialized
-                cmdPlayFine(trk);
-                return false;
-            }
-        } else {
-            trk.pos++;
-            if (cmd >= 0xBD) {
-                // repeatable command
-                trk.lastCmd = cmd;
-            }
-        }
-
-        if (cmd >= 0xCF) {
-            // note command
-            cmdPlayNote(player, trk, cmd);
-        } else if (cmd >= 0xB1) {
-            // state altering command
-            cmdPlayCommand(player, trk, cmd);
-            if (!trk.enabled)
-                return false;
-        } else {
-            trk.delay = delayLut.at(cmd);
-        }
+        const bool enabled = eventCache ? CachedEventMain(player, trk) : EventMain(player, trk);
+        if (!enabled)
+            return false;
     }
 
     trk.delay--;
@@ -181,6 +185,187 @@ bool SequenceReader::TrackMain(MP2KPlayer &player, MP2KTrack &trk)
     return true;
 }
 
+bool SequenceReader::EventMain(MP2KPlayer &player, MP2KTrack &trk)
+{
+    const Rom &rom = ctx.rom;
+
+    /* The position is modified below, so the track has to look up its cached event again. */
+    trk.eventIdx = SequenceEvent::NONE;
+
+    uint8_t cmd = rom.ReadU8(trk.pos);
+
+    // check if a previous command should be repeated
+    if (cmd < 0x80) {
+        cmd = trk.lastCmd;
+        if (cmd < 0x80) {
+            // song data error, command not initialized
+            cmdPlayFine(trk);
+            return false;
+        }
+    } else {
+        trk.pos++;
+        if (cmd >= 0xBD) {
+            // repeatable command
+            trk.lastCmd = cmd;
+        }
+    }
+
+    if (cmd >= 0xCF) {
+        // note command
+        cmdPlayNote(player, trk, cmd);
+    } else if (cmd >= 0xB1) {
+        // state altering command
+        cmdPlayCommand(player, trk, cmd);
+        if (!trk.enabled)
+            return false;
+    } else {
+        trk.delay = delayLut[cmd];
+    }
+
+    return true;
+}
+
+bool SequenceReader::CachedEventMain(MP2KPlayer &player, MP2KTrack &trk)
+{
+    if (trk.eventIdx == SequenceEvent::NONE)
+        trk.eventIdx = LookupEvent(trk.pos, trk.lastCmd);
+
+    const SequenceEvent &ev = eventCache->GetEvent(trk.eventIdx);
+
+    switch (ev.type) {
+    case SequenceEvent::Type::DELAY:
+        trk.delay = ev.value;
+        break;
+    case SequenceEvent::Type::NOTE:
+        trk.lastNoteLen = ev.value;
+        if (ev.numArgs >= 1)
+            trk.lastNoteKey = ev.args[0];
+        if (ev.numArgs >= 2)
+            trk.lastNoteVel = ev.args[1];
+        if (ev.numArgs >= 3)
+            trk.lastNoteLen = static_cast<uint8_t>(trk.lastNoteLen + ev.args[2]);
+        PlayNote(player, trk);
+        break;
+    case SequenceEvent::Type::PARAM:
+        cmdPlayParam(player, trk, ev.cmd, ev.args[0]);
+        break;
+    case SequenceEvent::Type::GOTO:
+        cmdPlayGoto(trk);
+        break;
+    case SequenceEvent::Type::EOT:
+        if (ev.numArgs >= 1)
+            trk.lastNoteKey = ev.args[0];
+        cmdPlayEot(trk, trk.lastNoteKey);
+        break;
+    case SequenceEvent::Type::INTERPRET:
+        /* Commands which don't compile to an event are executed from ROM. */
+        trk.pos = ev.pos;
+        return EventMain(player, trk);
+    }
+
+    const uint32_t eventIdx = trk.eventIdx;
+    trk.pos = ev.nextPos;
+    trk.lastCmd = ev.lastCmd;
+    trk.eventIdx = ev.next;
+    if (trk.eventIdx == SequenceEvent::NONE) {
+        trk.eventIdx = LookupEvent(trk.pos, trk.lastCmd);
+        eventCache->GetEvent(eventIdx).next = trk.eventIdx;
+    }
+    return true;
+}
+
+uint32_t SequenceReader::LookupEvent(size_t pos, uint8_t lastCmd)
+{
+    assert(eventCache);
+
+    if (const uint32_t eventIdx = eventCache->FindEvent(pos, lastCmd); eventIdx != SequenceEvent::NONE)
+        return eventIdx;
+
+    /* Compile all following events until either an already compiled event or an event
+     * which has to be interpreted is reached. This keeps consecutive events next to each other
+     * in memory and links them, so playback usually does not have to search the cache. */
+    const uint32_t firstIdx = static_cast<uint32_t>(eventCache->NumEvents());
+    uint32_t prevIdx = SequenceEvent::NONE;
+
+    while (true) {
+        uint32_t eventIdx = eventCache->FindEvent(pos, lastCmd);
+        const bool compiled = eventIdx != SequenceEvent::NONE;
+        if (!compiled)
+            eventIdx = eventCache->AddEvent(pos, lastCmd, CompileEvent(pos, lastCmd));
+        if (prevIdx != SequenceEvent::NONE)
+            eventCache->GetEvent(prevIdx).next = eventIdx;
+        if (compiled)
+            break;
+
+        const SequenceEvent &ev = eventCache->GetEvent(eventIdx);
+        if (ev.type == SequenceEvent::Type::INTERPRET)
+            break;
+
+        pos = ev.nextPos;
+        lastCmd = ev.lastCmd;
+        prevIdx = eventIdx;
+    }
+
+    return firstIdx;
+}
+
+SequenceEvent SequenceReader::CompileEvent(size_t pos, uint8_t lastCmd) const
+{
+    const Rom &rom = ctx.rom;
+
+    SequenceEvent ev;
+    ev.pos = pos;
+    ev.lastCmd = lastCmd;
+    size_t nextPos = pos;
+
+    /* Reading beyond the end of the ROM or invalid pointers throw. Such events are left
+     * to the interpreter, so the error occurs at the same time as without event cache. */
+    try {
+        uint8_t cmd = rom.ReadU8(nextPos);
+        if (cmd < 0x80) {
+            cmd = lastCmd;
+            if (cmd < 0x80)
+                return ev;
+        } else {
+            nextPos++;
+            if (cmd >= 0xBD)
+                ev.lastCmd = cmd;
+        }
+        ev.cmd = cmd;
+
+        if (cmd >= 0xCF) {
+            ev.type = SequenceEvent::Type::NOTE;
+            ev.value = noteLut[cmd];
+            while (ev.numArgs < 3 && rom.ReadU8(nextPos) < 0x80)
+                ev.args[ev.numArgs++] = rom.ReadU8(nextPos++);
+        } else if (cmd == 0xB2) {
+            ev.type = SequenceEvent::Type::GOTO;
+            nextPos = rom.ReadAgbPtrToPos(nextPos);
+        } else if (cmd == 0xCE) {
+            ev.type = SequenceEvent::Type::EOT;
+            if (rom.ReadU8(nextPos) < 0x80)
+                ev.args[ev.numArgs++] = rom.ReadU8(nextPos++);
+        } else if ((cmd >= 0xBA && cmd <= 0xC5) || cmd == 0xC8) {
+            ev.type = SequenceEvent::Type::PARAM;
+            ev.args[ev.numArgs++] = rom.ReadU8(nextPos++);
+        } else if (cmd >= 0xB1) {
+            ev.lastCmd = lastCmd;
+            return ev;
+        } else {
+            ev.type = SequenceEvent::Type::DELAY;
+            ev.value = delayLut[cmd];
+        }
+    } catch (const std::exception &) {
+        ev = SequenceEvent{};
+        ev.pos = pos;
+        ev.lastCmd = lastCmd;
+        return ev;
+    }
+
+    ev.nextPos = nextPos;
+    return ev;
+}
+
 void SequenceReader::TrackVolPitchMain(MP2KTrack &trk)
 {
     if (!trk.enabled)
@@ -251,7 +436,7 @@ void SequenceReader::cmdPlayNote(MP2KPlayer &player, MP2KTrack &trk, uint8_t cmd
 {
     const Rom &rom = ctx.rom;
 
-    trk.lastNoteLen = noteLut.at(cmd);
+    trk.lastNoteLen = noteLut[cmd];
 
     // parse command from track data
     if (rom.ReadU8(trk.pos) < 0x80) {
@@ -266,36 +451,19 @@ void SequenceReader::cmdPlayNote(MP2KPlayer &player, MP2KTrack &trk, uint8_t cmd
         }
     }
 
+    PlayNote(player, trk);
+}
+
+void SequenceReader::PlayNote(MP2KPlayer &player, MP2KTrack &trk)
+{
     // don't play invalid instruments
     if (trk.prog > 127)
         return;
 
     // find instrument definition
-    uint8_t midiKeyPitch;
-    int8_t rhythmPan = 0;
-    size_t instrPos = player.bankPos + trk.prog * 12;
-    if (const uint8_t bankDataType = rom.ReadU8(instrPos + 0x0); bankDataType & BANKDATA_TYPE_SPLIT) {
-        const size_t subBankPos = rom.ReadAgbPtrToPos(instrPos + 0x4);
-        const size_t subKeyMap = rom.ReadAgbPtrToPos(instrPos + 0x8);
-        instrPos = subBankPos + rom.ReadU8(subKeyMap + trk.lastNoteKey) * 12;
-        if (rom.ReadU8(instrPos + 0x0) & (BANKDATA_TYPE_SPLIT | BANKDATA_TYPE_RHYTHM)) {
-            Debug::print("cmdPlayNote: attempting to play recursive key split");
-            return;
-        }
-        midiKeyPitch = trk.lastNoteKey;
-    } else if (bankDataType == BANKDATA_TYPE_RHYTHM) {
-        const size_t subBankPos = rom.ReadAgbPtrToPos(instrPos + 0x4);
-        instrPos = subBankPos + trk.lastNoteKey * 12;
-        if (rom.ReadU8(instrPos + 0x0) & (BANKDATA_TYPE_SPLIT | BANKDATA_TYPE_RHYTHM)) {
-            Debug::print("cmdPlayNote: attempting to play recursive rhythm part");
-            return;
-        }
-        if (const uint8_t instrPan = rom.ReadU8(instrPos + 0x3); instrPan & 0x80)
-            rhythmPan = static_cast<int8_t>((instrPan - 0xC0) * 2);
-        midiKeyPitch = rom.ReadU8(instrPos + 0x1);
-    } else {
-        midiKeyPitch = trk.lastNoteKey;
-    }
+    InstrumentMapping mapping;
+    if (!GetInstrumentMapping(player.bankPos + trk.prog * 12, trk.lastNoteKey, mapping))
+        return;
 
     // init LFO
     trk.lfodlCount = trk.lfodl;
@@ -306,20 +474,18 @@ void SequenceReader::cmdPlayNote(MP2KPlayer &player, MP2KTrack &trk, uint8_t cmd
     Note note;
     note.length = trk.lastNoteLen;
     note.midiKeyTrackData = trk.lastNoteKey;
-    note.midiKeyPitch = midiKeyPitch;
+    note.midiKeyPitch = mapping.midiKeyPitch;
     note.velocity = trk.lastNoteVel;
     note.priority = trk.priority;
-    note.rhythmPan = rhythmPan;
+    note.rhythmPan = mapping.rhythmPan;
     note.pseudoEchoVol = trk.pseudoEchoVol;
     note.pseudoEchoLen = trk.pseudoEchoLen;
     note.trackIdx = trk.trackIdx;
     note.playerIdx = player.playerIdx;
 
-    ADSR adsr;
-    adsr.att = rom.ReadU8(instrPos + 0x8);
-    adsr.dec = rom.ReadU8(instrPos + 0x9);
-    adsr.sus = rom.ReadU8(instrPos + 0xA);
-    adsr.rel = rom.ReadU8(instrPos + 0xB);
+    InstrumentInfo instr;
+    if (!GetInstrumentInfo(mapping.instrPos, instr))
+        return;
 
     // TODO move this to external function
     // TODO the track address comparison is not well defined in terms of the relative location
@@ -361,52 +527,136 @@ void SequenceReader::cmdPlayNote(MP2KPlayer &player, MP2KTrack &trk, uint8_t cmd
     };
 
     const MP2KChn *chn = nullptr;
-    const uint8_t instrType = rom.ReadU8(instrPos);
 
     // enqueue actual note
-    if (instrType & BANKDATA_TYPE_CGB) {
-        const uint8_t sweep = rom.ReadU8(instrPos + 0x3);
-        const uint32_t instrDutyWaveNp = rom.ReadU32(instrPos + 0x4);
-
-        switch (instrType & BANKDATA_TYPE_CGB) {
+    if (instr.type & BANKDATA_TYPE_CGB) {
+        switch (instr.type & BANKDATA_TYPE_CGB) {
         case BANKDATA_TYPE_SQ1:
             if (!cgbPolyphonySuppressFunc(ctx.sq1Channels))
                 return;
-            ctx.sq1Channels.emplace_back(ctx, &trk, instrDutyWaveNp, adsr, note, sweep);
+            ctx.sq1Channels.emplace_back(ctx, &trk, instr.dutyWaveNp, instr.adsr, note, instr.sweep);
             chn = &ctx.sq1Channels.back();
             break;
         case BANKDATA_TYPE_SQ2:
             if (!cgbPolyphonySuppressFunc(ctx.sq2Channels))
                 return;
-            ctx.sq2Channels.emplace_back(ctx, &trk, instrDutyWaveNp, adsr, note, 0);
+            ctx.sq2Channels.emplace_back(ctx, &trk, instr.dutyWaveNp, instr.adsr, note, uint8_t(0));
             chn = &ctx.sq2Channels.back();
             break;
         case BANKDATA_TYPE_WAVE:
             if (!cgbPolyphonySuppressFunc(ctx.waveChannels))
                 return;
             ctx.waveChannels.emplace_back(
-                ctx, &trk, instrDutyWaveNp, adsr, note, ctx.agbplaySoundMode.accurateCh3Volume
+                ctx, &trk, instr.dutyWaveNp, instr.adsr, note, ctx.agbplaySoundMode.accurateCh3Volume
             );
             chn = &ctx.waveChannels.back();
             break;
         case BANKDATA_TYPE_NOISE:
             if (!cgbPolyphonySuppressFunc(ctx.noiseChannels))
                 return;
-            ctx.noiseChannels.emplace_back(ctx, &trk, instrDutyWaveNp, adsr, note);
+            ctx.noiseChannels.emplace_back(ctx, &trk, instr.dutyWaveNp, instr.adsr, note);
             chn = &ctx.noiseChannels.back();
             break;
+        default:
+            assert(false);
+            return;
+        }
+    } else {
+        ctx.sndChannels.emplace_back(ctx, &trk, instr.sampleInfo, instr.adsr, note, instr.type & BANKDATA_TYPE_FIX);
+        chn = &ctx.sndChannels.back();
+    }
+
+    /* New notes should be added to the visualizer state immediately. Otherwise they won't be
+     * present during the first tick. */
+    assert(chn != nullptr);
+    AddNoteToState(trk, *chn);
+
+    // new notes need correct pitch and volume applied
+    trk.updateVolume = true;
+    trk.updatePitch = true;
+}
+
+bool SequenceReader::GetInstrumentMapping(size_t progPos, uint8_t key, InstrumentMapping &mapping)
+{
+    if (eventCache) {
+        if (const InstrumentMapping *cached = eventCache->FindMapping(progPos, key); cached) {
+            mapping = *cached;
+            return true;
+        }
+    }
+
+    const Rom &rom = ctx.rom;
+
+    mapping.instrPos = progPos;
+    mapping.rhythmPan = 0;
+    if (const uint8_t bankDataType = rom.ReadU8(progPos + 0x0); bankDataType & BANKDATA_TYPE_SPLIT) {
+        const size_t subBankPos = rom.ReadAgbPtrToPos(progPos + 0x4);
+        const size_t subKeyMap = rom.ReadAgbPtrToPos(progPos + 0x8);
+        mapping.instrPos = subBankPos + rom.ReadU8(subKeyMap + key) * 12;
+        if (rom.ReadU8(mapping.instrPos + 0x0) & (BANKDATA_TYPE_SPLIT | BANKDATA_TYPE_RHYTHM)) {
+            Debug::print("cmdPlayNote: attempting to play recursive key split");
+            return false;
+        }
+        mapping.midiKeyPitch = key;
+    } else if (bankDataType == BANKDATA_TYPE_RHYTHM) {
+        const size_t subBankPos = rom.ReadAgbPtrToPos(progPos + 0x4);
+        mapping.instrPos = subBankPos + key * 12;
+        if (rom.ReadU8(mapping.instrPos + 0x0) & (BANKDATA_TYPE_SPLIT | BANKDATA_TYPE_RHYTHM)) {
+            Debug::print("cmdPlayNote: attempting to play recursive rhythm part");
+            return false;
+        }
+        if (const uint8_t instrPan = rom.ReadU8(mapping.instrPos + 0x3); instrPan & 0x80)
+            mapping.rhythmPan = static_cast<int8_t>((instrPan - 0xC0) * 2);
+        mapping.midiKeyPitch = rom.ReadU8(mapping.instrPos + 0x1);
+    } else {
+        mapping.midiKeyPitch = key;
+    }
+
+    if (eventCache)
+        eventCache->AddMapping(progPos, key, mapping);
+    return true;
+}
+
+bool SequenceReader::GetInstrumentInfo(size_t instrPos, InstrumentInfo &instr)
+{
+    if (eventCache) {
+        if (const InstrumentInfo *cached = eventCache->FindInstrument(instrPos); cached) {
+            instr = *cached;
+            return true;
+        }
+    }
+
+    const Rom &rom = ctx.rom;
+    const RomSpan instrData = rom.GetSpan(instrPos, 12);
+
+    instr.adsr.att = instrData.ReadU8(0x8);
+    instr.adsr.dec = instrData.ReadU8(0x9);
+    instr.adsr.sus = instrData.ReadU8(0xA);
+    instr.adsr.rel = instrData.ReadU8(0xB);
+    instr.type = instrData.ReadU8(0x0);
+
+    if (instr.type & BANKDATA_TYPE_CGB) {
+        instr.sweep = instrData.ReadU8(0x3);
+        instr.dutyWaveNp = instrData.ReadU32(0x4);
+
+        switch (instr.type & BANKDATA_TYPE_CGB) {
+        case BANKDATA_TYPE_SQ1:
+        case BANKDATA_TYPE_SQ2:
+        case BANKDATA_TYPE_WAVE:
+        case BANKDATA_TYPE_NOISE:
+            break;
         default:
             Debug::print(
                 "CGB Error: Invalid CGB Type: [{:08X}]={:02X}, instrument: [{:08X}]",
                 instrPos,
-                rom.ReadU8(instrPos),
+                instr.type,
                 instrPos
             );
-            return;
+            return false;
         }
     } else {
         const size_t samplePos = rom.ReadAgbPtrToPos(instrPos + 0x4);
-        SampleInfo sinfo;
+        SampleInfo &sinfo = instr.sampleInfo;
 
         if (rom.ReadU8(samplePos + 0x0) == 0) {
             sinfo.gamefreakCompressed = false;
@@ -419,13 +669,19 @@ void SequenceReader::cmdPlayNote(MP2KPlayer &player, MP2KTrack &trk, uint8_t cmd
                 rom.ReadU8(samplePos),
                 instrPos
             );
-            return;
+            return false;
+        }
+
+        if (!rom.ValidRange(samplePos, 16)) {
+            Debug::print("Sample Error: Sample header reaches beyond end of file: instrument: [{:08X}]", instrPos);
+            return false;
         }
 
-        sinfo.loopEnabled = rom.ReadU8(samplePos + 0x3) & 0xC0;
-        sinfo.midCfreq = static_cast<float>(rom.ReadU32(samplePos + 4)) / 1024.0f;
-        sinfo.loopPos = rom.ReadU32(samplePos + 8);
-        sinfo.endPos = rom.ReadU32(samplePos + 12);
+        const RomSpan sampleHeader = rom.GetSpan(samplePos, 16);
+        sinfo.loopEnabled = sampleHeader.ReadU8(0x3) & 0xC0;
+        sinfo.midCfreq = static_cast<float>(sampleHeader.ReadU32(0x4)) / 1024.0f;
+        sinfo.loopPos = sampleHeader.ReadU32(0x8);
+        sinfo.endPos = sampleHeader.ReadU32(0xC);
 
         /* Fix malformed loops found in some romhacks */
         if (sinfo.loopPos > sinfo.endPos) {
@@ -436,26 +692,13 @@ void SequenceReader::cmdPlayNote(MP2KPlayer &player, MP2KTrack &trk, uint8_t cmd
             sinfo.loopEnabled = false;
         }
 
-        if (!rom.ValidRange(samplePos, 16)) {
-            Debug::print("Sample Error: Sample header reaches beyond end of file: instrument: [{:08X}]", instrPos);
-            return;
-        }
-
         sinfo.samplePos = samplePos;
         sinfo.samplePtr = static_cast<const int8_t *>(rom.GetPtr(samplePos + 16));
-
-        ctx.sndChannels.emplace_back(ctx, &trk, sinfo, adsr, note, instrType & BANKDATA_TYPE_FIX);
-        chn = &ctx.sndChannels.back();
     }
 
-    /* New notes should be added to the visualizer state immediately. Otherwise they won't be
-     * present during the first tick. */
-    assert(chn != nullptr);
-    AddNoteToState(trk, *chn);
-
-    // new notes need correct pitch and volume applied
-    trk.updateVolume = true;
-    trk.updatePitch = true;
+    if (eventCache)
+        eventCache->AddInstrument(instrPos, instr);
+    return true;
 }
 
 void SequenceReader::cmdPlayCommand(MP2KPlayer &player, MP2KTrack &trk, uint8_t cmd)
@@ -469,14 +712,7 @@ void SequenceReader::cmdPlayCommand(MP2KPlayer &player, MP2KTrack &trk, uint8_t
         break;
     case 0xB2:
         // GOTO
-        if (trk.trackIdx == 0) {
-            // handle agbplay's internal loop counter
-            if (ctx.agbplaySoundMode.maxLoops != LOOP_ENDLESS && numLoops++ >= ctx.agbplaySoundMode.maxLoops
-                && !endReached) {
-                endReached = true;
-                ctx.mixer.StartFadeOut(SONG_FADE_OUT_TIME);
-            }
-        }
+        cmdPlayGoto(trk);
         trk.pos = rom.ReadAgbPtrToPos(trk.pos);
         break;
     case 0xB3:
@@ -515,117 +751,159 @@ void SequenceReader::cmdPlayCommand(MP2KPlayer &player, MP2KTrack &trk, uint8_t
         // MEMACC
         cmdPlayMemacc(trk);
         break;
+    case 0xBA:    // PRIO
+    case 0xBB:    // TEMPO
+    case 0xBC:    // KEYSH
+    case 0xBD:    // VOICE
+    case 0xBE:    // VOL
+    case 0xBF:    // PAN
+    case 0xC0:    // BEND
+    case 0xC1:    // BENDR
+    case 0xC2:    // LFOS
+    case 0xC3:    // LFODL
+    case 0xC4:    // MOD
+    case 0xC5:    // MODT
+    case 0xC8:    // TUNE
+        cmdPlayParam(player, trk, cmd, rom.ReadU8(trk.pos++));
+        break;
+    case 0xCD:
+        // xCMD
+        cmdPlayXCmd(trk);
+        break;
+    case 0xCE:
+        // EOT
+        {
+            uint8_t key = rom.ReadU8(trk.pos);
+            if (key >= 0x80) {
+                key = trk.lastNoteKey;
+            } else {
+                trk.pos++;
+                trk.lastNoteKey = key;
+            }
+            cmdPlayEot(trk, key);
+        }
+        break;
+    default:
+        cmdPlayFine(trk);
+        break;
+    }
+}
+
+void SequenceReader::cmdPlayFine(MP2KTrack &trk)
+{
+    for (MP2KChn *chn = trk.channels; chn != nullptr; chn = chn->next) {
+        chn->Release();
+        chn->RemoveFromTrack();
+    }
+
+    trk.enabled = false;
+    trk.activeNotes.reset();
+    trk.activeVoiceTypes = VoiceFlags::NONE;
+}
+
+void SequenceReader::cmdPlayGoto(MP2KTrack &trk)
+{
+    if (trk.trackIdx != 0)
+        return;
+
+    // handle agbplay's internal loop counter, loops are counted even if playing endlessly
+    const uint8_t loopsDone = state.numLoops;
+    if (!state.endReached && state.numLoops < UINT8_MAX)
+        state.numLoops++;
+    if (ctx.agbplaySoundMode.maxLoops != LOOP_ENDLESS && loopsDone >= ctx.agbplaySoundMode.maxLoops
+        && !state.endReached) {
+        state.endReached = true;
+        ctx.mixer.StartFadeOut(SONG_FADE_OUT_TIME);
+    }
+}
+
+void SequenceReader::cmdPlayParam(MP2KPlayer &player, MP2KTrack &trk, uint8_t cmd, uint8_t arg)
+{
+    switch (cmd) {
     case 0xBA:
         // PRIO
-        trk.priority = rom.ReadU8(trk.pos++);
+        trk.priority = arg;
         break;
     case 0xBB:
         // TEMPO
-        player.bpm = static_cast<uint16_t>(rom.ReadU8(trk.pos++) * 2);
+        player.bpm = static_cast<uint16_t>(arg * 2);
         break;
     case 0xBC:
         // KEYSH
-        trk.keyShift = rom.ReadS8(trk.pos++);
+        trk.keyShift = static_cast<int8_t>(arg);
         break;
     case 0xBD:
         // VOICE
-        trk.prog = rom.ReadU8(trk.pos++);
+        trk.prog = arg;
         break;
     case 0xBE:
         // VOL
-        trk.vol = rom.ReadU8(trk.pos++);
+        trk.vol = arg;
         trk.updateVolume = true;
         break;
     case 0xBF:
         // PAN
-        trk.pan = static_cast<int8_t>(rom.ReadS8(trk.pos++) - 0x40);
+        trk.pan = static_cast<int8_t>(static_cast<int8_t>(arg) - 0x40);
         trk.updateVolume = true;
         break;
     case 0xC0:
         // BEND
-        trk.bend = static_cast<int8_t>(rom.ReadS8(trk.pos++) - 0x40);
+        trk.bend = static_cast<int8_t>(static_cast<int8_t>(arg) - 0x40);
         trk.updatePitch = true;
         break;
     case 0xC1:
         // BENDR
-        trk.bendr = rom.ReadU8(trk.pos++);
+        trk.bendr = arg;
         trk.updatePitch = true;
         break;
     case 0xC2:
         // LFOS
-        trk.lfos = rom.ReadU8(trk.pos++);
+        trk.lfos = arg;
         if (trk.lfos == 0)
             trk.ResetLfoValue();
         break;
     case 0xC3:
         // LFODL
-        trk.lfodlCount = trk.lfodl = rom.ReadU8(trk.pos++);
+        trk.lfodlCount = trk.lfodl = arg;
         break;
     case 0xC4:
         // MOD
-        trk.mod = rom.ReadU8(trk.pos++);
+        trk.mod = arg;
         if (trk.mod == 0)
             trk.ResetLfoValue();
         break;
     case 0xC5:
         // MODT
-        {
-            uint8_t modt = rom.ReadU8(trk.pos++);
-            if (static_cast<MODT>(modt) == trk.modt)
-                return;
-            trk.modt = static_cast<MODT>(modt);
-            trk.updateVolume = true;
-            trk.updatePitch = true;
-        }
+        if (static_cast<MODT>(arg) == trk.modt)
+            return;
+        trk.modt = static_cast<MODT>(arg);
+        trk.updateVolume = true;
+        trk.updatePitch = true;
         break;
     case 0xC8:
         // TUNE
-        trk.tune = static_cast<int8_t>(rom.ReadS8(trk.pos++) - 0x40);
+        trk.tune = static_cast<int8_t>(static_cast<int8_t>(arg) - 0x40);
         trk.updatePitch = true;
         break;
-    case 0xCD:
-        // xCMD
-        cmdPlayXCmd(trk);
-        break;
-    case 0xCE:
-        // EOT
-        {
-            uint8_t key = rom.ReadU8(trk.pos);
-            if (key >= 0x80) {
-                key = trk.lastNoteKey;
-            } else {
-                trk.pos++;
-                trk.lastNoteKey = key;
-            }
-            for (MP2KChn *chn = trk.channels; chn != nullptr; chn = chn->next) {
-                assert(chn->trackOrg == &trk);
-                if (chn->envState == EnvState::DEAD)
-                    continue;
-                if (chn->IsReleasing())
-                    continue;
-                if (chn->note.midiKeyTrackData == key) {
-                    chn->Release();
-                    break;
-                }
-            }
-        }
-        break;
     default:
-        cmdPlayFine(trk);
+        assert(false);
         break;
     }
 }
 
-void SequenceReader::cmdPlayFine(MP2KTrack &trk)
+void SequenceReader::cmdPlayEot(MP2KTrack &trk, uint8_t key)
 {
     for (MP2KChn *chn = trk.channels; chn != nullptr; chn = chn->next) {
-        chn->Release();
-        chn->RemoveFromTrack();
+        assert(chn->trackOrg == &trk);
+        if (chn->envState == EnvState::DEAD)
+            continue;
+        if (chn->IsReleasing())
+            continue;
+        if (chn->note.midiKeyTrackData == key) {
+            chn->Release();
+            break;
+        }
     }
-
-    trk.enabled = false;
-    trk.activeNotes.reset();
-    trk.activeVoiceTypes = VoiceFlags::NONE;
 }
 
 void SequenceReader::cmdPlayMemacc(MP2KTrack &trk)
@@ -1,10 +1,11 @@
 #pragma once
 
 #include "Constants.hpp"
+#include "SequenceEventCache.hpp"
 #include "SoundData.hpp"
 #include "SoundMixer.hpp"
 
-#include <map>
+#include <memory>
 #include <vector>
 
 struct MP2KContext;
@@ -19,24 +20,37 @@ public:
     SequenceReader(const SequenceReader &) = delete;
     SequenceReader &operator=(const SequenceReader &) = delete;
 
+    /* song progress, copied for snapshots (see MP2KSnapshot) */
+    struct State
+    {
+        bool endReached = false;
+        uint8_t numLoops = 0;
+    };
+
     void Process();
     bool EndReached() const;
+    uint8_t GetNumLoops() const;
     void Restart();
+    State GetState() const;
+    void SetState(const State &state);
     void SetSpeedFactor(float speedFactor);
     float GetSpeedFactor() const;
+    void SetEventCacheEnabled(bool enabled);
+    bool IsEventCacheEnabled() const;
 
 private:
-    static const std::map<uint8_t, uint8_t> delayLut;
-    static const std::map<uint8_t, uint8_t> noteLut;
-
     MP2KContext &ctx;
 
-    bool endReached = false;
-    uint8_t numLoops = 0;
+    State state;
     float speedFactor = 1.0f;
+    std::unique_ptr<SequenceEventCache> eventCache;
 
     bool PlayerMain(MP2KPlayer &player);
     bool TrackMain(MP2KPlayer &player, MP2KTrack &trk);
+    bool EventMain(MP2KPlayer &player, MP2KTrack &trk);
+    bool CachedEventMain(MP2KPlayer &player, MP2KTrack &trk);
+    uint32_t LookupEvent(size_t pos, uint8_t lastCmd);
+    SequenceEvent CompileEvent(size_t pos, uint8_t lastCmd) const;
     void TrackVolPitchMain(MP2KTrack &trk);
     void
         TrackVolPitchSet(MP2KTrack &trk, uint16_t vol, int16_t pan, int16_t pitch, bool updateVolume, bool updatePitch);
@@ -46,7 +60,14 @@ private:
     void cmdPlayNote(MP2KPlayer &player, MP2KTrack &trk, uint8_t cmd);
     void cmdPlayCommand(MP2KPlayer &player, MP2KTrack &trk, uint8_t cmd);
 
+    void PlayNote(MP2KPlayer &player, MP2KTrack &trk);
+    bool GetInstrumentMapping(size_t progPos, uint8_t key, InstrumentMapping &mapping);
+    bool GetInstrumentInfo(size_t instrPos, InstrumentInfo &instrument);
+
     void cmdPlayFine(MP2KTrack &trk);
+    void cmdPlayGoto(MP2KTrack &trk);
+    void cmdPlayParam(MP2KPlayer &player, MP2KTrack &trk, uint8_t cmd, uint8_t arg);
+    void cmdPlayEot(MP2KTrack &trk, uint8_t key);
     void cmdPlayMemacc(MP2KTrack &trk);
     void cmdPlayXCmd(MP2KTrack &trk);
 };
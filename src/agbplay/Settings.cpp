@@ -66,6 +66,18 @@ void Settings::Load()
         exportPadEnd = 0.0;
     }
 
+    if (j.contains("exportThreads") && j["exportThreads"].is_number()) {
+        exportThreads = j["exportThreads"];
+    } else {
+        exportThreads = 0;
+    }
+
+    if (j.contains("exportSegmented") && j["exportSegmented"].is_boolean()) {
+        exportSegmented = j["exportSegmented"];
+    } else {
+        exportSegmented = false;
+    }
+
     if (j.contains("exportQuickExportDirectory") && j["exportQuickExportDirectory"].is_string()) {
         exportQuickExportDirectory =
             reinterpret_cast<const char8_t *>(std::string(j["exportQuickExportDirectory"]).c_str());
@@ -90,6 +102,8 @@ void Settings::Save()
     j["exportBitDepth"] = exportBitDepth;
     j["exportPadStart"] = exportPadStart;
     j["exportPadEnd"] = exportPadEnd;
+    j["exportThreads"] = exportThreads;
+    j["exportSegmented"] = exportSegmented;
     j["exportQuickExportDirectory"] = exportQuickExportDirectory;
     j["exportQuickExportAsk"] = exportQuickExportAsk;
 
@@ -15,6 +15,11 @@ struct Settings
     uint32_t exportBitDepth = 0;
     double exportPadStart = 0.0;
     double exportPadEnd = 0.0;
+    /* 0 = use one thread per hardware thread */
+    uint32_t exportThreads = 0;
+    /* Split up single songs to use threads which would be idle otherwise. The reverbs at the segment boundaries may
+     * differ slightly from rendering in one go, see SegmentedRenderer. */
+    bool exportSegmented = false;
     std::filesystem::path exportQuickExportDirectory;
     bool exportQuickExportAsk = false;
 };
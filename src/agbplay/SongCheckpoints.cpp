@@ -0,0 +1,343 @@
+#include "SongCheckpoints.hpp"
+
+#include "Debug.hpp"
+#include "MP2KContext.hpp"
+#include "Xcept.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+/*
+ * public SongCheckpoints
+ */
+
+SongCheckpoints::SongCheckpoints(
+    uint32_t sampleRate,
+    const Rom &rom,
+    const SongTableInfo &songTableInfo,
+    const PlayerTableInfo &playerTableInfo,
+    size_t maxSubframes
+) :
+    sampleRate(sampleRate),
+    rom(rom),
+    songTableInfo(songTableInfo),
+    playerTableInfo(playerTableInfo),
+    maxSubframes(maxSubframes)
+{
+    recordThread = std::thread(&SongCheckpoints::threadWorker, this);
+#ifdef __linux__
+    pthread_setname_np(recordThread.native_handle(), "checkpoint thread");
+#endif
+}
+
+SongCheckpoints::~SongCheckpoints()
+{
+    {
+        std::unique_lock lock(mutex);
+        quitRequest = true;
+        requestsPending = true;
+    }
+    requestsChanged.notify_one();
+    recordThread.join();
+}
+
+uint32_t SongCheckpoints::Load(
+    const MP2KSoundMode &mp2kSoundMode, const AgbplaySoundMode &agbplaySoundMode, uint16_t songId
+)
+{
+    std::unique_lock lock(mutex);
+    generation++;
+    loadRequest = LoadRequest{mp2kSoundMode, agbplaySoundMode, songId, generation};
+    waitSubframe = 0;
+    requestsPending = true;
+    requestsChanged.notify_one();
+    return generation;
+}
+
+void SongCheckpoints::RequestSeek(uint32_t loadGeneration, size_t subframe)
+{
+    std::unique_lock lock(mutex);
+    seekRequestId++;
+    seekGeneration = loadGeneration;
+    seekSubframe = subframe;
+    requestsPending = true;
+    requestsChanged.notify_one();
+}
+
+bool SongCheckpoints::TakeSeek(std::unique_ptr<MP2KContext> &ctx)
+{
+    std::unique_lock lock(mutex);
+    /* There is only room for one context to destroy, the previous one has to be gone first. */
+    if (seekDoneId != seekRequestId || retiredCtx)
+        return false;
+    if (!preparedCtx)
+        return true;
+
+    preparedCtx->reader.SetSpeedFactor(ctx->reader.GetSpeedFactor());
+    for (size_t playerIdx = 0; playerIdx < std::min(ctx->players.size(), preparedCtx->players.size()); playerIdx++) {
+        const MP2KPlayer &player_src = ctx->players[playerIdx];
+        MP2KPlayer &player_dst = preparedCtx->players[playerIdx];
+        for (size_t trackIdx = 0; trackIdx < std::min(player_src.tracks.size(), player_dst.tracks.size()); trackIdx++)
+            player_dst.tracks[trackIdx].muted = player_src.tracks[trackIdx].muted;
+    }
+
+    std::swap(ctx, preparedCtx);
+    retiredCtx = std::move(preparedCtx);
+    requestsPending = true;
+    requestsChanged.notify_one();
+    return true;
+}
+
+bool SongCheckpoints::Seek(MP2KContext &ctx, size_t subframe)
+{
+    {
+        std::unique_lock lock(mutex);
+        if (generation == 0)
+            throw Xcept("Cannot seek before a song was loaded");
+
+        const uint32_t waitGeneration = generation;
+        waitSubframe = subframe;
+        requestsPending = true;
+        requestsChanged.notify_one();
+        checkpointsChanged.wait(lock, [&]() {
+            return generation != waitGeneration || (recordGeneration == generation && ready(subframe));
+        });
+        waitSubframe = 0;
+        if (generation != waitGeneration)
+            return false;
+    }
+
+    return seekFrom(ctx, subframe);
+}
+
+/*
+ * private SongCheckpoints
+ */
+
+void SongCheckpoints::threadWorker()
+{
+    while (!quitRequest) {
+        if (requestsPending.exchange(false)) {
+            handleRequests();
+            continue;
+        }
+
+        if (recordCtx && recordPos < recordLimit) {
+            try {
+                recordSubframe();
+            } catch (const std::exception &e) {
+                Debug::print("Recording seek checkpoints of song {} failed: {}", recording->songId, e.what());
+                finishRecording();
+            }
+            continue;
+        }
+
+        /* continued once a song is loaded or a seek wants the recording to go further */
+        std::unique_lock lock(mutex);
+        requestsChanged.wait(lock, [this]() { return requestsPending.load(); });
+    }
+
+    /* everything is destroyed on this thread, including what the mixer thread has handed back */
+    recordCtx.reset();
+    seekCtx.reset();
+    std::unique_lock lock(mutex);
+    checkpoints.clear();
+    preparedCtx.reset();
+    retiredCtx.reset();
+}
+
+void SongCheckpoints::handleRequests()
+{
+    std::unique_lock lock(mutex);
+    /* Whatever was dropped is destroyed without holding the lock, the mixer thread may be waiting for it. */
+    std::unique_ptr<MP2KContext> retired = std::move(retiredCtx);
+    std::unique_ptr<MP2KContext> superseded;
+    if (seekDoneId != seekRequestId)
+        superseded = std::move(preparedCtx);
+    std::optional<LoadRequest> load = std::exchange(loadRequest, std::nullopt);
+    std::vector<Checkpoint> oldCheckpoints;
+    if (load) {
+        oldCheckpoints.swap(checkpoints);
+        recordGeneration = 0;
+        recordDone = false;
+    }
+    lock.unlock();
+
+    retired.reset();
+    superseded.reset();
+    oldCheckpoints.clear();
+    if (load)
+        startRecording(*load);
+
+    lock.lock();
+    size_t wanted = waitSubframe;
+    bool handedOver = false;
+    if (seekDoneId != seekRequestId) {
+        if (seekGeneration != generation) {
+            /* another song was loaded since */
+            seekDoneId = seekRequestId;
+        } else if (recordGeneration == generation && ready(seekSubframe)) {
+            const uint64_t id = seekRequestId;
+            const size_t target = seekSubframe;
+            lock.unlock();
+
+            try {
+                if (!seekCtx)
+                    seekCtx = makeContext();
+                seekFrom(*seekCtx, target);
+            } catch (const std::exception &e) {
+                Debug::print("Preparing seek to subframe {} failed: {}", target, e.what());
+                seekCtx.reset();
+            }
+
+            lock.lock();
+            /* Otherwise there already is a new request, which is prepared in the same context next time. */
+            if (seekRequestId == id) {
+                preparedCtx = std::move(seekCtx);
+                seekDoneId = id;
+                handedOver = true;
+            }
+        } else {
+            wanted = std::max(wanted, seekSubframe);
+        }
+    }
+    if (wanted > 0)
+        recordLimit = std::max(recordLimit, std::min(wanted + RECORD_AHEAD, maxSubframes));
+    lock.unlock();
+
+    /* have the next one ready in advance */
+    if (handedOver && recording) {
+        try {
+            seekCtx = makeContext();
+        } catch (const std::exception &e) {
+            Debug::print("Creating seek context failed: {}", e.what());
+        }
+    }
+}
+
+void SongCheckpoints::startRecording(const LoadRequest &request)
+{
+    recordCtx.reset();
+    seekCtx.reset();
+    recording = request;
+    recordPos = 0;
+    recordLimit = std::min(RECORD_AHEAD, maxSubframes);
+
+    std::shared_ptr<MP2KSnapshot> snapshot;
+    try {
+        recordCtx = makeContext();
+        recordCtx->m4aSongNumStart(request.songId);
+        snapshot = std::make_shared<MP2KSnapshot>();
+        recordCtx->SaveSnapshot(*snapshot);
+    } catch (const std::exception &e) {
+        Debug::print("Recording seek checkpoints of song {} failed: {}", request.songId, e.what());
+        recordCtx.reset();
+        snapshot.reset();
+    }
+
+    std::unique_lock lock(mutex);
+    if (snapshot)
+        checkpoints.emplace_back(0, std::move(snapshot));
+    recordGeneration = request.generation;
+    recordDone = !recordCtx;
+    checkpointsChanged.notify_all();
+}
+
+void SongCheckpoints::recordSubframe()
+{
+    recordCtx->m4aSoundMainSkip();
+    recordPos++;
+    if (recordCtx->SongEnded() || recordPos >= maxSubframes) {
+        finishRecording();
+        return;
+    }
+    if (recordPos % CHECKPOINT_INTERVAL != 0)
+        return;
+
+    auto snapshot = std::make_shared<MP2KSnapshot>();
+    recordCtx->SaveSnapshot(*snapshot);
+    snapshot->DropSkippedEffects();
+
+    std::unique_lock lock(mutex);
+    checkpoints.emplace_back(recordPos, std::move(snapshot));
+    /* a seek request may have waited for it */
+    requestsPending = true;
+    checkpointsChanged.notify_all();
+}
+
+void SongCheckpoints::finishRecording()
+{
+    recordCtx.reset();
+
+    std::unique_lock lock(mutex);
+    recordDone = true;
+    requestsPending = true;
+    checkpointsChanged.notify_all();
+}
+
+std::unique_ptr<MP2KContext> SongCheckpoints::makeContext() const
+{
+    assert(recording);
+    return std::make_unique<MP2KContext>(
+        sampleRate, rom, recording->mp2kSoundMode, recording->agbplaySoundMode, songTableInfo, playerTableInfo
+    );
+}
+
+bool SongCheckpoints::seekFrom(MP2KContext &ctx, size_t subframe) const
+{
+    size_t pos = 0;
+    std::shared_ptr<const MP2KSnapshot> snapshot;
+    {
+        std::unique_lock lock(mutex);
+        if (checkpoints.empty())
+            throw Xcept("No seek checkpoints were recorded");
+
+        /* the last checkpoint which leaves enough time to warm up, or the start of the song */
+        auto it = std::upper_bound(
+            checkpoints.begin(), checkpoints.end(), subframe, [](size_t target, const Checkpoint &checkpoint) {
+                return target < checkpoint.subframe + SEEK_WARMUP;
+            }
+        );
+        if (it != checkpoints.begin())
+            it--;
+        pos = it->subframe;
+        snapshot = it->snapshot;
+    }
+
+    ctx.RestoreSnapshot(*snapshot);
+
+    /* If the recording has stopped before the target, don't go further than usual. */
+    const size_t end = std::min(subframe, pos + MAX_SEEK_SUBFRAMES);
+    const size_t warmupStart = std::max(pos, end - std::min(end, SEEK_WARMUP));
+
+    /* checkpoints are recorded at normal speed */
+    const float speedFactor = ctx.reader.GetSpeedFactor();
+    ctx.reader.SetSpeedFactor(1.0f);
+    bool ended = false;
+    /* skipping ends up exactly where rendering would, except for the reverbs */
+    while (pos < warmupStart && !ended) {
+        ctx.m4aSoundMainSkip();
+        pos++;
+        ended = ctx.SongEnded();
+    }
+    while (pos < end && !ended) {
+        const size_t maxSubframes = std::min(SEEK_BLOCK_SUBFRAMES, end - pos);
+        const size_t subframes = ctx.m4aSoundMainBlock(maxSubframes);
+        pos += subframes;
+        ended = subframes < maxSubframes;
+    }
+    ctx.reader.SetSpeedFactor(speedFactor);
+
+    if (!ended && end < subframe) {
+        Debug::print("Seek target {} is beyond the recorded checkpoints, stopped at {}", subframe, end);
+        return false;
+    }
+    return !ended;
+}
+
+/* mutex must be held */
+bool SongCheckpoints::ready(size_t subframe) const
+{
+    return recordDone || (!checkpoints.empty() && checkpoints.back().subframe + MAX_SEEK_SUBFRAMES >= subframe);
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Constants.hpp"
+#include "MP2KSnapshot.hpp"
+#include "Types.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+class Rom;
+struct MP2KContext;
+
+/* SongCheckpoints runs through a song on its own thread without producing any audio (MP2KContext::m4aSoundMainSkip)
+ * and records a snapshot of the context every CHECKPOINT_INTERVAL. A seek restores the last checkpoint before the
+ * target, skips up to SEEK_WARMUP before it and only renders the rest. Skipping does not feed the reverbs (except in
+ * native mix rate mode), the warm-up fills them again.
+ *
+ * All contexts and snapshots are created and destroyed by the record thread. For playback, it also prepares the
+ * seeks (RequestSeek) in a context of its own, which the mixer thread swaps in between two blocks (TakeSeek). Neither
+ * the UI thread nor the mixer thread ever has to render, allocate a context or wait for the recording.
+ *
+ * Only RECORD_AHEAD is recorded at first. Seeks extend the recording to RECORD_AHEAD after their target, so songs
+ * which loop endlessly are only recorded as far as somebody wants to seek. */
+
+class SongCheckpoints
+{
+public:
+    /* maxSubframes limits the recording of songs which loop endlessly */
+    SongCheckpoints(
+        uint32_t sampleRate,
+        const Rom &rom,
+        const SongTableInfo &songTableInfo,
+        const PlayerTableInfo &playerTableInfo,
+        size_t maxSubframes = MAX_SUBFRAMES
+    );
+    SongCheckpoints(const SongCheckpoints &) = delete;
+    SongCheckpoints &operator=(const SongCheckpoints &) = delete;
+    ~SongCheckpoints();
+
+    /* Starts recording a song, which replaces the previous recording. Returns its generation, which RequestSeek refers
+     * to. Does not wait for the record thread. */
+    uint32_t Load(const MP2KSoundMode &mp2kSoundMode, const AgbplaySoundMode &agbplaySoundMode, uint16_t songId);
+
+    /* Asks the record thread to prepare a context at the given subframe after the start of the song of the given
+     * generation (see Load). Replaces the previous request. Does not wait for the record thread. */
+    void RequestSeek(uint32_t loadGeneration, size_t subframe);
+    /* Returns false until the context for the last request is ready. Then it is swapped with ctx and true is returned.
+     * Settings which are not part of snapshots (speed factor, muted tracks) are taken over from the old ctx, which is
+     * then destroyed by the record thread. If the request could not be prepared (e.g. it was for a previous
+     * generation), true is returned and ctx is left alone.
+     * Does not wait for the record thread and does not allocate. */
+    bool TakeSeek(std::unique_ptr<MP2KContext> &ctx);
+
+    /* Moves ctx (which must have been created with the same sample rate, ROM, tables and sound mode as the loaded
+     * song) to the given subframe after the start of the song, waiting for the recording as far as necessary.
+     * At most MAX_SEEK_SUBFRAMES are skipped and rendered after the checkpoint, with a speed factor of 1.
+     * Returns false if the song ended or the recording stopped too far before the target. */
+    bool Seek(MP2KContext &ctx, size_t subframe);
+
+    static inline const size_t CHECKPOINT_INTERVAL = 5 * AGB_FPS * INTERFRAMES;
+    static inline const size_t SEEK_WARMUP = 2 * AGB_FPS * INTERFRAMES;
+    static inline const size_t MAX_SEEK_SUBFRAMES = CHECKPOINT_INTERVAL + SEEK_WARMUP;
+    static inline const size_t RECORD_AHEAD = 2 * 60 * AGB_FPS * INTERFRAMES;
+    /* songs which loop endlessly are not recorded longer than one hour */
+    static inline const size_t MAX_SUBFRAMES = 60 * 60 * AGB_FPS * INTERFRAMES;
+
+private:
+    static inline const size_t SEEK_BLOCK_SUBFRAMES = 16;
+
+    struct Checkpoint
+    {
+        size_t subframe;
+        std::shared_ptr<const MP2KSnapshot> snapshot;
+    };
+
+    struct LoadRequest
+    {
+        MP2KSoundMode mp2kSoundMode;
+        AgbplaySoundMode agbplaySoundMode;
+        uint16_t songId;
+        uint32_t generation;
+    };
+
+    void threadWorker();
+    void handleRequests();
+    void startRecording(const LoadRequest &request);
+    void recordSubframe();
+    void finishRecording();
+    std::unique_ptr<MP2KContext> makeContext() const;
+    bool seekFrom(MP2KContext &ctx, size_t subframe) const;
+    bool ready(size_t subframe) const;
+
+    const uint32_t sampleRate;
+    const Rom &rom;
+    const SongTableInfo songTableInfo;
+    const PlayerTableInfo playerTableInfo;
+    const size_t maxSubframes;
+
+    /* Guards everything below up to the record thread's own state. requestsPending is set while holding it, so the
+     * record thread can't miss the notification. */
+    mutable std::mutex mutex;
+    std::condition_variable requestsChanged;
+    std::condition_variable checkpointsChanged;
+    std::atomic<bool> requestsPending = false;
+    std::atomic<bool> quitRequest = false;
+    std::optional<LoadRequest> loadRequest;
+    uint32_t generation = 0;
+    /* the Seek which is waiting for the recording, 0 if none */
+    size_t waitSubframe = 0;
+    /* the last seek request, which is done once seekDoneId has caught up with seekRequestId */
+    uint64_t seekRequestId = 0;
+    uint64_t seekDoneId = 0;
+    uint32_t seekGeneration = 0;
+    size_t seekSubframe = 0;
+    std::unique_ptr<MP2KContext> preparedCtx;
+    std::unique_ptr<MP2KContext> retiredCtx;
+    /* of recordGeneration, recordDone is set once no further checkpoints will be added */
+    std::vector<Checkpoint> checkpoints;
+    uint32_t recordGeneration = 0;
+    bool recordDone = false;
+
+    /* record thread only */
+    std::optional<LoadRequest> recording;
+    std::unique_ptr<MP2KContext> recordCtx;
+    std::unique_ptr<MP2KContext> seekCtx;
+    size_t recordPos = 0;
+    size_t recordLimit = 0;
+
+    std::thread recordThread;
+};
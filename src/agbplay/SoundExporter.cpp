@@ -5,10 +5,12 @@
 #include "MP2KContext.hpp"
 #include "OS.hpp"
 #include "Profile.hpp"
+#include "SegmentedRenderer.hpp"
 #include "Settings.hpp"
 #include "Util.hpp"
 #include "Xcept.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <boost/algorithm/string/replace.hpp>
 #include <chrono>
@@ -17,6 +19,8 @@
 #include <codecvt>
 #include <filesystem>
 #include <mutex>
+#include <numeric>
+#include <optional>
 #include <sndfile.h>
 #include <thread>
 
@@ -49,41 +53,82 @@ void SoundExporter::Export()
         }
     }
 
+    size_t numThreads = settings.exportThreads;
+    if (numThreads == 0)
+        numThreads = std::thread::hardware_concurrency();
+    if (numThreads == 0)
+        numThreads = 1;
+    /* If there are fewer songs than threads, e.g. for a quick export, each song may be split up into segments
+     * which are rendered by the threads which would be idle otherwise. */
+    size_t threadsPerSong = 1;
+    if (settings.exportSegmented)
+        threadsPerSong = std::max<size_t>(1, numThreads / std::max<size_t>(1, profile.playlist.size()));
+    numThreads = std::min(numThreads, profile.playlist.size());
+
+    auto runWorkers = [numThreads](const std::function<void(void)> &threadFunc) {
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < numThreads; i++)
+            workers.emplace_back(threadFunc);
+        for (auto &w : workers)
+            w.join();
+    };
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    /* Songs are rendered longest first. If a long song is picked up last, a single thread
+     * keeps on rendering while all the others are already idle. The length of each song is determined
+     * by a dry run, which is a lot cheaper than the actual rendering. */
+    std::vector<size_t> renderOrder(profile.playlist.size());
+    std::iota(renderOrder.begin(), renderOrder.end(), 0);
+
+    if (numThreads > 1) {
+        std::vector<size_t> songCosts(profile.playlist.size(), 0);
+        std::atomic<size_t> currentEstimate = 0;
+
+        runWorkers([&]() {
+            OS::LowerThreadPriority();
+            while (true) {
+                size_t i = currentEstimate++;    // atomic ++
+                if (i >= profile.playlist.size())
+                    return;
+                songCosts.at(i) = estimateSongCost(profile.playlist.at(i).id);
+            }
+        });
+
+        std::stable_sort(renderOrder.begin(), renderOrder.end(), [&songCosts](size_t a, size_t b) {
+            return songCosts.at(a) > songCosts.at(b);
+        });
+
+        Debug::print(
+            "Song lengths, longest: {:.1f}s, shortest: {:.1f}s",
+            static_cast<double>(songCosts.at(renderOrder.front())) / (AGB_FPS * INTERFRAMES),
+            static_cast<double>(songCosts.at(renderOrder.back())) / (AGB_FPS * INTERFRAMES)
+        );
+    }
+
     /* setup export thread worker function */
     std::atomic<size_t> currentSong = 0;
     std::atomic<size_t> totalSamplesRendered = 0;
 
-    std::function<void(void)> threadFunc = [&]() {
+    runWorkers([&]() {
         OS::LowerThreadPriority();
         while (true) {
-            size_t i = currentSong++;    // atomic ++
-            if (i >= profile.playlist.size())
+            size_t n = currentSong++;    // atomic ++
+            if (n >= renderOrder.size())
                 return;
+            const size_t i = renderOrder.at(n);
 
             /* name's in profile are utf8 encoded */
             std::string name = profile.playlist.at(i).name;
             ReplaceIllegalPathCharacters(name, '_');
-            Debug::print("{:3}% - Rendering to file: \"{}\"", (i + 1) * 100 / profile.playlist.size(), name);
+            Debug::print("{:3}% - Rendering to file: \"{}\"", (n + 1) * 100 / renderOrder.size(), name);
             std::u8string u8name(reinterpret_cast<const char8_t *>(name.c_str()));
             std::filesystem::path filePath = directory;
             filePath /= fmt::format("{:03d} - ", i + 1);
             filePath += u8name;
-            totalSamplesRendered += exportSong(filePath, profile.playlist.at(i).id);
+            totalSamplesRendered += exportSong(filePath, profile.playlist.at(i).id, threadsPerSong);
         }
-    };
-
-    /* run the actual export threads */
-    auto startTime = std::chrono::high_resolution_clock::now();
-
-    size_t numThreads = std::thread::hardware_concurrency();
-    if (numThreads == 0)
-        numThreads = 1;
-    std::vector<std::thread> workers;
-    for (size_t i = 0; i < numThreads; i++)
-        workers.emplace_back(threadFunc);
-    for (auto &w : workers)
-        w.join();
-    workers.clear();
+    });
 
     auto endTime = std::chrono::high_resolution_clock::now();
 
@@ -118,7 +163,7 @@ void SoundExporter::writeSilence(SNDFILE *ofile, double seconds)
     sf_writef_float(ofile, reinterpret_cast<float *>(silence.data()), static_cast<sf_count_t>(silence.size()));
 }
 
-size_t SoundExporter::exportSong(const std::filesystem::path &filePath, uint16_t uid)
+size_t SoundExporter::estimateSongCost(uint16_t uid) const
 {
     MP2KContext ctx(
         settings.exportSampleRate,
@@ -129,12 +174,48 @@ size_t SoundExporter::exportSong(const std::filesystem::path &filePath, uint16_t
         profile.playerTablePlayback
     );
 
-    ctx.m4aSongNumStart(uid);
+    return ctx.AnalyzeSong(uid, COST_ESTIMATE_MAX_SUBFRAMES).totalSubframes;
+}
+
+size_t SoundExporter::exportSong(const std::filesystem::path &filePath, uint16_t uid, size_t numThreads)
+{
+    // separate tracks have to contain their own reverb
+    AgbplaySoundMode agbplaySoundMode = profile.agbplaySoundMode;
+    if (seperate)
+        agbplaySoundMode.sharedReverb = false;
+
+    /* Either segments of the song are rendered concurrently (see SegmentedRenderer), or the song is rendered in one
+     * go on this thread. */
+    std::optional<SegmentedRenderer> renderer;
+    std::optional<MP2KContext> ctx;
+    uint8_t playerIdx = 0;
+    size_t nTracks = 0;
+
+    if (numThreads > 1) {
+        renderer.emplace(
+            settings.exportSampleRate,
+            Rom::Instance(),
+            profile.mp2kSoundModePlayback,
+            agbplaySoundMode,
+            profile.songTableInfoPlayback,
+            profile.playerTablePlayback
+        );
+        nTracks = renderer->TracksUsed(uid);
+    } else {
+        ctx.emplace(
+            settings.exportSampleRate,
+            Rom::Instance(),
+            profile.mp2kSoundModePlayback,
+            agbplaySoundMode,
+            profile.songTableInfoPlayback,
+            profile.playerTablePlayback
+        );
+        ctx->m4aSongNumStart(uid);
+        playerIdx = ctx->m4aSongNumPlayerGet(uid);
+        nTracks = ctx->players.at(playerIdx).tracksUsed;
+    }
 
-    const uint8_t playerIdx = ctx.m4aSongNumPlayerGet(uid);
     size_t samplesRendered = 0;
-    size_t samplesPerBuffer = ctx.mixer.GetSamplesPerBuffer();
-    size_t nTracks = ctx.players.at(playerIdx).tracksUsed;
     const double padSecondsStart = settings.exportPadStart;
     const double padSecondsEnd = settings.exportPadEnd;
     int bitDepth = SF_FORMAT_PCM_16;
@@ -147,10 +228,13 @@ size_t SoundExporter::exportSong(const std::filesystem::path &filePath, uint16_t
         bitDepth = SF_FORMAT_FLOAT;
     }
 
+    /* one file for each track or one for the master output, none if benchmark only */
+    std::vector<SNDFILE *> ofiles;
+
     if (!benchmarkOnly) {
         /* save each track to a separate file */
         if (seperate) {
-            std::vector<SNDFILE *> ofiles(nTracks, nullptr);
+            ofiles.resize(nTracks, nullptr);
             std::vector<SF_INFO> oinfos(nTracks);
 
             for (size_t i = 0; i < nTracks; i++) {
@@ -168,35 +252,6 @@ size_t SoundExporter::exportSong(const std::filesystem::path &filePath, uint16_t
                 if (ofiles[i] == NULL)
                     Debug::print("Error: {}", sf_strerror(NULL));
             }
-
-            while (true) {
-                ctx.m4aSoundMain();
-                if (ctx.SongEnded())
-                    break;
-
-                assert(ctx.players.at(playerIdx).tracks.size() == nTracks);
-
-                for (size_t i = 0; i < nTracks; i++) {
-                    // do not write to invalid files
-                    if (ofiles[i] == NULL)
-                        continue;
-                    sf_count_t processed = 0;
-                    do {
-                        processed += sf_writef_float(
-                            ofiles[i],
-                            &ctx.players.at(playerIdx).tracks.at(i).audioBuffer[processed].left,
-                            sf_count_t(samplesPerBuffer) - processed
-                        );
-                    } while (processed < sf_count_t(samplesPerBuffer));
-                }
-                samplesRendered += samplesPerBuffer;
-            }
-
-            for (SNDFILE *&i : ofiles) {
-                int err = sf_close(i);
-                if (err != 0)
-                    Debug::print("Error: {}", sf_error_number(err));
-            }
         } else {
             SF_INFO oinfo;
             memset(&oinfo, 0, sizeof(oinfo));
@@ -216,36 +271,61 @@ size_t SoundExporter::exportSong(const std::filesystem::path &filePath, uint16_t
             }
 
             writeSilence(ofile, padSecondsStart);
+            ofiles.push_back(ofile);
+        }
+    }
 
-            while (true) {
-                ctx.m4aSoundMain();
-                if (ctx.SongEnded())
-                    break;
-
-                sf_count_t processed = 0;
-                do {
-                    processed += sf_writef_float(
-                        ofile, &ctx.masterAudioBuffer[processed].left, sf_count_t(samplesPerBuffer) - processed
-                    );
-                } while (processed < sf_count_t(samplesPerBuffer));
-                samplesRendered += samplesPerBuffer;
+    /* stream(i) returns the numSamples samples to write to file i */
+    auto writeStreams = [&ofiles](size_t numSamples, auto &&stream) {
+        for (size_t i = 0; i < ofiles.size(); i++) {
+            // do not write to invalid files
+            if (ofiles[i] == NULL)
+                continue;
+            const sample *samples = stream(i);
+            sf_count_t processed = 0;
+            while (processed < sf_count_t(numSamples)) {
+                processed += sf_writef_float(ofiles[i], &samples[processed].left, sf_count_t(numSamples) - processed);
             }
+        }
+    };
 
-            writeSilence(ofile, padSecondsEnd);
+    if (renderer) {
+        samplesRendered = renderer->Render(
+            uid,
+            seperate,
+            numThreads,
+            SegmentedRenderer::SEGMENT_SUBFRAMES,
+            [&](const SegmentedRenderer::Streams &streams) {
+                assert(ofiles.size() <= streams.size());
+                const size_t numSamples = streams.empty() ? 0 : streams.front().size();
+                writeStreams(numSamples, [&streams](size_t i) { return streams[i].data(); });
+            }
+        );
+    } else {
+        const size_t blockSubframes = std::max<size_t>(1, EXPORT_BLOCK_SAMPLES / ctx->mixer.GetSamplesPerBuffer());
+        bool ended = false;
+        while (!ended) {
+            ended = ctx->m4aSoundMainBlock(blockSubframes) < blockSubframes;
+            const size_t blockSamples = ctx->masterAudioBuffer.size();
+
+            assert(ctx->players.at(playerIdx).tracks.size() >= nTracks);
 
-            int err;
-            if ((err = sf_close(ofile)) != 0)
-                Debug::print("Error: {}", sf_error_number(err));
+            writeStreams(blockSamples, [&](size_t i) {
+                if (seperate)
+                    return ctx->players.at(playerIdx).tracks.at(i).audioBuffer.data();
+                return ctx->masterAudioBuffer.data();
+            });
+            samplesRendered += blockSamples;
         }
     }
-    // if benchmark only
-    else {
-        while (true) {
-            ctx.m4aSoundMain();
-            samplesRendered += samplesPerBuffer;
-            if (ctx.SongEnded())
-                break;
-        }
+
+    if (!benchmarkOnly && !seperate)
+        writeSilence(ofiles.front(), padSecondsEnd);
+
+    for (SNDFILE *&i : ofiles) {
+        int err = sf_close(i);
+        if (err != 0)
+            Debug::print("Error: {}", sf_error_number(err));
     }
     return samplesRendered;
 }
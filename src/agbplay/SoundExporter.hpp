@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Constants.hpp"
+
 #include <cstdint>
 #include <filesystem>
 
@@ -27,7 +29,14 @@ public:
 
 private:
     void writeSilence(sf_private_tag *ofile, double seconds);
-    size_t exportSong(const std::filesystem::path &filePath, uint16_t uid);
+    size_t estimateSongCost(uint16_t uid) const;
+    size_t exportSong(const std::filesystem::path &filePath, uint16_t uid, size_t numThreads);
+
+    /* songs which loop endlessly are not estimated longer than one hour */
+    static inline const size_t COST_ESTIMATE_MAX_SUBFRAMES = 60 * 60 * AGB_FPS * INTERFRAMES;
+    /* Songs are mixed and written in blocks of about this many samples instead of one subframe at a time.
+     * This does not change the output, sequencer events still happen at the same subframe boundaries. */
+    static inline const size_t EXPORT_BLOCK_SAMPLES = 4096;
 
     const std::filesystem::path directory;
     const Settings &settings;
@@ -21,8 +21,11 @@ SoundMixer::SoundMixer(MP2KContext &ctx, uint32_t sampleRate, float masterVolume
 void SoundMixer::UpdateReverb()
 {
     for (MP2KPlayer &player : ctx.players) {
+        if (player.reverbBus)
+            player.reverbBus->SetLevel(ctx.mp2kSoundMode.rev & 0x7F);
         for (MP2KTrack &trk : player.tracks) {
-            trk.reverb->SetLevel(ctx.mp2kSoundMode.rev & 0x7F);
+            if (trk.reverb)
+                trk.reverb->SetLevel(ctx.mp2kSoundMode.rev & 0x7F);
         }
     }
 }
@@ -39,27 +42,77 @@ void SoundMixer::UpdateFixedModeRate()
         static_cast<uint8_t>(2), static_cast<uint8_t>(ctx.agbplaySoundMode.dmaBufferLen / (fixedModeRate / AGB_FPS))
     );
 
+    /* With native mix rate, reverb is applied to the mix bus like on hardware.
+     * A shared reverb is applied to the sum of the tracks after they have been resampled. */
+    nativeMixRate = ctx.agbplaySoundMode.nativeMixRate;
+    sharedReverb = ctx.agbplaySoundMode.sharedReverb;
+    const uint32_t reverbRate = nativeMixRate && !sharedReverb ? fixedModeRate : sampleRate;
+    auto makeReverb = [&]() {
+        return ReverbEffect::MakeReverb(
+            ctx.agbplaySoundMode.reverbType, ctx.mp2kSoundMode.rev & 0x7F, reverbRate, numDmaBuffers
+        );
+    };
+
     for (MP2KPlayer &player : ctx.players) {
+        if (sharedReverb)
+            player.reverbBus = makeReverb();
+        else
+            player.reverbBus.reset();
         for (MP2KTrack &trk : player.tracks) {
-            trk.reverb = ReverbEffect::MakeReverb(
-                ctx.agbplaySoundMode.reverbType, ctx.mp2kSoundMode.rev & 0x7F, sampleRate, numDmaBuffers
-            );
+            if (sharedReverb)
+                trk.reverb.reset();
+            else
+                trk.reverb = makeReverb();
+            if (nativeMixRate)
+                trk.nativeBus = std::make_unique<NativeMixBus>(
+                    fixedModeRate, sampleRate, ctx.agbplaySoundMode.resamplerPolyphase
+                );
+            else
+                trk.nativeBus.reset();
         }
     }
 }
 
 void SoundMixer::Process()
 {
-    /* 1. clear the mixing buffer before processing channels */
-    ctx.masterAudioBuffer.resize(samplesPerBuffer);
+    BeginBlock(1);
+    ProcessSubframe(0);
+    EndBlock(1);
+}
+
+void SoundMixer::BeginBlock(size_t maxSubframes)
+{
+    // the modes may have been changed live in the profile
+    if (ctx.agbplaySoundMode.nativeMixRate != nativeMixRate || ctx.agbplaySoundMode.sharedReverb != sharedReverb)
+        UpdateFixedModeRate();
+
+    /* 1. clear the mixing buffers before processing channels, tracks which stayed silent are still clear */
+    const size_t blockSamples = maxSubframes * samplesPerBuffer;
+    ctx.masterAudioBuffer.resize(blockSamples);
     std::fill(ctx.masterAudioBuffer.begin(), ctx.masterAudioBuffer.end(), sample{0.0f, 0.0f});
 
     for (MP2KPlayer &player : ctx.players) {
         for (MP2KTrack &trk : player.tracks) {
-            trk.audioBuffer.resize(samplesPerBuffer);
-            std::fill(trk.audioBuffer.begin(), trk.audioBuffer.end(), sample{0.0f, 0.0f});
+            trk.audioBuffer.resize(blockSamples);
+            if (!trk.audioBufferClear) {
+                std::fill(trk.audioBuffer.begin(), trk.audioBuffer.end(), sample{0.0f, 0.0f});
+                trk.audioBufferClear = true;
+            }
+        }
+        if (player.reverbBus) {
+            player.reverbBusBuffer.resize(blockSamples);
+            std::fill(player.reverbBusBuffer.begin(), player.reverbBusBuffer.end(), sample{0.0f, 0.0f});
         }
     }
+}
+
+void SoundMixer::ProcessSubframe(size_t subframe)
+{
+    const size_t offset = subframe * samplesPerBuffer;
+    assert(offset + samplesPerBuffer <= ctx.masterAudioBuffer.size());
+    auto trackBuffer = [&](MP2KTrack &trk) {
+        return std::span<sample>(trk.audioBuffer).subspan(offset, samplesPerBuffer);
+    };
 
     /* 2. prepare arguments for mixing */
     MixingArgs margs;
@@ -68,21 +121,38 @@ void SoundMixer::Process()
     margs.sampleRateInv = 1.0f / static_cast<float>(sampleRate);
     margs.samplesPerBufferInv = 1.0f / static_cast<float>(samplesPerBuffer);
 
+    for (MP2KPlayer &player : ctx.players) {
+        for (MP2KTrack &trk : player.tracks)
+            trk.audible = false;
+    }
+
     /* 3. mix channels which are affected by reverb (PCM only) */
     auto mixFunc = [&](auto &channels) {
-        for (auto &chn : channels)
-            chn.Process(chn.trackOrg->audioBuffer, margs);
+        for (auto &chn : channels) {
+            chn.Process(trackBuffer(*chn.trackOrg), margs);
+            chn.trackOrg->audible = true;
+        }
     };
-    mixFunc(ctx.sndChannels);
 
-    /* 4. apply reverb */
-    // TODO add player for-loop for multiple players
-    for (MP2KPlayer &player : ctx.players) {
-        for (MP2KTrack &trk : player.tracks) {
-            trk.reverb->Process(trk.audioBuffer);
+    if (nativeMixRate) {
+        processNativeMix(margs, offset, false);
+    } else {
+        mixFunc(ctx.sndChannels);
+
+        /* 4. apply reverb, unless there is neither input nor a tail */
+        for (MP2KPlayer &player : ctx.players) {
+            for (MP2KTrack &trk : player.tracks) {
+                if (!trk.reverb || (!trk.audible && trk.reverb->IsSilent()))
+                    continue;
+                trk.reverb->Process(trackBuffer(trk));
+                trk.audible = true;
+            }
         }
     }
 
+    if (sharedReverb)
+        processSharedReverb(offset);
+
     /* 5. mix channels which are not affected by reverb (CGB) */
     mixFunc(ctx.sq1Channels);
     mixFunc(ctx.sq2Channels);
@@ -97,8 +167,16 @@ void SoundMixer::Process()
     ctx.waveChannels.remove_if(removeFunc);
     ctx.noiseChannels.remove_if(removeFunc);
 
+    for (MP2KPlayer &player : ctx.players) {
+        for (MP2KTrack &trk : player.tracks)
+            trk.audioBufferClear &= !trk.audible;
+    }
+
     /* 7. apply fadeout if active */
     // TODO move this to FadeOutMain
+    if (fadeMicroframesLeft == 0 && masterVolume == 1.0f)
+        return;
+
     float masterFrom = masterVolume;
     float masterTo = masterVolume;
     if (fadeMicroframesLeft > 0) {
@@ -118,21 +196,28 @@ void SoundMixer::Process()
 
     for (MP2KPlayer &player : ctx.players) {
         for (MP2KTrack &trk : player.tracks) {
-            const float masterStep = (masterTo - masterFrom) * margs.samplesPerBufferInv;
-            float masterLevel = masterFrom;
-            for (size_t i = 0; i < samplesPerBuffer; i++) {
-                trk.audioBuffer[i].left *= masterLevel;
-                trk.audioBuffer[i].right *= masterLevel;
-
-                masterLevel += masterStep;
-            }
+            if (trk.audible)
+                applyFade(trackBuffer(trk), masterFrom, masterTo);
+        }
+        if (player.reverbBus) {
+            const std::span<sample> busBuffer = player.reverbBusBuffer;
+            applyFade(busBuffer.subspan(offset, samplesPerBuffer), masterFrom, masterTo);
         }
     }
+}
+
+void SoundMixer::EndBlock(size_t subframes)
+{
+    /* the block may end early, e.g. if the song ended */
+    const size_t blockSamples = subframes * samplesPerBuffer;
+    assert(blockSamples <= ctx.masterAudioBuffer.size());
+    ctx.masterAudioBuffer.resize(blockSamples);
 
     /* 8. master mixdown */
     for (MP2KPlayer &player : ctx.players) {
         for (MP2KTrack &trk : player.tracks) {
-            if (trk.muted)
+            trk.audioBuffer.resize(blockSamples);
+            if (trk.muted || trk.audioBufferClear)
                 continue;
 
             assert(ctx.masterAudioBuffer.size() == trk.audioBuffer.size());
@@ -141,6 +226,97 @@ void SoundMixer::Process()
                 ctx.masterAudioBuffer[i].right += trk.audioBuffer[i].right;
             }
         }
+
+        if (player.reverbBus) {
+            player.reverbBusBuffer.resize(blockSamples);
+            for (size_t i = 0; i < ctx.masterAudioBuffer.size(); i++) {
+                ctx.masterAudioBuffer[i].left += player.reverbBusBuffer[i].left;
+                ctx.masterAudioBuffer[i].right += player.reverbBusBuffer[i].right;
+            }
+        }
+    }
+}
+
+void SoundMixer::ProcessDry()
+{
+    /* Same as Process, but without producing any audio. Channels still step their envelopes
+     * (empty buffers are skipped after that), so note lengths and CGB polyphony behave like
+     * during playback. PCM samples which aren't looped do not end early though, since
+     * the sample position isn't advanced (ProcessSkip does that). */
+    MixingArgs margs;
+    margs.vol = static_cast<float>((ctx.mp2kSoundMode.vol + 1) / 16.0f);
+    margs.fixedModeRate = fixedModeRate;
+    margs.sampleRateInv = 1.0f / static_cast<float>(sampleRate);
+    margs.samplesPerBufferInv = 1.0f / static_cast<float>(samplesPerBuffer);
+
+    auto stepFunc = [&](auto &channels) {
+        for (auto &chn : channels)
+            chn.Process({}, margs);
+    };
+    stepFunc(ctx.sndChannels);
+    stepFunc(ctx.sq1Channels);
+    stepFunc(ctx.sq2Channels);
+    stepFunc(ctx.waveChannels);
+    stepFunc(ctx.noiseChannels);
+
+    auto removeFunc = [](const auto &chn) { return chn.envState == EnvState::DEAD; };
+    ctx.sndChannels.remove_if(removeFunc);
+    ctx.sq1Channels.remove_if(removeFunc);
+    ctx.sq2Channels.remove_if(removeFunc);
+    ctx.waveChannels.remove_if(removeFunc);
+    ctx.noiseChannels.remove_if(removeFunc);
+
+    if (fadeMicroframesLeft > 0) {
+        fadePos += fadeStepPerMicroframe;
+        fadeMicroframesLeft--;
+    }
+}
+
+void SoundMixer::ProcessSkip()
+{
+    /* Same as Process, but channels are only advanced by the samples they would have produced (Skip), without
+     * resampling or mixing them. They end up in exactly the same state as after Process.
+     * Reverbs don't get any input though, except for the fixed mode rate buses of the native mix rate mode,
+     * which are mixed as usual since that is cheap. Only their conversion to the output rate is skipped. */
+    if (ctx.agbplaySoundMode.nativeMixRate != nativeMixRate || ctx.agbplaySoundMode.sharedReverb != sharedReverb)
+        UpdateFixedModeRate();
+
+    MixingArgs margs;
+    margs.vol = static_cast<float>((ctx.mp2kSoundMode.vol + 1) / 16.0f);
+    margs.fixedModeRate = fixedModeRate;
+    margs.sampleRateInv = 1.0f / static_cast<float>(sampleRate);
+    margs.samplesPerBufferInv = 1.0f / static_cast<float>(samplesPerBuffer);
+
+    auto skipFunc = [&](auto &channels) {
+        for (auto &chn : channels)
+            chn.Skip(samplesPerBuffer, margs);
+    };
+
+    if (nativeMixRate) {
+        for (MP2KPlayer &player : ctx.players) {
+            for (MP2KTrack &trk : player.tracks)
+                trk.audible = false;
+        }
+        processNativeMix(margs, 0, true);
+    } else {
+        skipFunc(ctx.sndChannels);
+    }
+
+    skipFunc(ctx.sq1Channels);
+    skipFunc(ctx.sq2Channels);
+    skipFunc(ctx.waveChannels);
+    skipFunc(ctx.noiseChannels);
+
+    auto removeFunc = [](const auto &chn) { return chn.envState == EnvState::DEAD; };
+    ctx.sndChannels.remove_if(removeFunc);
+    ctx.sq1Channels.remove_if(removeFunc);
+    ctx.sq2Channels.remove_if(removeFunc);
+    ctx.waveChannels.remove_if(removeFunc);
+    ctx.noiseChannels.remove_if(removeFunc);
+
+    if (fadeMicroframesLeft > 0) {
+        fadePos += fadeStepPerMicroframe;
+        fadeMicroframesLeft--;
     }
 }
 
@@ -173,3 +349,105 @@ bool SoundMixer::IsFadeDone() const
 {
     return fadeMicroframesLeft == 0;
 }
+
+SoundMixer::FadeState SoundMixer::GetFadeState() const
+{
+    return FadeState{fadePos, fadeStepPerMicroframe, fadeMicroframesLeft};
+}
+
+void SoundMixer::SetFadeState(const FadeState &fadeState)
+{
+    fadePos = fadeState.fadePos;
+    fadeStepPerMicroframe = fadeState.fadeStepPerMicroframe;
+    fadeMicroframesLeft = fadeState.fadeMicroframesLeft;
+}
+
+void SoundMixer::SetSampleBankEnabled(bool enabled)
+{
+    sampleBankEnabled = enabled;
+}
+
+bool SoundMixer::IsSampleBankEnabled() const
+{
+    return sampleBankEnabled;
+}
+
+/*
+ * private SoundMixer
+ */
+
+void SoundMixer::processNativeMix(const MixingArgs &margs, size_t offset, bool skip)
+{
+    /* Steps 3. and 4. of Process at the fixed mode rate. All buses advance in lockstep,
+     * but the number of samples is taken from each channel's own bus anyway.
+     * If skip is set, the buses are mixed but their output is skipped (see ProcessSkip). */
+    for (MP2KPlayer &player : ctx.players) {
+        for (MP2KTrack &trk : player.tracks)
+            trk.nativeBus->Prepare(samplesPerBuffer);
+    }
+
+    MixingArgs nativeArgs = margs;
+    nativeArgs.sampleRateInv = 1.0f / static_cast<float>(fixedModeRate);
+    for (MP2KChnPCM &chn : ctx.sndChannels) {
+        const std::span<sample> mixBuffer = chn.trackOrg->nativeBus->GetMixBuffer();
+        nativeArgs.samplesPerBufferInv = 1.0f / static_cast<float>(mixBuffer.size());
+        scratchBuffer.resize(mixBuffer.size());
+        chn.Process(mixBuffer, nativeArgs);
+        chn.trackOrg->audible = true;
+    }
+    scratchBuffer.resize(samplesPerBuffer);
+
+    for (MP2KPlayer &player : ctx.players) {
+        for (MP2KTrack &trk : player.tracks) {
+            if (trk.reverb && (trk.audible || !trk.reverb->IsSilent()))
+                trk.reverb->Process(trk.nativeBus->GetMixBuffer());
+            // the bus itself knows best whether it is still ringing out
+            if (skip)
+                trk.audible = trk.nativeBus->Skip(samplesPerBuffer);
+            else
+                trk.audible =
+                    trk.nativeBus->Resample(std::span<sample>(trk.audioBuffer).subspan(offset, samplesPerBuffer));
+        }
+    }
+}
+
+void SoundMixer::processSharedReverb(size_t offset)
+{
+    /* Reverb is linear, so one reverb for the sum of all tracks sounds the same as one reverb per track.
+     * Only the difference the reverb makes is kept, the tracks themselves stay dry. */
+    for (MP2KPlayer &player : ctx.players) {
+        const std::span<sample> busBuffer = std::span<sample>(player.reverbBusBuffer).subspan(offset, samplesPerBuffer);
+        bool input = false;
+        for (MP2KTrack &trk : player.tracks) {
+            if (!trk.audible || trk.muted)
+                continue;
+            for (size_t i = 0; i < samplesPerBuffer; i++) {
+                busBuffer[i].left += trk.audioBuffer[offset + i].left;
+                busBuffer[i].right += trk.audioBuffer[offset + i].right;
+            }
+            input = true;
+        }
+
+        if (!input && player.reverbBus->IsSilent())
+            continue;
+
+        reverbDryBuffer.assign(busBuffer.begin(), busBuffer.end());
+        player.reverbBus->Process(busBuffer);
+        for (size_t i = 0; i < samplesPerBuffer; i++) {
+            busBuffer[i].left -= reverbDryBuffer[i].left;
+            busBuffer[i].right -= reverbDryBuffer[i].right;
+        }
+    }
+}
+
+void SoundMixer::applyFade(std::span<sample> buffer, float masterFrom, float masterTo) const
+{
+    const float masterStep = (masterTo - masterFrom) * (1.0f / static_cast<float>(buffer.size()));
+    float masterLevel = masterFrom;
+    for (size_t i = 0; i < buffer.size(); i++) {
+        buffer[i].left *= masterLevel;
+        buffer[i].right *= masterLevel;
+
+        masterLevel += masterStep;
+    }
+}
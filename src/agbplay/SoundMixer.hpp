@@ -1,12 +1,16 @@
 #pragma once
 
+#include "BlepSynth.hpp"
 #include "Constants.hpp"
+#include "NativeMixBus.hpp"
 #include "ReverbEffect.hpp"
+#include "Types.hpp"
 
 #include <bitset>
 #include <cstdint>
 #include <list>
 #include <memory>
+#include <span>
 #include <vector>
 
 struct MP2KContext;
@@ -18,21 +22,48 @@ public:
     SoundMixer(const SoundMixer &) = delete;
     SoundMixer &operator=(const SoundMixer &) = delete;
 
+    /* copied for snapshots (see MP2KSnapshot) */
+    struct FadeState
+    {
+        float fadePos = 1.0f;
+        float fadeStepPerMicroframe = 0.0f;
+        size_t fadeMicroframesLeft = 0;
+    };
+
     void UpdateReverb();
     void UpdateFixedModeRate();
 
     void Process();
+    /* Process split up, so that multiple subframes can be mixed into one larger block.
+     * Buffers are prepared for maxSubframes, EndBlock shrinks them to the subframes actually processed. */
+    void BeginBlock(size_t maxSubframes);
+    void ProcessSubframe(size_t subframe);
+    void EndBlock(size_t subframes);
+    void ProcessDry();
+    void ProcessSkip();
     size_t GetSamplesPerBuffer() const;
     void ResetFade();
     void StartFadeOut(float millis);
     void StartFadeIn(float millis);
     bool IsFadeDone() const;
+    FadeState GetFadeState() const;
+    void SetFadeState(const FadeState &fadeState);
+    void SetSampleBankEnabled(bool enabled);
+    bool IsSampleBankEnabled() const;
 
 private:
+    void processNativeMix(const MixingArgs &margs, size_t offset, bool skip);
+    void processSharedReverb(size_t offset);
+    void applyFade(std::span<sample> buffer, float masterFrom, float masterTo) const;
+
     MP2KContext &ctx;
 
     const uint32_t sampleRate;
     uint32_t fixedModeRate = 13379;
+    // AgbplaySoundMode::nativeMixRate as it was when reverbs and mix buses were created
+    bool nativeMixRate = false;
+    // AgbplaySoundMode::sharedReverb, same as above
+    bool sharedReverb = false;
     const size_t samplesPerBuffer = sampleRate / (AGB_FPS * INTERFRAMES);
 
     // volume control related stuff
@@ -42,6 +73,14 @@ private:
     float fadeStepPerMicroframe = 0.0f;
     size_t fadeMicroframesLeft = 0;
 
+    // PCM samples are converted to float once and resampled without copying (see DecodedSampleCache)
+    bool sampleBankEnabled = true;
+
+    // input of the shared reverbs, to separate what they add
+    std::vector<sample> reverbDryBuffer;
+
 public:
     std::vector<float> scratchBuffer;
+    // steps of the noise channel currently being mixed
+    std::vector<BlepSynth::Step> stepBuffer;
 };
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/* TripleBuffer passes the latest value of T from one producer thread to one consumer thread without locks.
+ * The producer writes into its own buffer and publishes it by swapping it with the middle buffer.
+ * The consumer swaps its own buffer with the middle buffer if a new one was published. Neither side ever
+ * waits for the other one, and values which were not picked up in time are simply replaced.
+ *
+ * Buffers are reused, so if T contains containers, they only allocate until they have reached their
+ * final size. The producer must overwrite all of the write buffer, it still contains an older value. */
+
+template<typename T> class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer &) = delete;
+    TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+    /* Sets all buffers, e.g. to preallocate them. Must not be called while producer or consumer are running. */
+    void Reset(const T &value)
+    {
+        buffers.fill(value);
+        writeIdx = 0;
+        middle.store(1, std::memory_order_relaxed);
+        readIdx = 2;
+    }
+
+    /* producer side */
+    T &GetWriteBuffer() { return buffers[writeIdx]; }
+
+    void Publish() { writeIdx = middle.exchange(writeIdx | NEW_FLAG, std::memory_order_acq_rel) & INDEX_MASK; }
+
+    /* consumer side, returns true if a new value was published since the last call */
+    bool Update()
+    {
+        if ((middle.load(std::memory_order_relaxed) & NEW_FLAG) == 0)
+            return false;
+        readIdx = middle.exchange(readIdx, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    const T &GetReadBuffer() const { return buffers[readIdx]; }
+
+private:
+    static inline const uint8_t INDEX_MASK = 0x3;
+    static inline const uint8_t NEW_FLAG = 0x4;
+
+    std::array<T, 3> buffers;
+    uint8_t writeIdx = 0;
+    /* index of the middle buffer, NEW_FLAG is set if the consumer has not taken it yet */
+    std::atomic<uint8_t> middle = 1;
+    uint8_t readIdx = 2;
+};
@@ -60,6 +60,24 @@ std::string res2str(ResamplerType t)
     return "linear";
 }
 
+ResamplerPolyphase str2polyphase(const std::string &str)
+{
+    if (str == "nearest")
+        return ResamplerPolyphase::NEAREST;
+    else if (str == "linear")
+        return ResamplerPolyphase::LINEAR;
+    return ResamplerPolyphase::OFF;
+}
+
+std::string polyphase2str(ResamplerPolyphase t)
+{
+    if (t == ResamplerPolyphase::NEAREST)
+        return "nearest";
+    else if (t == ResamplerPolyphase::LINEAR)
+        return "linear";
+    return "off";
+}
+
 CGBPolyphony str2cgbPoly(const std::string &str)
 {
     if (str == "mono-strict")
@@ -12,6 +12,11 @@ enum class EnvState : int { INIT = 0, ATK, DEC, SUS, REL, PSEUDO_ECHO, DIE, DEAD
 enum class NoisePatt : int { FINE = 0, ROUGH };
 enum class ReverbType : int { NORMAL, GS1, GS2, MGAT, TEST, NONE };
 enum class ResamplerType : int { NEAREST, LINEAR, SINC, BLEP, BLAMP };
+/* How the sinc/BLEP/BLAMP resamplers obtain their filter kernel:
+ * OFF evaluates it from the function LUTs for every tap of every output sample,
+ * NEAREST and LINEAR read it from a bank precalculated for a fixed number of fractional phases,
+ * either from the nearest phase or linearly interpolated between the two neighbouring phases. */
+enum class ResamplerPolyphase : int { OFF, NEAREST, LINEAR };
 enum class CGBPolyphony { MONO_STRICT, MONO_SMOOTH, POLY };
 
 enum class VoiceFlags : int {
@@ -39,6 +44,8 @@ ReverbType str2rev(const std::string &str);
 std::string rev2str(ReverbType t);
 ResamplerType str2res(const std::string &str);
 std::string res2str(ResamplerType t);
+ResamplerPolyphase str2polyphase(const std::string &str);
+std::string polyphase2str(ResamplerPolyphase t);
 CGBPolyphony str2cgbPoly(const std::string &str);
 std::string cgbPoly2str(CGBPolyphony t);
 
@@ -110,6 +117,8 @@ struct AgbplaySoundMode
 {
     ResamplerType resamplerTypeNormal = ResamplerType::BLAMP;
     ResamplerType resamplerTypeFixed = ResamplerType::BLEP;
+    /* Precalculated filter banks for the sinc/BLEP/BLAMP resamplers. Faster, but the output differs slightly. */
+    ResamplerPolyphase resamplerPolyphase = ResamplerPolyphase::OFF;
     ReverbType reverbType = ReverbType::NORMAL;
     CGBPolyphony cgbPolyphony = CGBPolyphony::MONO_STRICT;
     uint32_t dmaBufferLen = 0x630;
@@ -118,6 +127,13 @@ struct AgbplaySoundMode
     bool accurateCh3Volume = true;
     bool emulateCgbSustainBug =
         true;    // other places may call this 'simulate', should probably use 'emulate' everywhere
+    /* Mix PCM channels at the fixed mode rate with linear interpolation like the hardware does (including reverb)
+     * and resample each track only once to the output rate. Much cheaper for songs with many PCM channels.
+     * PSG channels are not mixed at the fixed mode rate on hardware, so they are rendered as usual. */
+    bool nativeMixRate = false;
+    /* Use one reverb per player for the sum of its tracks instead of one per track, like the sound engine does.
+     * Muted tracks leave the reverb, but their tail is not cut off. Not used for exports of separate tracks. */
+    bool sharedReverb = false;
 };
 
 struct SongTableInfo
@@ -147,6 +163,16 @@ struct SongInfo
     uint8_t playerIdx;
 };
 
+/* Result of MP2KContext::AnalyzeSong. All positions are in subframes,
+ * i.e. 1 / (AGB_FPS * INTERFRAMES) seconds. */
+struct SongAnalysis
+{
+    size_t endSubframe = 0;       // sequence end, this is where the fade out or finish starts
+    size_t totalSubframes = 0;    // including fade out, equals the number of buffers rendered by export
+    uint8_t numLoops = 0;         // how often track 0 jumped back to the loop start
+    bool ended = false;           // false if the song did not end within the analysis limit
+};
+
 struct sample
 {
     float left;
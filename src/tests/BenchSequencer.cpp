@@ -0,0 +1,218 @@
+#include "Debug.hpp"
+#include "MP2KContext.hpp"
+#include "MP2KScanner.hpp"
+#include "ProfileManager.hpp"
+#include "Rom.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fmt/core.h>
+#include <map>
+#include <vector>
+
+/* Measures the sequencer only path, i.e. SequenceReader without any mixing (see MP2KContext::m4aSoundMainDry),
+ * with and without the event cache.
+ * Before that, the pieces the sequencer is built from are compared against what they replaced:
+ * the note and delay length tables (std::map vs. constexpr array) and header reads (Rom::ReadU8/ReadU32, which
+ * check every read, vs. a RomSpan, which is checked once). */
+
+const size_t SUBFRAMES_PER_SONG = 60 * 60 * 4;
+const size_t LOOKUPS = 64 * 1024 * 1024;
+const size_t HEADER_SIZE = 12;
+const size_t HEADER_READS = 16 * 1024 * 1024;
+
+/* keeps the compiler from dropping the measured loops */
+static volatile uint32_t sink;
+
+template<typename F> static double measureSeconds(F &&func)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    func();
+    const auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(endTime - startTime).count();
+}
+
+static void printResult(const char *name, size_t count, const char *unit, double seconds)
+{
+    fmt::print("{:<24} {} {} in {:.3f} s, {:.1f} ns each\n", name, count, unit, seconds, seconds * 1e9 / double(count));
+}
+
+/*
+ * Length tables
+ */
+
+/* the tables as SequenceReader used to have them */
+static const std::map<uint8_t, uint8_t> mapDelayLut = {
+    {0x80, 0},  {0x81, 1},  {0x82, 2},  {0x83, 3},  {0x84, 4},  {0x85, 5},  {0x86, 6},  {0x87, 7},  {0x88, 8},
+    {0x89, 9},  {0x8A, 10}, {0x8B, 11}, {0x8C, 12}, {0x8D, 13}, {0x8E, 14}, {0x8F, 15}, {0x90, 16}, {0x91, 17},
+    {0x92, 18}, {0x93, 19}, {0x94, 20}, {0x95, 21}, {0x96, 22}, {0x97, 23}, {0x98, 24}, {0x99, 28}, {0x9A, 30},
+    {0x9B, 32}, {0x9C, 36}, {0x9D, 40}, {0x9E, 42}, {0x9F, 44}, {0xA0, 48}, {0xA1, 52}, {0xA2, 54}, {0xA3, 56},
+    {0xA4, 60}, {0xA5, 64}, {0xA6, 66}, {0xA7, 68}, {0xA8, 72}, {0xA9, 76}, {0xAA, 78}, {0xAB, 80}, {0xAC, 84},
+    {0xAD, 88}, {0xAE, 90}, {0xAF, 92}, {0xB0, 96}
+};
+
+/* built the same way as in SequenceReader.cpp */
+static constexpr std::array<uint8_t, 256> makeDelayLut()
+{
+    constexpr std::array<uint8_t, 49> lengths = {
+        0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+        28, 30, 32, 36, 40, 42, 44, 48, 52, 54, 56, 60, 64, 66, 68, 72, 76, 78, 80, 84, 88, 90, 92, 96,
+    };
+
+    std::array<uint8_t, 256> lut{};
+    for (size_t i = 0; i < lengths.size(); i++)
+        lut[0x80 + i] = lengths[i];
+    return lut;
+}
+
+static constexpr std::array<uint8_t, 256> arrayDelayLut = makeDelayLut();
+static_assert(arrayDelayLut[0x98] == 24 && arrayDelayLut[0xB0] == 96);
+
+static void benchLengthTables()
+{
+    /* delay commands in a scrambled order, so the branch predictor can't learn the map's tree walk */
+    std::vector<uint8_t> cmds(4096);
+    uint32_t lcg = 1;
+    for (uint8_t &cmd : cmds) {
+        lcg = lcg * 1664525u + 1013904223u;
+        cmd = static_cast<uint8_t>(0x80 + (lcg >> 16) % 0x31);
+    }
+
+    const double mapSeconds = measureSeconds([&cmds]() {
+        uint32_t sum = 0;
+        for (size_t i = 0; i < LOOKUPS; i++)
+            sum += mapDelayLut.at(cmds[i % cmds.size()]);
+        sink = sum;
+    });
+    printResult("length table (map):", LOOKUPS, "lookups", mapSeconds);
+
+    const double arraySeconds = measureSeconds([&cmds]() {
+        uint32_t sum = 0;
+        for (size_t i = 0; i < LOOKUPS; i++)
+            sum += arrayDelayLut[cmds[i % cmds.size()]];
+        sink = sum;
+    });
+    printResult("length table (array):", LOOKUPS, "lookups", arraySeconds);
+}
+
+/*
+ * Header reads
+ */
+
+/* Reads instrument header sized records from all over the ROM, the same fields SequenceReader::GetInstrumentInfo
+ * reads. */
+static void benchHeaderReads(const Rom &rom)
+{
+    if (rom.Size() < HEADER_SIZE)
+        return;
+    const size_t numPositions = rom.Size() / HEADER_SIZE;
+
+    const double checkedSeconds = measureSeconds([&rom, numPositions]() {
+        uint32_t sum = 0;
+        for (size_t i = 0; i < HEADER_READS; i++) {
+            const size_t pos = (i % numPositions) * HEADER_SIZE;
+            sum += rom.ReadU8(pos + 0x0);
+            sum += rom.ReadU8(pos + 0x3);
+            sum += rom.ReadU32(pos + 0x4);
+            sum += rom.ReadU8(pos + 0x8);
+            sum += rom.ReadU8(pos + 0x9);
+            sum += rom.ReadU8(pos + 0xA);
+            sum += rom.ReadU8(pos + 0xB);
+        }
+        sink = sum;
+    });
+    printResult("header (Rom::Read):", HEADER_READS, "headers", checkedSeconds);
+
+    const double spanSeconds = measureSeconds([&rom, numPositions]() {
+        uint32_t sum = 0;
+        for (size_t i = 0; i < HEADER_READS; i++) {
+            const RomSpan header = rom.GetSpan((i % numPositions) * HEADER_SIZE, HEADER_SIZE);
+            sum += header.ReadU8(0x0);
+            sum += header.ReadU8(0x3);
+            sum += header.ReadU32(0x4);
+            sum += header.ReadU8(0x8);
+            sum += header.ReadU8(0x9);
+            sum += header.ReadU8(0xA);
+            sum += header.ReadU8(0xB);
+        }
+        sink = sum;
+    });
+    printResult("header (RomSpan):", HEADER_READS, "headers", spanSeconds);
+}
+
+/*
+ * Sequencer
+ */
+
+static double runSequencer(MP2KContext &ctx, uint16_t songCount, size_t &subframes)
+{
+    return measureSeconds([&ctx, songCount, &subframes]() {
+        for (uint16_t songId = 0; songId < songCount; songId++) {
+            ctx.m4aMPlayAllStop();
+            ctx.m4aSongNumStart(songId);
+            for (size_t i = 0; i < SUBFRAMES_PER_SONG; i++)
+                ctx.m4aSoundMainDry();
+            subframes += SUBFRAMES_PER_SONG;
+        }
+    });
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        fmt::print("Usage: {} <ROM.gba>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Debug::open(nullptr);
+    Rom::CreateInstance(argv[1]);
+
+    benchLengthTables();
+    benchHeaderReads(Rom::Instance());
+
+    const auto scanStartTime = std::chrono::steady_clock::now();
+    MP2KScanner scanner(Rom::Instance());
+    auto scanResults = scanner.Scan();
+    const auto scanEndTime = std::chrono::steady_clock::now();
+    fmt::print(
+        "scan: {:.1f} ms, {} result(s)\n",
+        std::chrono::duration<double, std::milli>(scanEndTime - scanStartTime).count(),
+        scanResults.size()
+    );
+
+    ProfileManager pm;
+    pm.LoadProfiles();
+    auto profiles = pm.GetProfiles(Rom::Instance(), scanResults);
+    if (profiles.size() == 0) {
+        fmt::print("No profile found\n");
+        return EXIT_FAILURE;
+    }
+    const Profile &profile = *profiles.at(0);
+
+    for (const bool eventCache : {false, true}) {
+        MP2KContext ctx(
+            48000,
+            Rom::Instance(),
+            profile.mp2kSoundModePlayback,
+            profile.agbplaySoundMode,
+            profile.songTableInfoPlayback,
+            profile.playerTablePlayback
+        );
+        ctx.reader.SetEventCacheEnabled(eventCache);
+
+        size_t subframes = 0;
+        const double seconds = runSequencer(ctx, profile.songTableInfoPlayback.count, subframes);
+        fmt::print(
+            "{:<12} {} subframes in {:.3f} s, {:.0f} subframes per second\n",
+            eventCache ? "event cache:" : "interpreter:",
+            subframes,
+            seconds,
+            static_cast<double>(subframes) / seconds
+        );
+    }
+
+    Debug::close();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,306 @@
+#include "Debug.hpp"
+#include "MP2KContext.hpp"
+#include "MP2KTrack.hpp"
+#include "Resampler.hpp"
+#include "Rom.hpp"
+#include "SyntheticRom.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fmt/core.h>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* Measures the cost of a single voice in ns per output sample.
+ * Resamplers are measured standalone for all types and a few pitch ratios, in each SIMD variant the CPU supports
+ * and each polyphase mode ("<simd>/<polyphase>").
+ * Channels are measured with sample data from a synthetic ROM, including envelope, volume and mixing.
+ * Sampled instruments are measured with and without the sample bank ("+bank").
+ *
+ * Usage: bench-voices [--json]
+ * With --json the results are printed as JSON array, which is meant to be compared between builds. */
+
+const uint32_t SAMPLERATE = 48000;
+const size_t BUFFER_SIZE = SAMPLERATE / (AGB_FPS * INTERFRAMES);
+const size_t SAMPLES_PER_RUN = SAMPLERATE * 10;
+const std::vector<float> PHASE_INCS{0.25f, 0.5f, 1.0f, 2.0f, 4.0f};
+const std::vector<uint8_t> CHANNEL_KEYS{36, 60, 84};
+
+struct Result
+{
+    std::string group;
+    std::string name;
+    std::string variant;
+    float param;
+    double nsPerSample;
+};
+
+template<typename F> static double measureNsPerSample(F &&processBuffer)
+{
+    // warm up caches and resampler state before measuring
+    for (size_t i = 0; i < 16; i++)
+        processBuffer();
+
+    const auto startTime = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < SAMPLES_PER_RUN; i += BUFFER_SIZE)
+        processBuffer();
+    const auto endTime = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(endTime - startTime).count() / double(SAMPLES_PER_RUN);
+}
+
+/*
+ * Resamplers
+ */
+
+static void benchResampler(
+    std::vector<Result> &results, const std::string &name, const std::string &variant, Resampler &rs
+)
+{
+    /* one period of a sawtooth, so the source itself is cheap */
+    std::vector<float> saw(256);
+    for (size_t i = 0; i < saw.size(); i++)
+        saw[i] = float(i) / float(saw.size()) * 2.0f - 1.0f;
+
+    std::vector<float> buffer(BUFFER_SIZE);
+
+    for (const float phaseInc : PHASE_INCS) {
+        size_t sawPos = 0;
+        rs.Reset();
+        auto source = [&](std::vector<float> &fetchBuffer, size_t samplesRequired) {
+            while (fetchBuffer.size() < samplesRequired) {
+                fetchBuffer.push_back(saw[sawPos]);
+                sawPos = (sawPos + 1) % saw.size();
+            }
+            return true;
+        };
+        const double ns = measureNsPerSample([&]() { rs.Process(buffer, phaseInc, source); });
+        results.push_back({"resampler", name, variant, phaseInc, ns});
+    }
+}
+
+static void benchResamplers(std::vector<Result> &results)
+{
+    NearestResampler nearest;
+    benchResampler(results, "NEAREST", "scalar", nearest);
+    LinearResampler linear;
+    benchResampler(results, "LINEAR", "scalar", linear);
+
+    for (const ResamplerSimd simd : {
+             ResamplerSimd::SCALAR,
+             ResamplerSimd::SSE41,
+             ResamplerSimd::NEON,
+             ResamplerSimd::AVX2,
+             ResamplerSimd::AVX512,
+         }) {
+        if (!Resampler::IsSimdSupported(simd))
+            continue;
+        for (const ResamplerPolyphase polyphase : {
+                 ResamplerPolyphase::OFF,
+                 ResamplerPolyphase::NEAREST,
+                 ResamplerPolyphase::LINEAR,
+             }) {
+            const std::string variant =
+                fmt::format("{}/{}", Resampler::GetSimdName(simd), Resampler::GetPolyphaseName(polyphase));
+            for (const auto &[name, t] : {
+                     std::pair{"SINC", ResamplerType::SINC},
+                     std::pair{"BLEP", ResamplerType::BLEP},
+                     std::pair{"BLAMP", ResamplerType::BLAMP},
+                 })
+                benchResampler(results, name, variant, *Resampler::MakeResampler(t, simd, polyphase));
+        }
+    }
+}
+
+/*
+ * Channels
+ */
+
+static SampleInfo makeSampleInfo(const Rom &rom, size_t samplePos)
+{
+    SampleInfo sInfo;
+    sInfo.gamefreakCompressed = rom.ReadU8(samplePos + 0x0) == 1;
+    sInfo.loopEnabled = rom.ReadU8(samplePos + 0x3) & 0xC0;
+    sInfo.midCfreq = static_cast<float>(rom.ReadU32(samplePos + 0x4)) / 1024.0f;
+    sInfo.loopPos = rom.ReadU32(samplePos + 0x8);
+    sInfo.endPos = rom.ReadU32(samplePos + 0xC);
+    sInfo.samplePos = samplePos;
+    sInfo.samplePtr = static_cast<const int8_t *>(rom.GetPtr(samplePos + 16));
+    return sInfo;
+}
+
+/* Runs a channel for SAMPLES_PER_RUN samples. Channels which end (e.g. unlooped samples)
+ * are restarted, so the measurement always covers one active voice. */
+template<typename Chn, typename Make>
+static void benchChannel(
+    std::vector<Result> &results, MP2KContext &ctx, const std::string &name, const std::string &variant, Make &&make
+)
+{
+    MP2KTrack trk(ctx, 0);
+    std::vector<sample> buffer(BUFFER_SIZE);
+
+    MixingArgs margs;
+    margs.vol = 1.0f;
+    margs.fixedModeRate = 13379;
+    margs.sampleRateInv = 1.0f / float(SAMPLERATE);
+    margs.samplesPerBufferInv = 1.0f / float(BUFFER_SIZE);
+
+    for (const uint8_t key : CHANNEL_KEYS) {
+        Note note{};
+        note.midiKeyTrackData = key;
+        note.midiKeyPitch = key;
+        note.velocity = 127;
+
+        std::unique_ptr<Chn> chn;
+        auto processBuffer = [&]() {
+            if (!chn || chn->envState == EnvState::DEAD) {
+                chn.reset();
+                chn = make(&trk, note);
+                chn->SetVol(127, 0);
+                chn->SetPitch(0);
+            }
+            chn->Process(buffer, margs);
+        };
+        const double ns = measureNsPerSample(processBuffer);
+        results.push_back({"channel", name, variant, float(key), ns});
+    }
+}
+
+static void benchChannels(std::vector<Result> &results)
+{
+    SyntheticRom synthRom;
+
+    std::vector<int8_t> pcm(4096);
+    for (size_t i = 0; i < pcm.size(); i++)
+        pcm[i] = static_cast<int8_t>(100.0 * std::sin(double(i) / 32.0 * 2.0 * M_PI));
+
+    const size_t pcmPos = synthRom.AddSample(pcm, true, 0, 13379);
+    const size_t dpcmPos = synthRom.AddSampleGFDPCM(pcm, true, 0, 13379);
+    const size_t adpcmPos = synthRom.AddSampleCamelotADPCM(pcm.size(), 13379, 1);
+    const size_t pwmPos = synthRom.AddSynth(0);
+    const size_t sawPos = synthRom.AddSynth(1);
+    const size_t triPos = synthRom.AddSynth(2);
+    const size_t wavePos = synthRom.AddWave(
+        {0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0xFE, 0xDC, 0xBA, 0x98, 0x76, 0x54, 0x32, 0x10}
+    );
+    std::vector<uint8_t> romData = synthRom.Finish();
+    const Rom rom = Rom::LoadFromBufferRef(romData);
+
+    MP2KSoundMode mp2kSoundMode;
+    mp2kSoundMode.vol = 15;
+    mp2kSoundMode.rev = 0;
+    mp2kSoundMode.freq = 4;
+    mp2kSoundMode.maxChannels = 12;
+    mp2kSoundMode.dacConfig = 9;
+    AgbplaySoundMode agbplaySoundMode;
+    MP2KContext ctx(SAMPLERATE, rom, mp2kSoundMode, agbplaySoundMode, SongTableInfo{}, PlayerTableInfo{});
+    ctx.mixer.scratchBuffer.resize(BUFFER_SIZE);
+
+    const ADSR env;
+
+    auto benchPCM = [&](const std::string &name, size_t samplePos) {
+        for (const ResamplerType t : {ResamplerType::NEAREST, ResamplerType::BLAMP}) {
+            for (const bool sampleBank : {false, true}) {
+                ctx.agbplaySoundMode.resamplerTypeNormal = t;
+                ctx.mixer.SetSampleBankEnabled(sampleBank);
+                benchChannel<MP2KChnPCM>(
+                    results,
+                    ctx,
+                    name,
+                    fmt::format("{}{}", t == ResamplerType::NEAREST ? "nearest" : "blamp", sampleBank ? "+bank" : ""),
+                    [&](MP2KTrack *trk, const Note &note) {
+                        return std::make_unique<MP2KChnPCM>(
+                            ctx, trk, makeSampleInfo(rom, samplePos), env, note, false
+                        );
+                    }
+                );
+            }
+        }
+        ctx.mixer.SetSampleBankEnabled(true);
+    };
+    benchPCM("PCM", pcmPos);
+    benchPCM("DPCM_GAMEFREAK", dpcmPos);
+    benchPCM("ADPCM_CAMELOT", adpcmPos);
+
+    auto benchSynth = [&](const std::string &name, size_t samplePos) {
+        benchChannel<MP2KChnPCM>(
+            results,
+            ctx,
+            name,
+            "synth",
+            [&](MP2KTrack *trk, const Note &note) {
+                // synth instruments are detected by loop and end position being zero
+                return std::make_unique<MP2KChnPCM>(ctx, trk, makeSampleInfo(rom, samplePos), env, note, false);
+            }
+        );
+    };
+    benchSynth("SYNTH_PWM", pwmPos);
+    benchSynth("SYNTH_SAW", sawPos);
+    benchSynth("SYNTH_TRI", triPos);
+
+    benchChannel<MP2KChnPSGSquare>(
+        results,
+        ctx,
+        "PSG_SQUARE",
+        "blep",
+        [&](MP2KTrack *trk, const Note &note) {
+            return std::make_unique<MP2KChnPSGSquare>(ctx, trk, 2, env, note, uint8_t(0));
+        }
+    );
+    benchChannel<MP2KChnPSGWave>(
+        results,
+        ctx,
+        "PSG_WAVE",
+        "blep",
+        [&](MP2KTrack *trk, const Note &note) {
+            return std::make_unique<MP2KChnPSGWave>(ctx, trk, uint32_t(AGB_MAP_ROM + wavePos), env, note, true);
+        }
+    );
+    benchChannel<MP2KChnPSGNoise>(
+        results,
+        ctx,
+        "PSG_NOISE",
+        "blep",
+        [&](MP2KTrack *trk, const Note &note) {
+            return std::make_unique<MP2KChnPSGNoise>(ctx, trk, 0, env, note);
+        }
+    );
+}
+
+int main(int argc, char *argv[])
+{
+    const bool json = argc > 1 && strcmp(argv[1], "--json") == 0;
+
+    Debug::open(nullptr);
+
+    std::vector<Result> results;
+    benchResamplers(results);
+    benchChannels(results);
+
+    if (json) {
+        nlohmann::json j = nlohmann::json::array();
+        for (const Result &r : results) {
+            j.push_back({
+                {"group", r.group},
+                {"name", r.name},
+                {"variant", r.variant},
+                {"param", r.param},
+                {"ns_per_sample", r.nsPerSample},
+            });
+        }
+        fmt::print("{}\n", j.dump(2));
+    } else {
+        fmt::print("{:<10} {:<16} {:<16} {:>8} {:>12}\n", "group", "name", "variant", "param", "ns/sample");
+        for (const Result &r : results)
+            fmt::print("{:<10} {:<16} {:<16} {:>8.2f} {:>12.2f}\n", r.group, r.name, r.variant, r.param, r.nsPerSample);
+    }
+
+    Debug::close();
+    return EXIT_SUCCESS;
+}
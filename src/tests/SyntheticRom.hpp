@@ -0,0 +1,659 @@
+#pragma once
+
+#include "AgbTypes.hpp"
+#include "Util.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/* SyntheticRom builds a small GBA ROM image with MP2K songs, which is good enough
+ * to pass Rom verification and MP2KScanner. The songs cover all voice types and most
+ * sequence commands, so tests and benchmarks don't depend on commercial ROMs. */
+
+class SyntheticRom
+{
+public:
+    static inline const uint8_t PLAYER_COUNT = 4;
+
+    /* sound mode: vol=15, maxChannels=8, freq=4 (13379 Hz), dac=9 */
+    static inline const uint32_t SOUND_MODE = (9u << 20) | (4u << 16) | (15u << 12) | (8u << 8);
+
+    class Track
+    {
+    public:
+        void Wait(uint8_t ticks)
+        {
+            while (ticks > 0) {
+                /* use the largest delay command that fits */
+                uint8_t cmd = 0x80;
+                for (uint8_t c = 0x80; c <= 0xB0; c++) {
+                    if (DELAYS[c - 0x80] <= ticks)
+                        cmd = c;
+                }
+                bytes.push_back(cmd);
+                ticks = static_cast<uint8_t>(ticks - DELAYS[cmd - 0x80]);
+            }
+        }
+
+        /* lenCmd is the note length command (0xCF = TIE, 0xD0..0xFF = N1..N96) */
+        void Note(uint8_t lenCmd, uint8_t key, uint8_t vel)
+        {
+            bytes.insert(bytes.end(), {lenCmd, key, vel});
+        }
+
+        /* repeat previous note command with a new key only (running status) */
+        void NoteKey(uint8_t key)
+        {
+            bytes.push_back(key);
+        }
+
+        void Cmd(uint8_t cmd, uint8_t arg)
+        {
+            bytes.insert(bytes.end(), {cmd, arg});
+        }
+
+        void Eot(uint8_t key)
+        {
+            bytes.insert(bytes.end(), {0xCE, key});
+        }
+
+        void Memacc(uint8_t op, uint8_t addr, uint8_t data)
+        {
+            bytes.insert(bytes.end(), {0xB9, op, addr, data});
+        }
+
+        void MemaccJump(uint8_t op, uint8_t addr, uint8_t data, size_t label)
+        {
+            Memacc(op, addr, data);
+            Pointer(label);
+        }
+
+        void Goto(size_t label)
+        {
+            bytes.push_back(0xB2);
+            Pointer(label);
+        }
+
+        void Patt(size_t label)
+        {
+            bytes.push_back(0xB3);
+            Pointer(label);
+        }
+
+        void Pend()
+        {
+            bytes.push_back(0xB4);
+        }
+
+        void Rept(uint8_t count, size_t label)
+        {
+            bytes.insert(bytes.end(), {0xB5, count});
+            Pointer(label);
+        }
+
+        void Bytes(std::initializer_list<uint8_t> b)
+        {
+            bytes.insert(bytes.end(), b);
+        }
+
+        void Fine()
+        {
+            bytes.push_back(0xB1);
+        }
+
+        size_t Label() const
+        {
+            return bytes.size();
+        }
+
+    private:
+        friend class SyntheticRom;
+
+        void Pointer(size_t label)
+        {
+            patches.emplace_back(bytes.size(), label);
+            bytes.insert(bytes.end(), {0, 0, 0, 0});
+        }
+
+        static inline const std::array<uint8_t, 49> DELAYS{
+            0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+            28, 30, 32, 36, 40, 42, 44, 48, 52, 54, 56, 60, 64, 66, 68, 72, 76, 78, 80, 84, 88, 90, 92, 96,
+        };
+
+        std::vector<uint8_t> bytes;
+        std::vector<std::pair<size_t, size_t>> patches;
+    };
+
+    SyntheticRom()
+    {
+        data.resize(SOUND_MODE_POOL + 0x40, 0);
+        writeHeader();
+    }
+
+    /* returns the position of the sample header */
+    size_t AddSample(const std::vector<int8_t> &pcm, bool loop, uint32_t loopPos, uint32_t midCfreq)
+    {
+        const size_t pos = alloc(16 + pcm.size());
+        writeU32(pos + 0, loop ? 0x40000000 : 0);
+        writeU32(pos + 4, midCfreq * 1024);
+        writeU32(pos + 8, loopPos);
+        writeU32(pos + 12, static_cast<uint32_t>(pcm.size()));
+        std::memcpy(&data[pos + 16], pcm.data(), pcm.size());
+        return pos;
+    }
+
+    /* Game Freak DPCM: blocks of 64 samples with 0x21 bytes each */
+    size_t AddSampleGFDPCM(const std::vector<int8_t> &pcm, bool loop, uint32_t loopPos, uint32_t midCfreq)
+    {
+        static const std::array<int8_t, 16> deltaTable{0, 1, 4, 9, 16, 25, 36, 49, -64, -49, -36, -25, -16, -9, -4, -1};
+        const size_t numBlocks = (pcm.size() + 63) / 64;
+        const size_t pos = alloc(16 + numBlocks * 0x21);
+        data[pos + 0] = 1;
+        data[pos + 3] = loop ? 0x40 : 0;
+        writeU32(pos + 4, midCfreq * 1024);
+        writeU32(pos + 8, loopPos);
+        writeU32(pos + 12, static_cast<uint32_t>(pcm.size()));
+
+        auto bestDelta = [&](int8_t acc, int8_t target) {
+            uint8_t best = 0;
+            int bestErr = 1000;
+            for (uint8_t d = 0; d < 16; d++) {
+                const int err = std::abs(static_cast<int8_t>(acc + deltaTable[d]) - target);
+                if (err < bestErr) {
+                    bestErr = err;
+                    best = d;
+                }
+            }
+            return best;
+        };
+
+        for (size_t b = 0; b < numBlocks; b++) {
+            auto at = [&](size_t i) { return b * 64 + i < pcm.size() ? pcm[b * 64 + i] : int8_t(0); };
+            const size_t blockPos = pos + 16 + b * 0x21;
+            int8_t acc = at(0);
+            data[blockPos] = static_cast<uint8_t>(acc);
+            uint8_t d = bestDelta(acc, at(1));
+            acc = static_cast<int8_t>(acc + deltaTable[d]);
+            data[blockPos + 1] = d;
+            for (size_t j = 2, h = 2; j < 64; j += 2, h++) {
+                const uint8_t hi = bestDelta(acc, at(j));
+                acc = static_cast<int8_t>(acc + deltaTable[hi]);
+                const uint8_t lo = bestDelta(acc, at(j + 1));
+                acc = static_cast<int8_t>(acc + deltaTable[lo]);
+                data[blockPos + h] = static_cast<uint8_t>((hi << 4) | lo);
+            }
+        }
+        return pos;
+    }
+
+    /* Camelot ADPCM: 4 bit nibbles, the length is stored negated. The nibbles are arbitrary data. */
+    size_t AddSampleCamelotADPCM(size_t numSamples, uint32_t midCfreq, uint32_t seed)
+    {
+        const size_t pos = alloc(16 + (numSamples + 1) / 2);
+        writeU32(pos + 4, midCfreq * 1024);
+        writeU32(pos + 12, static_cast<uint32_t>(-static_cast<int32_t>(numSamples)));
+        for (size_t i = 0; i < (numSamples + 1) / 2; i++) {
+            seed = seed * 1103515245u + 12345u;
+            /* keep nibbles small-ish so the decoded level stays in range */
+            const uint8_t hi = static_cast<uint8_t>((seed >> 16) % 3 + 7);
+            const uint8_t lo = static_cast<uint8_t>((seed >> 20) % 3 + 7);
+            data[pos + 16 + i] = static_cast<uint8_t>((hi << 4) | lo);
+        }
+        return pos;
+    }
+
+    /* Golden Sun synth instrument: loop and end are zero, second data byte selects the type */
+    size_t AddSynth(uint8_t synthType)
+    {
+        const size_t pos = alloc(16 + 8);
+        const std::array<uint8_t, 8> params{0, synthType, 0x40, 0x10, 0x80, 0x20, 0, 0};
+        std::memcpy(&data[pos + 16], params.data(), params.size());
+        return pos;
+    }
+
+    size_t AddWave(const std::array<uint8_t, 16> &wave)
+    {
+        const size_t pos = alloc(16);
+        std::memcpy(&data[pos], wave.data(), wave.size());
+        return pos;
+    }
+
+    /* 12 byte instrument definitions */
+    static std::array<uint8_t, 12> InstrPCM(uint8_t type, uint8_t key, uint8_t pan, size_t samplePos, uint32_t adsr)
+    {
+        return instr(type, key, pan, ptr(samplePos), adsr);
+    }
+
+    static std::array<uint8_t, 12> InstrCGB(uint8_t type, uint8_t key, uint8_t sweep, uint32_t param, uint32_t adsr)
+    {
+        return instr(type, key, sweep, param, adsr);
+    }
+
+    static std::array<uint8_t, 12> InstrSub(uint8_t type, size_t subBankPos, size_t keyMapPos)
+    {
+        return instr(type, 0, 0, ptr(subBankPos), keyMapPos ? ptr(keyMapPos) : 0);
+    }
+
+    size_t AddVoicegroup(const std::vector<std::array<uint8_t, 12>> &instruments)
+    {
+        const size_t pos = alloc(instruments.size() * 12);
+        for (size_t i = 0; i < instruments.size(); i++)
+            std::memcpy(&data[pos + i * 12], instruments[i].data(), 12);
+        return pos;
+    }
+
+    size_t AddKeyMap(const std::array<uint8_t, 128> &keyMap)
+    {
+        const size_t pos = alloc(keyMap.size());
+        std::memcpy(&data[pos], keyMap.data(), keyMap.size());
+        return pos;
+    }
+
+    size_t AddTrack(const Track &track)
+    {
+        const size_t pos = alloc(track.bytes.size());
+        std::memcpy(&data[pos], track.bytes.data(), track.bytes.size());
+        for (const auto &[offset, label] : track.patches)
+            writeU32(pos + offset, ptr(pos + label));
+        return pos;
+    }
+
+    void AddSong(uint8_t player, uint8_t prio, uint8_t rev, size_t voicegroupPos, const std::vector<size_t> &trackPoss)
+    {
+        const size_t pos = alloc(8 + trackPoss.size() * 4);
+        data[pos + 0] = static_cast<uint8_t>(trackPoss.size());
+        data[pos + 2] = prio;
+        data[pos + 3] = rev;
+        writeU32(pos + 4, ptr(voicegroupPos));
+        for (size_t i = 0; i < trackPoss.size(); i++)
+            writeU32(pos + 8 + i * 4, ptr(trackPoss[i]));
+        songs.emplace_back(pos, player);
+    }
+
+    /* Writes player table, song table and the m4aSoundInit literal pool. Call after all songs are added. */
+    std::vector<uint8_t> Finish()
+    {
+        const size_t playerTablePos = alloc(PLAYER_COUNT * 12);
+        for (size_t i = 0; i < PLAYER_COUNT; i++) {
+            writeU32(playerTablePos + i * 12 + 0, 0x03001000 + static_cast<uint32_t>(i) * 0x40);
+            writeU32(playerTablePos + i * 12 + 4, 0x03002000 + static_cast<uint32_t>(i) * 0x400);
+            data[playerTablePos + i * 12 + 8] = i == 0 ? 16 : 4;
+        }
+
+        /* song table must follow the player table directly */
+        const size_t songTablePos = alloc(songs.size() * 8);
+        for (size_t i = 0; i < songs.size(); i++) {
+            writeU32(songTablePos + i * 8, ptr(songs[i].first));
+            data[songTablePos + i * 8 + 4] = songs[i].second;
+            data[songTablePos + i * 8 + 6] = songs[i].second;
+        }
+
+        const size_t p = SOUND_MODE_POOL;
+        writeU32(p + 0, ptr(SOUND_MODE_POOL + 0x30));    // mix code ROM
+        writeU32(p + 4, 0x03000100);                     // mix code RAM
+        writeU32(p + 8, (1u << 26) | 0x100);             // CpuSet arg
+        writeU32(p + 12, 0x03007FF0);                    // SoundInfo
+        writeU32(p + 16, 0x03005000);                    // CgbChan
+        writeU32(p + 20, SOUND_MODE);
+        writeU32(p + 24, PLAYER_COUNT);
+        writeU32(p + 28, ptr(playerTablePos));
+        writeU32(p + 32, 0x03006000);    // memacc
+        writeU32(p + 36, ptr(songTablePos));
+
+        data.resize((data.size() + 0xFFF) & ~size_t(0xFFF), 0);
+        return data;
+    }
+
+    /* Complete test ROM with a fixed set of songs */
+    static std::vector<uint8_t> Build();
+
+private:
+    static inline const size_t SOUND_MODE_POOL = 0x200;
+
+    static uint32_t ptr(size_t pos)
+    {
+        return AGB_MAP_ROM + static_cast<uint32_t>(pos);
+    }
+
+    static std::array<uint8_t, 12> instr(uint8_t type, uint8_t key, uint8_t b3, uint32_t p1, uint32_t p2)
+    {
+        return {
+            type,
+            key,
+            0,
+            b3,
+            static_cast<uint8_t>(p1),
+            static_cast<uint8_t>(p1 >> 8),
+            static_cast<uint8_t>(p1 >> 16),
+            static_cast<uint8_t>(p1 >> 24),
+            static_cast<uint8_t>(p2),
+            static_cast<uint8_t>(p2 >> 8),
+            static_cast<uint8_t>(p2 >> 16),
+            static_cast<uint8_t>(p2 >> 24),
+        };
+    }
+
+    size_t alloc(size_t size)
+    {
+        const size_t pos = (data.size() + 3) & ~size_t(3);
+        data.resize(pos + size, 0);
+        return pos;
+    }
+
+    void writeU32(size_t pos, uint32_t value)
+    {
+        for (size_t i = 0; i < 4; i++)
+            data[pos + i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+
+    void writeHeader()
+    {
+        static const std::array<uint8_t, 156> logo{
+            0x24, 0xff, 0xae, 0x51, 0x69, 0x9a, 0xa2, 0x21, 0x3d, 0x84, 0x82, 0x0a, 0x84, 0xe4, 0x09, 0xad,    //
+            0x11, 0x24, 0x8b, 0x98, 0xc0, 0x81, 0x7f, 0x21, 0xa3, 0x52, 0xbe, 0x19, 0x93, 0x09, 0xce, 0x20,    //
+            0x10, 0x46, 0x4a, 0x4a, 0xf8, 0x27, 0x31, 0xec, 0x58, 0xc7, 0xe8, 0x33, 0x82, 0xe3, 0xce, 0xbf,    //
+            0x85, 0xf4, 0xdf, 0x94, 0xce, 0x4b, 0x09, 0xc1, 0x94, 0x56, 0x8a, 0xc0, 0x13, 0x72, 0xa7, 0xfc,    //
+            0x9f, 0x84, 0x4d, 0x73, 0xa3, 0xca, 0x9a, 0x61, 0x58, 0x97, 0xa3, 0x27, 0xfc, 0x03, 0x98, 0x76,    //
+            0x23, 0x1d, 0xc7, 0x61, 0x03, 0x04, 0xae, 0x56, 0xbf, 0x38, 0x84, 0x00, 0x40, 0xa7, 0x0e, 0xfd,    //
+            0xff, 0x52, 0xfe, 0x03, 0x6f, 0x95, 0x30, 0xf1, 0x97, 0xfb, 0xc0, 0x85, 0x60, 0xd6, 0x80, 0x25,    //
+            0xa9, 0x63, 0xbe, 0x03, 0x01, 0x4e, 0x38, 0xe2, 0xf9, 0xa2, 0x34, 0xff, 0xbb, 0x3e, 0x03, 0x44,    //
+            0x78, 0x00, 0x90, 0xcb, 0x88, 0x11, 0x3a, 0x94, 0x65, 0xc0, 0x7c, 0x63, 0x87, 0xf0, 0x3c, 0xaf,    //
+            0xd6, 0x25, 0xe4, 0x8b, 0x38, 0x0a, 0xac, 0x72, 0x21, 0xd4, 0xf8, 0x07                             //
+        };
+        std::memcpy(&data[0x4], logo.data(), logo.size());
+        std::memcpy(&data[0xA0], "AGBPLAYTEST", 11);
+        std::memcpy(&data[0xAC], "ATST01", 6);
+        data[0xB2] = 0x96;
+
+        int check = 0;
+        for (size_t i = 0xA0; i < 0xBD; i++)
+            check -= data[i];
+        data[0xBD] = static_cast<uint8_t>((check - 0x19) & 0xFF);
+    }
+
+    std::vector<uint8_t> data;
+    std::vector<std::pair<size_t, uint8_t>> songs;
+};
+
+inline std::vector<uint8_t> SyntheticRom::Build()
+{
+    SyntheticRom rom;
+
+    /* samples */
+    std::vector<int8_t> saw(256);
+    for (size_t i = 0; i < saw.size(); i++)
+        saw[i] = static_cast<int8_t>(static_cast<int>(i) - 128);
+
+    std::vector<int8_t> strings(4096);
+    for (size_t i = 0; i < strings.size(); i++) {
+        const double t = static_cast<double>(i) / 64.0 * 2.0 * M_PI;
+        strings[i] = static_cast<int8_t>(60.0 * std::sin(t) + 30.0 * std::sin(t * 2.01) + 15.0 * std::sin(t * 3.02));
+    }
+
+    std::vector<int8_t> drum(6000);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < drum.size(); i++) {
+        seed = seed * 1103515245u + 12345u;
+        const double env = std::exp(-static_cast<double>(i) / 900.0);
+        const double tone = std::sin(static_cast<double>(i) * 2.0 * M_PI * 60.0 / 13379.0 * (1.0 + env));
+        const double noise = static_cast<double>(static_cast<int>((seed >> 16) & 0xFF) - 128) / 128.0;
+        drum[i] = static_cast<int8_t>(std::clamp(110.0 * env * (0.7 * tone + 0.3 * noise), -127.0, 127.0));
+    }
+
+    std::vector<int8_t> bell(3000);
+    for (size_t i = 0; i < bell.size(); i++) {
+        const double t = static_cast<double>(i) / 32.0 * 2.0 * M_PI;
+        bell[i] = static_cast<int8_t>(100.0 * std::exp(-static_cast<double>(i) / 1500.0) * std::sin(t)
+                                      * std::sin(t * 0.25));
+    }
+
+    const size_t sawPos = rom.AddSample(saw, true, 0, 66974);
+    const size_t stringsPos = rom.AddSample(strings, true, 1024, 13379);
+    const size_t drumPos = rom.AddSample(drum, false, 0, 13379);
+    const size_t bellDpcmPos = rom.AddSampleGFDPCM(bell, true, 1000, 13379);
+    const size_t adpcmPos = rom.AddSampleCamelotADPCM(8000, 13379, 7);
+    const size_t pwmPos = rom.AddSynth(0);
+    const size_t sawSynthPos = rom.AddSynth(1);
+    const size_t triSynthPos = rom.AddSynth(2);
+    const size_t wavePos =
+        rom.AddWave({0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0xFE, 0xDC, 0xBA, 0x98, 0x76, 0x54, 0x32, 0x10});
+
+    /* drum kit */
+    std::vector<std::array<uint8_t, 12>> drumKit(128, InstrPCM(0x00, 60, 0, drumPos, 0x00FF00FF));
+    drumKit[36] = InstrPCM(0x00, 48, 0xC0 - 10, drumPos, 0x00FF00FF);
+    drumKit[38] = InstrCGB(0x04, 60, 0xC0 + 10, 0, 0x0000000F);
+    drumKit[42] = InstrCGB(0x0C, 60, 0, 1, 0x00000007);
+    drumKit[46] = InstrPCM(0x08, 60, 0, drumPos, 0x40FF00FF);
+    const size_t drumKitPos = rom.AddVoicegroup(drumKit);
+
+    /* key split: low keys saw, high keys bell */
+    std::vector<std::array<uint8_t, 12>> splitBank{
+        InstrPCM(0x00, 60, 0, sawPos, 0xC0F07FFF),
+        InstrPCM(0x00, 60, 0, bellDpcmPos, 0xE0FF00FF),
+    };
+    const size_t splitBankPos = rom.AddVoicegroup(splitBank);
+    std::array<uint8_t, 128> keyMap{};
+    for (size_t i = 64; i < keyMap.size(); i++)
+        keyMap[i] = 1;
+    const size_t keyMapPos = rom.AddKeyMap(keyMap);
+
+    /* ADSR is stored as att | dec << 8 | sus << 16 | rel << 24 */
+    std::vector<std::array<uint8_t, 12>> vg(128, InstrPCM(0x00, 60, 0, sawPos, 0xA0F0C0FF));
+    vg[0] = InstrPCM(0x00, 60, 0, sawPos, 0xC0E0A0FF);
+    vg[1] = InstrPCM(0x00, 60, 0, stringsPos, 0xF0FFC010);
+    vg[2] = InstrPCM(0x00, 60, 0, drumPos, 0x00FF00FF);
+    vg[3] = InstrPCM(0x00, 60, 0, bellDpcmPos, 0xE0F080FF);
+    vg[4] = InstrPCM(0x00, 60, 0, adpcmPos, 0x00FF00FF);
+    vg[5] = InstrPCM(0x08, 60, 0, stringsPos, 0xE0FF80FF);
+    vg[6] = InstrCGB(0x01, 60, 0x16, 2, 0x04020F00);
+    vg[7] = InstrCGB(0x02, 60, 0, 1, 0x0203080F);
+    vg[8] = InstrCGB(0x03, 60, 0, static_cast<uint32_t>(ptr(wavePos)), 0x0305080F);
+    vg[9] = InstrCGB(0x04, 60, 0, 0, 0x0001000F);
+    vg[10] = InstrSub(0x80, drumKitPos, 0);
+    vg[11] = InstrSub(0x40, splitBankPos, keyMapPos);
+    vg[12] = InstrPCM(0x00, 60, 0, pwmPos, 0xC0F0A0FF);
+    vg[13] = InstrPCM(0x00, 60, 0, sawSynthPos, 0xC0F0A0FF);
+    vg[14] = InstrPCM(0x00, 60, 0, triSynthPos, 0xC0F0A0FF);
+    const size_t vgPos = rom.AddVoicegroup(vg);
+
+    auto trackHeader = [](Track &t, uint8_t voice, uint8_t vol, uint8_t pan) {
+        t.Cmd(0xBD, voice);
+        t.Cmd(0xBE, vol);
+        t.Cmd(0xBF, pan);
+    };
+
+    /* Song 0: PCM ensemble with reverb, loops once */
+    {
+        std::vector<size_t> tracks;
+        const std::array<uint8_t, 4> chordRoots{48, 53, 55, 50};
+        for (uint8_t t = 0; t < 6; t++) {
+            Track trk;
+            if (t == 0)
+                trk.Cmd(0xBB, 70);
+            trackHeader(
+                trk, t < 3 ? 1 : 0, static_cast<uint8_t>(90 - t * 5), static_cast<uint8_t>(0x40 + (t - 3) * 12)
+            );
+            const size_t loop = trk.Label();
+            for (size_t bar = 0; bar < 8; bar++) {
+                const uint8_t root = chordRoots[bar % chordRoots.size()];
+                if (t < 3) {
+                    trk.Note(0xEF, static_cast<uint8_t>(root + t * 4 + 12), 100);
+                    trk.Wait(48);
+                    trk.Note(0xEF, static_cast<uint8_t>(root + t * 3 + 12), 90);
+                    trk.Wait(48);
+                } else {
+                    for (size_t n = 0; n < 8; n++) {
+                        const uint8_t key = static_cast<uint8_t>(root + 24 + ((n * (t + 2)) % 12));
+                        trk.Note(0xD8, key, static_cast<uint8_t>(70 + n * 5));
+                        trk.Wait(12);
+                    }
+                }
+            }
+            trk.Goto(loop);
+            tracks.push_back(rom.AddTrack(trk));
+        }
+        rom.AddSong(0, 10, 0x80 | 50, vgPos, tracks);
+    }
+
+    /* Song 1: PSG channels with sweep, pitch bend, LFO and noise drums */
+    {
+        std::vector<size_t> tracks;
+        Track sq1;
+        sq1.Cmd(0xBB, 75);
+        trackHeader(sq1, 6, 100, 0x30);
+        sq1.Cmd(0xC1, 12);
+        const size_t sq1Loop = sq1.Label();
+        for (size_t n = 0; n < 16; n++) {
+            sq1.Note(0xDC, static_cast<uint8_t>(60 + (n * 5) % 12), 110);
+            sq1.Wait(12);
+            sq1.Cmd(0xC0, static_cast<uint8_t>(0x40 + ((n % 4) * 8)));
+            sq1.Wait(12);
+        }
+        sq1.Cmd(0xC0, 0x40);
+        sq1.Goto(sq1Loop);
+        tracks.push_back(rom.AddTrack(sq1));
+
+        Track sq2;
+        trackHeader(sq2, 7, 90, 0x50);
+        sq2.Cmd(0xC4, 40);
+        sq2.Cmd(0xC2, 30);
+        sq2.Cmd(0xC3, 10);
+        const size_t sq2Loop = sq2.Label();
+        for (size_t n = 0; n < 8; n++) {
+            sq2.Note(0xE7, static_cast<uint8_t>(72 + (n * 7) % 12), 100);
+            sq2.Wait(48);
+        }
+        sq2.Goto(sq2Loop);
+        tracks.push_back(rom.AddTrack(sq2));
+
+        Track wave;
+        trackHeader(wave, 8, 110, 0x40);
+        wave.Cmd(0xC5, 1);
+        wave.Cmd(0xC4, 20);
+        wave.Cmd(0xC2, 40);
+        const size_t waveLoop = wave.Label();
+        for (size_t n = 0; n < 16; n++) {
+            wave.Note(0xE4, static_cast<uint8_t>(36 + (n * 3) % 12), 120);
+            wave.Wait(24);
+        }
+        wave.Goto(waveLoop);
+        tracks.push_back(rom.AddTrack(wave));
+
+        Track noise;
+        trackHeader(noise, 9, 80, 0x40);
+        const size_t noiseLoop = noise.Label();
+        for (size_t n = 0; n < 32; n++) {
+            noise.Note(0xD6, static_cast<uint8_t>(n % 4 == 0 ? 40 : 70 + (n % 3) * 8), 100);
+            noise.Wait(12);
+        }
+        noise.Goto(noiseLoop);
+        tracks.push_back(rom.AddTrack(noise));
+
+        rom.AddSong(0, 10, 0, vgPos, tracks);
+    }
+
+    /* Song 2: drum kit, key split, compressed samples, synths and control flow commands */
+    {
+        std::vector<size_t> tracks;
+
+        Track drumTrack;
+        drumTrack.Cmd(0xBB, 80);
+        trackHeader(drumTrack, 10, 110, 0x40);
+        drumTrack.Memacc(0, 0x10, 0);
+        const size_t drumLoop = drumTrack.Label();
+        drumTrack.Patt(0);    // patched below
+        drumTrack.Memacc(1, 0x10, 1);
+        drumTrack.MemaccJump(6, 0x10, 3, 0);    // patched below
+        drumTrack.Patt(0);                      // patched below
+        const size_t afterFill = drumTrack.Label();
+        drumTrack.Goto(drumLoop);
+        const size_t patternStart = drumTrack.Label();
+        for (size_t n = 0; n < 8; n++) {
+            drumTrack.Note(0xD8, n % 2 == 0 ? 36 : 38, 110);
+            drumTrack.Note(0xD4, 42, 80);
+            drumTrack.Wait(12);
+        }
+        drumTrack.Pend();
+        const size_t fillStart = drumTrack.Label();
+        drumTrack.Note(0xD4, 46, 100);
+        drumTrack.Wait(6);
+        drumTrack.NoteKey(46);
+        drumTrack.Wait(6);
+        drumTrack.Note(0xD4, 38, 120);
+        drumTrack.Wait(12);
+        drumTrack.Pend();
+        drumTrack.patches[0].second = patternStart;
+        drumTrack.patches[1].second = afterFill;
+        drumTrack.patches[2].second = fillStart;
+        tracks.push_back(rom.AddTrack(drumTrack));
+
+        Track split;
+        trackHeader(split, 11, 90, 0x28);
+        split.Cmd(0xBC, 2);
+        const size_t splitLoop = split.Label();
+        const size_t rept = split.Label();
+        for (size_t n = 0; n < 4; n++) {
+            split.Note(0xD8, static_cast<uint8_t>(52 + n * 6), 100);
+            split.Wait(12);
+        }
+        split.Rept(3, rept);
+        split.Note(0xCF, 76, 90);
+        split.Wait(36);
+        split.Eot(76);
+        split.Wait(12);
+        split.Goto(splitLoop);
+        tracks.push_back(rom.AddTrack(split));
+
+        Track compressed;
+        trackHeader(compressed, 4, 100, 0x58);
+        compressed.Cmd(0xC8, 0x48);
+        const size_t compressedLoop = compressed.Label();
+        compressed.Note(0xEF, 60, 110);
+        compressed.Wait(48);
+        compressed.Cmd(0xBD, 3);
+        compressed.Note(0xE7, 67, 100);
+        compressed.Wait(24);
+        compressed.Cmd(0xBD, 5);
+        compressed.Note(0xE7, 60, 100);
+        compressed.Wait(24);
+        compressed.Cmd(0xBD, 4);
+        compressed.Goto(compressedLoop);
+        tracks.push_back(rom.AddTrack(compressed));
+
+        Track synth;
+        trackHeader(synth, 12, 70, 0x40);
+        synth.Bytes({0xCD, 0x08, 40, 0xCD, 0x09, 6});    // XIECV, XIECL
+        const size_t synthLoop = synth.Label();
+        for (uint8_t voice = 12; voice <= 14; voice++) {
+            synth.Cmd(0xBD, voice);
+            synth.Note(0xE4, 64, 100);
+            synth.Wait(24);
+            synth.Note(0xE4, 67, 100);
+            synth.Wait(24);
+        }
+        synth.Goto(synthLoop);
+        tracks.push_back(rom.AddTrack(synth));
+
+        rom.AddSong(1, 20, 0x80 | 30, vgPos, tracks);
+    }
+
+    /* Song 3: short song which ends with FINE */
+    {
+        Track trk;
+        trk.Cmd(0xBB, 90);
+        trackHeader(trk, 0, 100, 0x40);
+        for (size_t n = 0; n < 8; n++) {
+            trk.Note(0xD8, static_cast<uint8_t>(60 + n), 100);
+            trk.Wait(12);
+        }
+        trk.Fine();
+        rom.AddSong(2, 5, 0, vgPos, {rom.AddTrack(trk)});
+    }
+
+    return rom.Finish();
+}
@@ -0,0 +1,57 @@
+#include "MPSCQueue.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fmt/core.h>
+#include <thread>
+#include <vector>
+
+/* Pushes numbered commands from several producer threads through MPSCQueue, while a consumer drains it like the
+ * mixer thread does between blocks. Every command must arrive exactly once, and the commands of each producer
+ * must arrive in the order they were pushed. */
+
+const size_t NUM_PRODUCERS = 4;
+const uint32_t COMMANDS_PER_PRODUCER = 200000;
+
+struct Command
+{
+    size_t producer;
+    uint32_t seq;
+};
+
+int main()
+{
+    MPSCQueue<Command> queue;
+
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < NUM_PRODUCERS; p++) {
+        producers.emplace_back([&queue, p]() {
+            for (uint32_t seq = 0; seq < COMMANDS_PER_PRODUCER; seq++)
+                queue.Push(Command{p, seq});
+        });
+    }
+
+    std::vector<uint32_t> nextSeq(NUM_PRODUCERS, 0);
+    size_t received = 0;
+    size_t drains = 0;
+    size_t errors = 0;
+    while (received < NUM_PRODUCERS * COMMANDS_PER_PRODUCER) {
+        queue.Drain([&](Command &&cmd) {
+            errors += cmd.seq != nextSeq.at(cmd.producer);
+            nextSeq.at(cmd.producer) = cmd.seq + 1;
+            received++;
+        });
+        drains++;
+    }
+
+    for (std::thread &producer : producers)
+        producer.join();
+
+    fmt::print("{} commands in {} drains, {} errors\n", received, drains, errors);
+    if (errors > 0) {
+        fmt::print("FAIL\n");
+        return EXIT_FAILURE;
+    }
+    fmt::print("OK\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,64 @@
+#include "LowLatencyRingbuffer.hpp"
+
+#include <cstdlib>
+#include <fmt/core.h>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+/* Streams a counting signal through LowLatencyRingbuffer from a producer to a consumer thread, with chunk sizes
+ * like the player thread and an audio callback use. The consumer must see every sample exactly once and in order,
+ * only interrupted by silent chunks if it was too fast (underruns). */
+
+const size_t PUT_SIZE = 200;
+const size_t TAKE_SIZES[] = {256, 128, 256, 512};
+/* multiple of all chunk sizes, so that the consumer can take everything in the end */
+const size_t TOTAL_SAMPLES = PUT_SIZE * 512 * 40;
+
+int main()
+{
+    LowLatencyRingbuffer ringbuffer;
+
+    std::thread producer([&]() {
+        std::vector<sample> chunk(PUT_SIZE);
+        for (size_t i = 0; i < TOTAL_SAMPLES; i += PUT_SIZE) {
+            // start at 1, so silence can be told apart from the signal
+            for (size_t j = 0; j < PUT_SIZE; j++)
+                chunk[j] = sample{float(i + j + 1), -float(i + j + 1)};
+            ringbuffer.Put(chunk);
+        }
+    });
+
+    size_t received = 0;
+    size_t underruns = 0;
+    size_t errors = 0;
+    std::vector<sample> chunk;
+    for (size_t take = 0; received < TOTAL_SAMPLES; take++) {
+        chunk.resize(TAKE_SIZES[take % std::size(TAKE_SIZES)]);
+        ringbuffer.Take(chunk);
+
+        if (chunk.front().left == 0.0f) {
+            for (const sample &s : chunk)
+                errors += s.left != 0.0f || s.right != 0.0f;
+            underruns++;
+            // a real audio callback would not come back immediately either
+            std::this_thread::yield();
+            continue;
+        }
+
+        for (const sample &s : chunk) {
+            const float expected = float(++received);
+            errors += s.left != expected || s.right != -expected;
+        }
+    }
+
+    producer.join();
+
+    fmt::print("{} samples, {} underruns, {} errors\n", received, underruns, errors);
+    if (errors > 0 || received != TOTAL_SAMPLES) {
+        fmt::print("FAIL\n");
+        return EXIT_FAILURE;
+    }
+    fmt::print("OK\n");
+    return EXIT_SUCCESS;
+}
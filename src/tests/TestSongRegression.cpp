@@ -0,0 +1,445 @@
+#include "Debug.hpp"
+#include "MP2KContext.hpp"
+#include "MP2KScanner.hpp"
+#include "Resampler.hpp"
+#include "Rom.hpp"
+#include "SegmentedRenderer.hpp"
+#include "SongCheckpoints.hpp"
+#include "SyntheticRom.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fmt/core.h>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/* Renders all songs of the synthetic test ROM and compares a hash of the master output
+ * against stored golden hashes. Any change in output, however small, causes a mismatch.
+ * Every song is rendered a second time with the sample bank disabled, a third time in blocks of multiple subframes
+ * (like SoundExporter does) and a fourth time continuing from a snapshot (see MP2KSnapshot) in a new context,
+ * none of which must change the output.
+ * Last, every song is rendered in segments on multiple threads (see SegmentedRenderer). Its length has to match and
+ * its output may only differ by rounding errors in the reverb tails at the segment starts. With nativeMixRate,
+ * the reverbs are warmed up exactly, so the output has to be identical.
+ * Seeks (see SongCheckpoints) to several positions are compared with the output from there in the same way, both
+ * waiting for them (SongCheckpoints::Seek) and swapping in the prepared context like playback does (TakeSeek).
+ * All of this is repeated with AgbplaySoundMode::nativeMixRate ("<variant>+native") and
+ * AgbplaySoundMode::sharedReverb ("<variant>+sharedreverb") enabled.
+ * Render speed is reported in samples per second for each song (with sample bank).
+ *
+ * Usage: test-song-regression [--update] [golden-file]
+ * --update rewrites the golden hashes of the current variant after an intended output change.
+ *
+ * The SIMD variants and polyphase modes of the resamplers do not produce bit-identical output, so hashes are stored
+ * per variant ("<simd>/<polyphase>"). Set AGBPLAY_SIMD (e.g. AGBPLAY_SIMD=scalar) and AGBPLAY_POLYPHASE
+ * (e.g. AGBPLAY_POLYPHASE=linear) to check other variants than the default one. */
+
+#ifndef GOLDEN_FILE
+#define GOLDEN_FILE "SongRegression.golden"
+#endif
+
+const uint32_t SAMPLERATE = 48000;
+const size_t MAX_SUBFRAMES = 10 * 60 * AGB_FPS * INTERFRAMES;
+/* deliberately not a power of two, so blocks end at varying positions of the song */
+const size_t BLOCK_SUBFRAMES = 19;
+/* 2.5 seconds in, most songs have notes playing and reverb tails at that point */
+const size_t SNAPSHOT_SUBFRAME = 600;
+/* much shorter than for exports, so the songs are split up into several segments */
+const size_t SEGMENT_SUBFRAMES = 1000;
+const size_t SEGMENT_THREADS = 4;
+const float SEGMENT_TOLERANCE = 1e-5f;
+/* Targets before the end of the first warm-up, between two checkpoints and just after one. For the first one, the song
+ * is rendered from its start, the second one skips from the start, the third one from the third checkpoint. */
+const size_t SEEK_TARGETS[] = {
+    SongCheckpoints::SEEK_WARMUP / 2,
+    SongCheckpoints::CHECKPOINT_INTERVAL + SongCheckpoints::SEEK_WARMUP / 2,
+    2 * SongCheckpoints::CHECKPOINT_INTERVAL + 3 * SongCheckpoints::SEEK_WARMUP,
+};
+/* the recording is cut off between two checkpoints, so seeks beyond stop MAX_SEEK_SUBFRAMES after the last one */
+const size_t SEEK_CUT_SUBFRAMES = 2 * SongCheckpoints::CHECKPOINT_INTERVAL + SongCheckpoints::CHECKPOINT_INTERVAL / 2;
+const size_t SEEK_COMPARE_SUBFRAMES = 2 * SongCheckpoints::SEEK_WARMUP;
+
+struct SongResult
+{
+    uint64_t hash;
+    size_t samples;
+    double seconds;
+    std::vector<sample> output;
+};
+
+/* 64 bit FNV-1a */
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+static SongResult renderSong(
+    const Rom &rom,
+    const MP2KScanner::Result &scanResult,
+    uint16_t songId,
+    bool sampleBank,
+    const AgbplaySoundMode &agbplaySoundMode,
+    size_t blockSubframes,
+    bool snapshot = false,
+    bool keepOutput = false
+)
+{
+    auto makeContext = [&]() {
+        auto ctx = std::make_unique<MP2KContext>(
+            SAMPLERATE,
+            rom,
+            scanResult.mp2kSoundMode,
+            agbplaySoundMode,
+            scanResult.songTableInfo,
+            scanResult.playerTableInfo
+        );
+        ctx->mixer.SetSampleBankEnabled(sampleBank);
+        return ctx;
+    };
+    std::unique_ptr<MP2KContext> ctx = makeContext();
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    SongResult result{0xCBF29CE484222325ull, 0, 0.0, {}};
+    ctx->m4aSongNumStart(songId);
+    for (size_t i = 0; i < MAX_SUBFRAMES; i += blockSubframes) {
+        if (snapshot && i == SNAPSHOT_SUBFRAME) {
+            // continue in a new context, the old one is destroyed before the new one is used
+            MP2KSnapshot snap;
+            ctx->SaveSnapshot(snap);
+            ctx = makeContext();
+            ctx->RestoreSnapshot(snap);
+        }
+
+        const size_t maxSubframes = std::min(blockSubframes, MAX_SUBFRAMES - i);
+        size_t subframes = maxSubframes;
+        if (blockSubframes == 1) {
+            // one subframe at a time like playback
+            ctx->m4aSoundMain();
+            if (ctx->SongEnded())
+                break;
+        } else {
+            // like SoundExporter, the subframe which ended the song is not part of the block
+            subframes = ctx->m4aSoundMainBlock(maxSubframes);
+        }
+        result.hash =
+            hashBytes(result.hash, ctx->masterAudioBuffer.data(), ctx->masterAudioBuffer.size() * sizeof(sample));
+        result.samples += ctx->masterAudioBuffer.size();
+        if (keepOutput)
+            result.output.insert(result.output.end(), ctx->masterAudioBuffer.begin(), ctx->masterAudioBuffer.end());
+        if (subframes < maxSubframes)
+            break;
+    }
+
+    const auto endTime = std::chrono::steady_clock::now();
+    result.seconds = std::chrono::duration<double>(endTime - startTime).count();
+    return result;
+}
+
+static SongResult renderSongSegmented(
+    const Rom &rom, const MP2KScanner::Result &scanResult, uint16_t songId, const AgbplaySoundMode &agbplaySoundMode
+)
+{
+    SegmentedRenderer renderer(
+        SAMPLERATE,
+        rom,
+        scanResult.mp2kSoundMode,
+        agbplaySoundMode,
+        scanResult.songTableInfo,
+        scanResult.playerTableInfo
+    );
+
+    SongResult result{0xCBF29CE484222325ull, 0, 0.0, {}};
+    result.samples = renderer.Render(
+        songId, false, SEGMENT_THREADS, SEGMENT_SUBFRAMES, [&result](const SegmentedRenderer::Streams &streams) {
+            const std::vector<sample> &master = streams.at(0);
+            result.hash = hashBytes(result.hash, master.data(), master.size() * sizeof(sample));
+            result.output.insert(result.output.end(), master.begin(), master.end());
+        }
+    );
+    return result;
+}
+
+/* returns whether both outputs have the same length and differ by at most SEGMENT_TOLERANCE */
+static bool outputsClose(const std::vector<sample> &a, const std::vector<sample> &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        const float diff = std::max(std::abs(a[i].left - b[i].left), std::abs(a[i].right - b[i].right));
+        if (diff > SEGMENT_TOLERANCE)
+            return false;
+    }
+    return true;
+}
+
+static std::unique_ptr<MP2KContext> makeSeekContext(
+    const Rom &rom, const MP2KScanner::Result &scanResult, const AgbplaySoundMode &agbplaySoundMode
+)
+{
+    return std::make_unique<MP2KContext>(
+        SAMPLERATE,
+        rom,
+        scanResult.mp2kSoundMode,
+        agbplaySoundMode,
+        scanResult.songTableInfo,
+        scanResult.playerTableInfo
+    );
+}
+
+/* Renders from the position ctx was moved to and compares the output with the serial one from there, up to
+ * SEEK_COMPARE_SUBFRAMES or the end of the song. */
+static bool seekOutputClose(MP2KContext &ctx, size_t subframe, const std::vector<sample> &reference)
+{
+    const size_t samplesPerSubframe = ctx.mixer.GetSamplesPerBuffer();
+    const size_t referenceSubframes = reference.size() / samplesPerSubframe;
+    const size_t subframes = std::min(SEEK_COMPARE_SUBFRAMES, referenceSubframes - subframe);
+
+    std::vector<sample> output;
+    for (size_t i = 0; i < subframes; i++) {
+        ctx.m4aSoundMain();
+        output.insert(output.end(), ctx.masterAudioBuffer.begin(), ctx.masterAudioBuffer.end());
+    }
+
+    const auto begin = reference.begin() + static_cast<ptrdiff_t>(subframe * samplesPerSubframe);
+    return outputsClose(output, std::vector<sample>(begin, begin + static_cast<ptrdiff_t>(output.size())));
+}
+
+/* Returns a description of the first seek which went wrong, or an empty string. */
+static std::string checkSeeks(
+    const Rom &rom,
+    const MP2KScanner::Result &scanResult,
+    uint16_t songId,
+    const AgbplaySoundMode &agbplaySoundMode,
+    const std::vector<sample> &reference
+)
+{
+    const size_t referenceSubframes = reference.size() / (SAMPLERATE / (AGB_FPS * INTERFRAMES));
+    SongCheckpoints checkpoints(SAMPLERATE, rom, scanResult.songTableInfo, scanResult.playerTableInfo);
+    const uint32_t generation = checkpoints.Load(scanResult.mp2kSoundMode, agbplaySoundMode, songId);
+
+    for (const size_t target : SEEK_TARGETS) {
+        if (target >= referenceSubframes)
+            continue;
+
+        /* the checkpoints are recorded at normal speed, Seek has to keep the speed factor of ctx */
+        std::unique_ptr<MP2KContext> ctx = makeSeekContext(rom, scanResult, agbplaySoundMode);
+        ctx->reader.SetSpeedFactor(2.0f);
+        if (!checkpoints.Seek(*ctx, target))
+            return fmt::format("seek to subframe {} failed", target);
+        if (ctx->reader.GetSpeedFactor() != 2.0f)
+            return fmt::format("seek to subframe {} changed the speed factor", target);
+        ctx->reader.SetSpeedFactor(1.0f);
+        if (!seekOutputClose(*ctx, target, reference))
+            return fmt::format("output differs after seeking to subframe {}", target);
+
+        /* like playback, the speed factor and muted tracks are taken over from the context which is swapped out */
+        ctx = makeSeekContext(rom, scanResult, agbplaySoundMode);
+        ctx->reader.SetSpeedFactor(2.0f);
+        ctx->players.at(0).tracks.at(0).muted = true;
+        const MP2KContext *previousCtx = ctx.get();
+        checkpoints.RequestSeek(generation, target);
+        while (!checkpoints.TakeSeek(ctx))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (ctx.get() == previousCtx)
+            return fmt::format("prepared seek to subframe {} failed", target);
+        if (ctx->reader.GetSpeedFactor() != 2.0f || !ctx->players.at(0).tracks.at(0).muted)
+            return fmt::format("prepared seek to subframe {} did not keep the settings", target);
+        ctx->reader.SetSpeedFactor(1.0f);
+        ctx->players.at(0).tracks.at(0).muted = false;
+        if (!seekOutputClose(*ctx, target, reference))
+            return fmt::format("output differs after prepared seek to subframe {}", target);
+    }
+
+    /* requests for a previous recording are dropped */
+    {
+        std::unique_ptr<MP2KContext> ctx = makeSeekContext(rom, scanResult, agbplaySoundMode);
+        const MP2KContext *previousCtx = ctx.get();
+        checkpoints.RequestSeek(generation - 1, 0);
+        while (!checkpoints.TakeSeek(ctx))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (ctx.get() != previousCtx)
+            return "seek request for a previous recording was not dropped";
+    }
+
+    const size_t lastCheckpoint = SEEK_CUT_SUBFRAMES / SongCheckpoints::CHECKPOINT_INTERVAL
+        * SongCheckpoints::CHECKPOINT_INTERVAL;
+    const size_t cutoff = lastCheckpoint + SongCheckpoints::MAX_SEEK_SUBFRAMES;
+    if (cutoff < referenceSubframes) {
+        SongCheckpoints cutCheckpoints(
+            SAMPLERATE, rom, scanResult.songTableInfo, scanResult.playerTableInfo, SEEK_CUT_SUBFRAMES
+        );
+        cutCheckpoints.Load(scanResult.mp2kSoundMode, agbplaySoundMode, songId);
+        std::unique_ptr<MP2KContext> ctx = makeSeekContext(rom, scanResult, agbplaySoundMode);
+        if (cutCheckpoints.Seek(*ctx, referenceSubframes))
+            return "seek beyond the recording did not stop";
+        if (!seekOutputClose(*ctx, cutoff, reference))
+            return fmt::format("output differs after seek stopped at subframe {}", cutoff);
+    }
+
+    return {};
+}
+
+/* golden file format: one "<variant> <song> <hash> <samples>" entry per line, '#' starts a comment */
+static std::map<std::string, std::string> readGoldens(const std::string &path)
+{
+    std::map<std::string, std::string> goldens;
+    std::ifstream ifs(path);
+    std::string line;
+    while (std::getline(ifs, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream iss(line);
+        std::string variant, song, value;
+        iss >> variant >> song;
+        std::getline(iss >> std::ws, value);
+        goldens[variant + " " + song] = value;
+    }
+    return goldens;
+}
+
+static void writeGoldens(const std::string &path, const std::map<std::string, std::string> &goldens)
+{
+    std::ofstream ofs(path);
+    ofs << "# generated by test-song-regression --update\n";
+    ofs << "# variant song hash samples\n";
+    for (const auto &[key, value] : goldens)
+        ofs << key << " " << value << "\n";
+}
+
+int main(int argc, char *argv[])
+{
+    bool update = false;
+    std::string goldenPath = GOLDEN_FILE;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--update") == 0)
+            update = true;
+        else
+            goldenPath = argv[i];
+    }
+
+    Debug::open(nullptr);
+
+    std::vector<uint8_t> romData = SyntheticRom::Build();
+    const Rom rom = Rom::LoadFromBufferRef(romData);
+    MP2KScanner scanner(rom);
+    const auto scanResults = scanner.Scan();
+    if (scanResults.size() != 1) {
+        fmt::print("FAIL: expected 1 song table, found {}\n", scanResults.size());
+        return EXIT_FAILURE;
+    }
+    const MP2KScanner::Result &scanResult = scanResults.at(0);
+
+    const std::string variant = fmt::format(
+        "{}/{}",
+        Resampler::GetSimdName(Resampler::GetActiveSimd()),
+        Resampler::GetPolyphaseName(Resampler::GetActivePolyphase(AgbplaySoundMode{}.resamplerPolyphase))
+    );
+    std::map<std::string, std::string> goldens = readGoldens(goldenPath);
+    size_t failed = 0;
+
+    fmt::print("variant: {}, golden file: {}\n", variant, goldenPath);
+
+    AgbplaySoundMode nativeMode;
+    nativeMode.nativeMixRate = true;
+    AgbplaySoundMode sharedReverbMode;
+    sharedReverbMode.sharedReverb = true;
+
+    for (const auto &[suffix, mode] : {
+             std::pair{"", AgbplaySoundMode{}},
+             std::pair{"+native", nativeMode},
+             std::pair{"+sharedreverb", sharedReverbMode},
+         }) {
+        const std::string modeVariant = variant + suffix;
+        size_t totalSamples = 0;
+        double totalSeconds = 0.0;
+
+        fmt::print("{}:\n", modeVariant);
+
+        for (uint16_t songId = 0; songId < scanResult.songTableInfo.count; songId++) {
+            const SongResult result = renderSong(rom, scanResult, songId, true, mode, 1, false, true);
+            /* the sample bank and block rendering are pure optimizations, so output has to be identical */
+            const bool sampleBankMismatch =
+                renderSong(rom, scanResult, songId, false, mode, 1).hash != result.hash;
+            const bool blockMismatch =
+                renderSong(rom, scanResult, songId, true, mode, BLOCK_SUBFRAMES).hash != result.hash;
+            const bool snapshotMismatch = renderSong(rom, scanResult, songId, true, mode, 1, true).hash != result.hash;
+            const SongResult segmented = renderSongSegmented(rom, scanResult, songId, mode);
+            const bool segmentedMismatch = mode.nativeMixRate ? segmented.hash != result.hash
+                                                              : !outputsClose(segmented.output, result.output);
+            const std::string seekError = checkSeeks(rom, scanResult, songId, mode, result.output);
+            const std::string key = fmt::format("{} {}", modeVariant, songId);
+            const std::string value = fmt::format("{:016x} {}", result.hash, result.samples);
+            totalSamples += result.samples;
+            totalSeconds += result.seconds;
+
+            const auto golden = goldens.find(key);
+            const char *status;
+            const bool mismatch =
+                sampleBankMismatch || blockMismatch || snapshotMismatch || segmentedMismatch || !seekError.empty();
+            if (mismatch) {
+                status = "FAIL";
+                failed++;
+            } else if (update) {
+                goldens[key] = value;
+                status = "UPDATED";
+            } else if (golden == goldens.end()) {
+                status = "MISSING";
+                failed++;
+            } else if (golden->second != value) {
+                status = "FAIL";
+                failed++;
+            } else {
+                status = "OK";
+            }
+
+            fmt::print(
+                "song {:3}: {:<7} {} ({:.0f} samples per second)\n",
+                songId,
+                status,
+                value,
+                static_cast<double>(result.samples) / result.seconds
+            );
+            if (sampleBankMismatch)
+                fmt::print("          output differs with sample bank disabled\n");
+            if (blockMismatch)
+                fmt::print("          output differs when rendered in blocks\n");
+            if (snapshotMismatch)
+                fmt::print("          output differs when continued from a snapshot\n");
+            if (segmentedMismatch)
+                fmt::print("          output differs when rendered in segments\n");
+            if (!seekError.empty())
+                fmt::print("          {}\n", seekError);
+            if (!mismatch && !update && golden != goldens.end() && golden->second != value)
+                fmt::print("          expected {}\n", golden->second);
+        }
+
+        fmt::print("total: {:.0f} samples per second\n", static_cast<double>(totalSamples) / totalSeconds);
+    }
+
+    if (update)
+        writeGoldens(goldenPath, goldens);
+
+    Debug::close();
+
+    if (failed > 0) {
+        fmt::print("{} song(s) failed\n", failed);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,61 @@
+#include "TripleBuffer.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fmt/core.h>
+#include <thread>
+#include <vector>
+
+/* Publishes a sequence of states through TripleBuffer from a producer to a consumer thread. Each state is a vector
+ * filled with the same sequence number. The consumer must never see a partially written state, and sequence numbers
+ * must never go backwards. After the producer is done, the consumer must see the last state. */
+
+const size_t STATE_SIZE = 256;
+const uint64_t NUM_STATES = 1000000;
+
+int main()
+{
+    TripleBuffer<std::vector<uint64_t>> tripleBuffer;
+    tripleBuffer.Reset(std::vector<uint64_t>(STATE_SIZE, 0));
+    std::atomic<bool> producerDone = false;
+
+    std::thread producer([&]() {
+        for (uint64_t seq = 1; seq <= NUM_STATES; seq++) {
+            std::vector<uint64_t> &state = tripleBuffer.GetWriteBuffer();
+            for (uint64_t &value : state)
+                value = seq;
+            tripleBuffer.Publish();
+        }
+        producerDone = true;
+    });
+
+    uint64_t lastSeq = 0;
+    size_t updates = 0;
+    size_t errors = 0;
+    while (true) {
+        const bool done = producerDone;
+        if (tripleBuffer.Update())
+            updates++;
+
+        const std::vector<uint64_t> &state = tripleBuffer.GetReadBuffer();
+        const uint64_t seq = state.front();
+        for (uint64_t value : state)
+            errors += value != seq;
+        errors += seq < lastSeq;
+        lastSeq = seq;
+
+        if (done)
+            break;
+    }
+
+    producer.join();
+
+    fmt::print("{} states, {} updates, last state {}, {} errors\n", NUM_STATES, updates, lastSeq, errors);
+    if (errors > 0 || lastSeq != NUM_STATES) {
+        fmt::print("FAIL\n");
+        return EXIT_FAILURE;
+    }
+    fmt::print("OK\n");
+    return EXIT_SUCCESS;
+}